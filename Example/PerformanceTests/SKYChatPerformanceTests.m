@@ -0,0 +1,661 @@
+//
+//  SKYChatPerformanceTests.m
+//  SKYKitChatPerformanceTests
+//
+//
+//  Copyright 2016 Oursky Ltd.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+//
+
+#import "SKYChatCacheController+Private.h"
+#import "SKYChatCacheController.h"
+#import "SKYChatCacheRealmStore+Private.h"
+#import "SKYChatExtension.h"
+#import "SKYChatExtension_Private.h"
+#import "SKYChatLatencyHistogram.h"
+#import "SKYChatMessagesResponseDecoder.h"
+#import "SKYChatSearchTokenizer.h"
+
+#import "SKYMessageCacheObject.h"
+
+#import <SKYKitChat/SKYKitChat-Swift.h>
+#import <mach/mach.h>
+
+/**
+ *  Budgets of the benchmarks below, measured against the reference dataset.
+ *
+ *  Durations are in seconds, memory is in megabytes, overheads are ratios of an encrypted
+ *  store to a plain store and stalls are counted in frames. A benchmark fails when
+ *  its measurement exceeds the budget multiplied by the tolerance. Run with
+ *  SKYCHAT_BENCHMARK_RECORD=1 to log the measurements without failing, and copy
+ *  them here when a change is expected to move a baseline.
+ *
+ *  The budgets are measured in the Release configuration, which the
+ *  SKYKitChat-Performance scheme uses to run this target.
+ */
+static NSDictionary<NSString *, NSNumber *> *SKYChatBenchmarkBaselines(void)
+{
+    return @{
+        @"setMessages" : @3.0,
+        @"fetchPage.p95" : @0.015,
+        @"messageRecord" : @0.6,
+        @"decodeResponse" : @0.8,
+        @"MessageList.merge" : @0.8,
+        @"prefetch.stallFrames" : @0,
+        @"search.index" : @60,
+        @"search.p95" : @0.25,
+        @"pubsub.create" : @1.5,
+        @"peakMemory" : @64,
+        @"encryption.writeOverhead" : @1.3,
+        @"encryption.readOverhead" : @1.3,
+    };
+}
+
+static double const SKYChatBenchmarkDefaultTolerance = 1.5;
+static NSInteger const SKYChatBenchmarkIterations = 5;
+static NSInteger const SKYChatBenchmarkConversationCount = 20;
+static NSInteger const SKYChatBenchmarkMessagesPerConversation = 250;
+static NSInteger const SKYChatBenchmarkPageSize = 50;
+static NSInteger const SKYChatBenchmarkPubsubEventCount = 1000;
+static NSInteger const SKYChatBenchmarkSearchMessageCount = 100000;
+static uint64_t const SKYChatBenchmarkSeed = 20171201;
+
+static NSString *SKYChatBenchmarkEnvironment(NSString *name)
+{
+    return [[NSProcessInfo processInfo] environment][name];
+}
+
+static BOOL SKYChatBenchmarkIsRecording(void)
+{
+    return [SKYChatBenchmarkEnvironment(@"SKYCHAT_BENCHMARK_RECORD") boolValue];
+}
+
+static double SKYChatBenchmarkLimit(NSString *name)
+{
+    NSString *tolerance = SKYChatBenchmarkEnvironment(@"SKYCHAT_BENCHMARK_TOLERANCE");
+    double factor = tolerance ? [tolerance doubleValue] : SKYChatBenchmarkDefaultTolerance;
+    if (SKYChatBenchmarkIsRecording()) {
+        factor = HUGE_VAL;
+    }
+    return [SKYChatBenchmarkBaselines()[name] doubleValue] * factor;
+}
+
+static void SKYChatBenchmarkReport(NSString *name, double value)
+{
+    NSLog(@"Benchmark %@: %.4f (baseline %.4f)", name, value,
+          [SKYChatBenchmarkBaselines()[name] doubleValue]);
+}
+
+static double SKYChatBenchmarkMedian(NSArray<NSNumber *> *values)
+{
+    NSArray<NSNumber *> *sorted = [values sortedArrayUsingSelector:@selector(compare:)];
+    return [sorted[sorted.count / 2] doubleValue];
+}
+
+static double SKYChatBenchmarkMemoryFootprint(void)
+{
+    task_vm_info_data_t info;
+    mach_msg_type_number_t count = TASK_VM_INFO_COUNT;
+    if (task_info(mach_task_self(), TASK_VM_INFO, (task_info_t)&info, &count) != KERN_SUCCESS) {
+        return 0;
+    }
+    return info.phys_footprint / (1024.0 * 1024.0);
+}
+
+/**
+ *  Generates messages for N conversations × M messages with a mix of plain text, image and
+ *  file messages. The same seed always produces the same dataset so that measurements can be
+ *  compared across runs.
+ */
+@interface SKYChatBenchmarkDataset : NSObject
+
+@property (nonatomic, readonly) NSArray<NSString *> *conversationIDs;
+@property (nonatomic, readonly) NSArray<SKYMessage *> *messages;
+
+- (instancetype)initWithConversationCount:(NSInteger)conversationCount
+                  messagesPerConversation:(NSInteger)messagesPerConversation
+                                     seed:(uint64_t)seed;
+
+- (NSArray<SKYMessage *> *)messagesInConversationWithID:(NSString *)conversationID;
+
+- (NSArray<NSDictionary *> *)createEventDictionariesWithCount:(NSInteger)count;
+
+@end
+
+@implementation SKYChatBenchmarkDataset {
+    uint64_t randomState;
+    NSMutableDictionary<NSString *, NSMutableArray<SKYMessage *> *> *messagesByConversation;
+}
+
+- (instancetype)initWithConversationCount:(NSInteger)conversationCount
+                  messagesPerConversation:(NSInteger)messagesPerConversation
+                                     seed:(uint64_t)seed
+{
+    if ((self = [super init])) {
+        randomState = seed ?: 1;
+        messagesByConversation = [NSMutableDictionary dictionary];
+
+        NSMutableArray<NSString *> *conversationIDs =
+            [NSMutableArray arrayWithCapacity:conversationCount];
+        for (NSInteger i = 0; i < conversationCount; i++) {
+            NSString *conversationID = [NSString stringWithFormat:@"c%ld", (long)i];
+            [conversationIDs addObject:conversationID];
+            messagesByConversation[conversationID] = [NSMutableArray array];
+        }
+
+        NSMutableArray<SKYMessage *> *messages =
+            [NSMutableArray arrayWithCapacity:conversationCount * messagesPerConversation];
+        for (NSInteger i = 0; i < conversationCount * messagesPerConversation; i++) {
+            NSString *conversationID = conversationIDs[i % conversationCount];
+            SKYMessage *message =
+                [self messageWithName:[NSString stringWithFormat:@"m%ld", (long)i]
+                       conversationID:conversationID
+                                  seq:i / conversationCount];
+            [messages addObject:message];
+            [messagesByConversation[conversationID] addObject:message];
+        }
+
+        _conversationIDs = [conversationIDs copy];
+        _messages = [messages copy];
+    }
+    return self;
+}
+
+- (uint32_t)nextRandom
+{
+    // xorshift64*, so that the dataset does not depend on the platform random generator
+    randomState ^= randomState >> 12;
+    randomState ^= randomState << 25;
+    randomState ^= randomState >> 27;
+    return (uint32_t)((randomState * 2685821657736338717ULL) >> 32);
+}
+
+- (NSString *)randomBody
+{
+    static NSArray<NSString *> *words = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        words = @[
+            @"hello", @"meeting", @"tomorrow", @"lunch", @"project", @"deadline", @"photo",
+            @"please", @"review", @"thanks", @"café", @"東京", @"見面", @"weekend", @"release",
+        ];
+    });
+
+    NSInteger wordCount = 3 + [self nextRandom] % 40;
+    NSMutableArray<NSString *> *body = [NSMutableArray arrayWithCapacity:wordCount];
+    for (NSInteger i = 0; i < wordCount; i++) {
+        [body addObject:words[[self nextRandom] % words.count]];
+    }
+    return [body componentsJoinedByString:@" "];
+}
+
+- (SKYMessage *)messageWithName:(NSString *)name
+                 conversationID:(NSString *)conversationID
+                            seq:(NSInteger)seq
+{
+    SKYMessage *message = [[SKYMessage alloc]
+        initWithRecordData:[SKYRecord recordWithRecordType:@"message" name:name]];
+    message.conversationRef = [SKYReference
+        referenceWithRecordID:[SKYRecordID recordIDWithRecordType:@"conversation"
+                                                             name:conversationID]];
+    message.creationDate = [NSDate dateWithTimeIntervalSince1970:1500000000 + seq * 60];
+    message.record[@"seq"] = @(seq);
+    message.body = [self randomBody];
+
+    // 70% text, 20% image with an inline thumbnail, 10% file
+    uint32_t kind = [self nextRandom] % 10;
+    if (kind >= 7) {
+        BOOL isImage = kind < 9;
+        SKYAsset *asset = [SKYAsset
+            assetWithName:[NSString stringWithFormat:@"%@-%@", name, isImage ? @"img" : @"file"]
+                      url:[NSURL URLWithString:@"https://example.com/asset"]];
+        asset.mimeType = isImage ? @"image/jpeg" : @"application/pdf";
+        asset.fileSize = @(10000 + [self nextRandom] % 2000000);
+        message.attachment = asset;
+
+        if (isImage) {
+            message.metadata = @{
+                @"width" : @(640 + [self nextRandom] % 1000),
+                @"height" : @(480 + [self nextRandom] % 1000),
+                @"thumbnail" : [@"" stringByPaddingToLength:2048
+                                                 withString:@"/9j/"
+                                            startingAtIndex:0],
+            };
+        }
+    }
+    return message;
+}
+
+- (NSArray<SKYMessage *> *)messagesInConversationWithID:(NSString *)conversationID
+{
+    return [messagesByConversation[conversationID] copy];
+}
+
+- (NSArray<NSDictionary *> *)createEventDictionariesWithCount:(NSInteger)count
+{
+    SKYRecordSerializer *serializer = [SKYRecordSerializer serializer];
+    NSMutableArray<NSDictionary *> *events = [NSMutableArray arrayWithCapacity:count];
+    for (NSInteger i = 0; i < count; i++) {
+        NSString *conversationID = self.conversationIDs[i % self.conversationIDs.count];
+        SKYMessage *message = [self messageWithName:[NSString stringWithFormat:@"p%ld", (long)i]
+                                     conversationID:conversationID
+                                                seq:100000 + i];
+        [events addObject:@{
+            @"event" : @"create",
+            @"data" : @{
+                @"record_type" : @"message",
+                @"record" : [serializer dictionaryWithRecord:message.record],
+            },
+        }];
+    }
+    return events;
+}
+
+@end
+
+@interface SKYChatExtension ()
+
+- (void)handleUserChannelDictionary:(NSDictionary<NSString *, id> *)dict;
+
+@end
+
+SpecBegin(SKYChatPerformance)
+
+    describe(@"Benchmark", ^{
+        __block SKYChatBenchmarkDataset *dataset = nil;
+        __block SKYChatCacheRealmStore *store = nil;
+        __block RLMRealm *realm = nil;
+
+        beforeAll(^{
+            dataset = [[SKYChatBenchmarkDataset alloc]
+                initWithConversationCount:SKYChatBenchmarkConversationCount
+                  messagesPerConversation:SKYChatBenchmarkMessagesPerConversation
+                                     seed:SKYChatBenchmarkSeed];
+        });
+
+        beforeEach(^{
+            store = [[SKYChatCacheRealmStore alloc] initInMemoryWithName:@"ChatBenchmark"];
+            // Keep a reference so that the in-memory realm survives between accesses
+            realm = store.realmInstance;
+        });
+
+        afterEach(^{
+            [realm transactionWithBlock:^{
+                [realm deleteAllObjects];
+            }];
+            realm = nil;
+            store = nil;
+        });
+
+        void (^writeDataset)(void) = ^{
+            for (NSString *conversationID in dataset.conversationIDs) {
+                [store setMessages:[dataset messagesInConversationWithID:conversationID]];
+            }
+        };
+
+        it(@"setMessages write throughput", ^{
+            NSMutableArray<NSNumber *> *durations = [NSMutableArray array];
+            for (NSInteger i = 0; i < SKYChatBenchmarkIterations; i++) {
+                [realm transactionWithBlock:^{
+                    [realm deleteAllObjects];
+                }];
+
+                NSDate *startDate = [NSDate date];
+                writeDataset();
+                [durations addObject:@(-[startDate timeIntervalSinceNow])];
+            }
+
+            double duration = SKYChatBenchmarkMedian(durations);
+            SKYChatBenchmarkReport(@"setMessages", duration);
+            NSLog(@"Benchmark setMessages: %.0f messages/s", dataset.messages.count / duration);
+            expect([SKYMessageCacheObject allObjectsInRealm:realm].count)
+                .to.equal(dataset.messages.count);
+            expect(duration).to.beLessThanOrEqualTo(SKYChatBenchmarkLimit(@"setMessages"));
+        });
+
+        it(@"page fetch latency", ^{
+            writeDataset();
+            SKYChatCacheController *cacheController =
+                [[SKYChatCacheController alloc] initWithStore:store];
+            SKYChatLatencyHistogram *histogram = [[SKYChatLatencyHistogram alloc] init];
+
+            for (NSString *conversationID in dataset.conversationIDs) {
+                __block NSDate *beforeTime = nil;
+                __block NSUInteger pageCount = 0;
+                do {
+                    NSDate *startDate = [NSDate date];
+                    [cacheController
+                        fetchMessagesWithConversationID:conversationID
+                                                  limit:SKYChatBenchmarkPageSize
+                                             beforeTime:beforeTime
+                                                  order:nil
+                                             completion:^(NSArray<SKYMessage *> *messages,
+                                                          BOOL isCached, NSError *error) {
+                                                 pageCount = messages.count;
+                                                 beforeTime = messages.lastObject.creationDate;
+                                             }];
+                    [histogram recordValue:-[startDate timeIntervalSinceNow]];
+                } while (pageCount == SKYChatBenchmarkPageSize);
+            }
+
+            double latency = [histogram valueAtPercentile:95];
+            SKYChatBenchmarkReport(@"fetchPage.p95", latency);
+            expect(histogram.count).to.beGreaterThan(0);
+            expect(latency).to.beLessThanOrEqualTo(SKYChatBenchmarkLimit(@"fetchPage.p95"));
+        });
+
+        it(@"messageRecord decode cost", ^{
+            writeDataset();
+            RLMResults<SKYMessageCacheObject *> *cacheObjects =
+                [SKYMessageCacheObject allObjectsInRealm:realm];
+
+            NSMutableArray<NSNumber *> *durations = [NSMutableArray array];
+            for (NSInteger i = 0; i < SKYChatBenchmarkIterations; i++) {
+                NSDate *startDate = [NSDate date];
+                @autoreleasepool {
+                    for (SKYMessageCacheObject *cacheObject in cacheObjects) {
+                        [cacheObject messageRecord];
+                    }
+                }
+                [durations addObject:@(-[startDate timeIntervalSinceNow])];
+            }
+
+            double duration = SKYChatBenchmarkMedian(durations);
+            SKYChatBenchmarkReport(@"messageRecord", duration);
+            expect(duration).to.beLessThanOrEqualTo(SKYChatBenchmarkLimit(@"messageRecord"));
+        });
+
+        it(@"response decode cost", ^{
+            SKYRecordSerializer *serializer = [SKYRecordSerializer serializer];
+            NSMutableArray<NSDictionary *> *dictionaries =
+                [NSMutableArray arrayWithCapacity:dataset.messages.count];
+            for (SKYMessage *message in dataset.messages) {
+                [dictionaries addObject:[serializer dictionaryWithRecord:message.record]];
+            }
+
+            SKYChatMessagesResponseDecoder *decoder = [[SKYChatMessagesResponseDecoder alloc] init];
+            NSMutableArray<NSNumber *> *durations = [NSMutableArray array];
+            for (NSInteger i = 0; i < SKYChatBenchmarkIterations; i++) {
+                NSDate *startDate = [NSDate date];
+                @autoreleasepool {
+                    NSArray<SKYMessage *> *messages =
+                        [decoder messagesWithDictionaries:dictionaries];
+                    expect(messages).to.haveLength(dictionaries.count);
+                }
+                [durations addObject:@(-[startDate timeIntervalSinceNow])];
+            }
+
+            double duration = SKYChatBenchmarkMedian(durations);
+            SKYChatBenchmarkReport(@"decodeResponse", duration);
+            expect(duration).to.beLessThanOrEqualTo(SKYChatBenchmarkLimit(@"decodeResponse"));
+        });
+
+        it(@"MessageList merge cost", ^{
+            // Merge older pages into a long conversation, as the conversation view does when
+            // scrolling back through history.
+            NSArray<SKYMessage *> *history =
+                [[dataset.messages reverseObjectEnumerator] allObjects];
+
+            NSMutableArray<NSNumber *> *durations = [NSMutableArray array];
+            for (NSInteger i = 0; i < SKYChatBenchmarkIterations; i++) {
+                MessageList *messageList = [[MessageList alloc] init];
+                NSDate *startDate = [NSDate date];
+                for (NSUInteger location = 0; location < history.count;
+                     location += SKYChatBenchmarkPageSize) {
+                    NSRange range = NSMakeRange(
+                        location, MIN(SKYChatBenchmarkPageSize, history.count - location));
+                    [messageList merge:[history subarrayWithRange:range]];
+                }
+                [durations addObject:@(-[startDate timeIntervalSinceNow])];
+                expect(messageList.count).to.equal(history.count);
+            }
+
+            double duration = SKYChatBenchmarkMedian(durations);
+            SKYChatBenchmarkReport(@"MessageList.merge", duration);
+            expect(duration).to.beLessThanOrEqualTo(SKYChatBenchmarkLimit(@"MessageList.merge"));
+        });
+
+        it(@"search over a large cache", ^{
+            // Index a cache much larger than the reference dataset, then search it for common
+            // words and CJK text, in all conversations and in a single conversation.
+            SKYChatBenchmarkDataset *searchDataset = [[SKYChatBenchmarkDataset alloc]
+                initWithConversationCount:SKYChatBenchmarkSearchMessageCount /
+                                          SKYChatBenchmarkMessagesPerConversation
+                  messagesPerConversation:SKYChatBenchmarkMessagesPerConversation
+                                     seed:SKYChatBenchmarkSeed];
+
+            NSDate *startDate = [NSDate date];
+            for (NSString *conversationID in searchDataset.conversationIDs) {
+                @autoreleasepool {
+                    [store setMessages:[searchDataset messagesInConversationWithID:conversationID]];
+                }
+            }
+            double indexDuration = -[startDate timeIntervalSinceNow];
+
+            NSArray<NSString *> *queries = @[
+                @"meeting", @"lunch project", @"café", @"東京 見面", @"京",
+                @"release deadline thanks"
+            ];
+            SKYChatLatencyHistogram *histogram = [[SKYChatLatencyHistogram alloc] init];
+            for (NSInteger i = 0; i < SKYChatBenchmarkIterations; i++) {
+                for (NSString *query in queries) {
+                    NSArray<NSString *> *terms = [SKYChatSearchTokenizer termsWithText:query];
+                    // An empty ID searches in all conversations.
+                    for (NSString *conversationID in @[ @"", searchDataset.conversationIDs[i] ]) {
+                        @autoreleasepool {
+                            startDate = [NSDate date];
+                            NSArray<SKYMessage *> *results = [store
+                                searchMessagesWithTerms:terms
+                                         conversationID:conversationID.length ? conversationID
+                                                                              : nil
+                                                  limit:SKYChatBenchmarkPageSize];
+                            [histogram recordValue:-[startDate timeIntervalSinceNow]];
+                            expect(results.count).to.beGreaterThan(0);
+                        }
+                    }
+                }
+            }
+
+            double latency = [histogram valueAtPercentile:95];
+            SKYChatBenchmarkReport(@"search.index", indexDuration);
+            SKYChatBenchmarkReport(@"search.p95", latency);
+            expect(indexDuration).to.beLessThanOrEqualTo(SKYChatBenchmarkLimit(@"search.index"));
+            expect(latency).to.beLessThanOrEqualTo(SKYChatBenchmarkLimit(@"search.p95"));
+        });
+
+        it(@"prefetch while flinging", ^{
+            // Fling through the whole history frame by frame on a virtual clock, with a cold
+            // cache and every server page arriving after a fixed latency. A frame stalls when the
+            // list has reached the top while older messages are still to be shown.
+            NSArray<SKYMessage *> *history =
+                [[dataset.messages reverseObjectEnumerator] allObjects];
+            NSMutableDictionary<NSString *, NSNumber *> *indexByRecordName =
+                [NSMutableDictionary dictionary];
+            [history enumerateObjectsUsingBlock:^(SKYMessage *message, NSUInteger idx, BOOL *stop) {
+                indexByRecordName[message.recordName] = @(idx);
+            }];
+
+            CGFloat const rowHeight = 60;
+            CGFloat const viewportHeight = 600;
+            CGFloat const velocity = -6000;
+            NSTimeInterval const frameDuration = 1.0 / 60;
+            NSTimeInterval const latency = 0.3;
+
+            __block NSTimeInterval now = 0;
+            NSMutableArray<NSArray *> *pendingResponses = [NSMutableArray array];
+            SKYChatMessagePagePrefetcher *prefetcher = [[SKYChatMessagePagePrefetcher alloc]
+                initWithPageSize:SKYChatBenchmarkPageSize
+                         fetcher:^(SKYMessage *before, NSInteger limit,
+                                   void (^completion)(NSArray<SKYMessage *> *, BOOL, NSError *)) {
+                             NSNumber *beforeIndex =
+                                 before ? indexByRecordName[before.recordName] : nil;
+                             NSUInteger location =
+                                 beforeIndex ? beforeIndex.unsignedIntegerValue + 1 : 0;
+                             NSRange range = NSMakeRange(
+                                 location, MIN((NSUInteger)limit, history.count - location));
+                             NSArray<SKYMessage *> *page = [history subarrayWithRange:range];
+                             completion(@[], YES, nil);
+                             [pendingResponses addObject:@[
+                                 @(now + latency), [^{
+                                     completion(page, NO, nil);
+                                 } copy]
+                             ]];
+                         }];
+
+            NSUInteger shownCount = SKYChatBenchmarkPageSize;
+            SKYMessage *oldestMessage = history[shownCount - 1];
+            CGFloat offsetY = shownCount * rowHeight - viewportHeight;
+            NSInteger stallFrames = 0;
+            while (shownCount < history.count && now < 60) {
+                now += frameDuration;
+                while (pendingResponses.count && [pendingResponses[0][0] doubleValue] <= now) {
+                    void (^response)(void) = pendingResponses[0][1];
+                    [pendingResponses removeObjectAtIndex:0];
+                    response();
+                }
+
+                offsetY = MAX(0, offsetY + velocity * frameDuration);
+                [prefetcher scrollViewDidScrollWithOffsetY:offsetY timestamp:now];
+                [prefetcher prefetchIfNeededWithDistanceToTop:offsetY oldestMessage:oldestMessage];
+
+                SKYChatPrefetchedMessagePage *page =
+                    [prefetcher dequeuePageWithDistanceToTop:offsetY];
+                if (page) {
+                    // the inserted page keeps the shown messages in place, as the view does
+                    CGFloat insertedHeight = page.messages.count * rowHeight;
+                    shownCount += page.messages.count;
+                    [prefetcher contentOffsetDidShiftBy:insertedHeight];
+                    offsetY += insertedHeight;
+                    oldestMessage = page.messages.lastObject;
+                } else if (offsetY == 0) {
+                    stallFrames++;
+                }
+            }
+
+            expect(shownCount).to.equal(history.count);
+            SKYChatBenchmarkReport(@"prefetch.stallFrames", stallFrames);
+            expect(stallFrames)
+                .to.beLessThanOrEqualTo(SKYChatBenchmarkLimit(@"prefetch.stallFrames"));
+        });
+
+        it(@"pubsub event handling rate", ^{
+            SKYChatCacheController *cacheController =
+                [[SKYChatCacheController alloc] initWithStore:store];
+            [SKYContainer defaultContainer].endPointAddress =
+                [NSURL URLWithString:@"https://test.skygeario.com/"];
+            SKYChatExtension *chatExtension =
+                [[SKYChatExtension alloc] initWithContainer:[SKYContainer defaultContainer]
+                                            cacheController:cacheController];
+            NSArray<NSDictionary *> *events =
+                [dataset createEventDictionariesWithCount:SKYChatBenchmarkPubsubEventCount];
+
+            NSDate *startDate = [NSDate date];
+            for (NSDictionary *event in events) {
+                [chatExtension handleUserChannelDictionary:event];
+            }
+            NSTimeInterval duration = -[startDate timeIntervalSinceNow];
+
+            SKYChatBenchmarkReport(@"pubsub.create", duration);
+            NSLog(@"Benchmark pubsub.create: %.0f events/s", events.count / duration);
+            expect([SKYMessageCacheObject allObjectsInRealm:realm].count).to.equal(events.count);
+            expect(duration).to.beLessThanOrEqualTo(SKYChatBenchmarkLimit(@"pubsub.create"));
+        });
+
+        it(@"peak memory", ^{
+            double baseFootprint = SKYChatBenchmarkMemoryFootprint();
+            __block double peakFootprint = baseFootprint;
+            void (^sample)(void) = ^{
+                peakFootprint = MAX(peakFootprint, SKYChatBenchmarkMemoryFootprint());
+            };
+
+            for (NSString *conversationID in dataset.conversationIDs) {
+                @autoreleasepool {
+                    [store setMessages:[dataset messagesInConversationWithID:conversationID]];
+                }
+                sample();
+            }
+            for (NSString *conversationID in dataset.conversationIDs) {
+                @autoreleasepool {
+                    NSPredicate *predicate =
+                        [NSPredicate predicateWithFormat:@"conversationID == %@", conversationID];
+                    [store getMessagesWithPredicate:predicate limit:-1 order:@"creationDate"];
+                    sample();
+                }
+            }
+
+            double growth = peakFootprint - baseFootprint;
+            SKYChatBenchmarkReport(@"peakMemory", growth);
+            expect(growth).to.beLessThanOrEqualTo(SKYChatBenchmarkLimit(@"peakMemory"));
+        });
+
+        it(@"encryption overhead", ^{
+            NSMutableData *encryptionKey = [NSMutableData dataWithLength:64];
+            memset(encryptionKey.mutableBytes, 0x2a, encryptionKey.length);
+
+            // Measures writing the dataset and reading every conversation back, on disk.
+            NSArray<NSNumber *> * (^measure)(NSData *) = ^NSArray<NSNumber *> *(NSData *key)
+            {
+                SKYChatCacheRealmStore *diskStore =
+                    [[SKYChatCacheRealmStore alloc] initWithName:@"ChatBenchmarkEncryption"
+                                                   encryptionKey:key];
+                NSTimeInterval writeDuration = 0;
+                NSTimeInterval readDuration = 0;
+                @autoreleasepool {
+                    RLMRealm *diskRealm = diskStore.realmInstance;
+
+                    NSDate *startDate = [NSDate date];
+                    for (NSString *conversationID in dataset.conversationIDs) {
+                        [diskStore
+                            setMessages:[dataset messagesInConversationWithID:conversationID]];
+                    }
+                    writeDuration = -[startDate timeIntervalSinceNow];
+
+                    startDate = [NSDate date];
+                    for (NSString *conversationID in dataset.conversationIDs) {
+                        NSPredicate *predicate = [NSPredicate
+                            predicateWithFormat:@"conversationID == %@", conversationID];
+                        [diskStore getMessagesWithPredicate:predicate
+                                                      limit:-1
+                                                      order:@"creationDate"];
+                    }
+                    readDuration = -[startDate timeIntervalSinceNow];
+
+                    diskRealm = nil;
+                }
+                [diskStore deleteFilesInBackground];
+                return @[ @(writeDuration), @(readDuration) ];
+            };
+
+            NSMutableArray<NSNumber *> *writeOverheads = [NSMutableArray array];
+            NSMutableArray<NSNumber *> *readOverheads = [NSMutableArray array];
+            for (NSInteger i = 0; i < SKYChatBenchmarkIterations; i++) {
+                NSArray<NSNumber *> *plain = measure(nil);
+                NSArray<NSNumber *> *encrypted = measure(encryptionKey);
+                [writeOverheads addObject:@(encrypted[0].doubleValue / plain[0].doubleValue)];
+                [readOverheads addObject:@(encrypted[1].doubleValue / plain[1].doubleValue)];
+            }
+
+            double writeOverhead = SKYChatBenchmarkMedian(writeOverheads);
+            double readOverhead = SKYChatBenchmarkMedian(readOverheads);
+            SKYChatBenchmarkReport(@"encryption.writeOverhead", writeOverhead);
+            SKYChatBenchmarkReport(@"encryption.readOverhead", readOverhead);
+            expect(writeOverhead)
+                .to.beLessThanOrEqualTo(SKYChatBenchmarkLimit(@"encryption.writeOverhead"));
+            expect(readOverhead)
+                .to.beLessThanOrEqualTo(SKYChatBenchmarkLimit(@"encryption.readOverhead"));
+        });
+    });
+
+SpecEnd
@@ -29,13 +29,29 @@ class CurrentUserUnreadCountViewController: UITableViewController {
     var unreadConversationCount: Int?
     var unreadMessageCount: Int?
 
+    var unreadCountObserver: Any?
+
     // MARK: - Lifecycle
 
     override func viewDidLoad() {
         super.viewDidLoad()
 
-        // SDK should implement get total unread
-        SKYContainer.default().chatExtension?.fetchTotalUnreadCount { (response, error) in
+        guard let chatExtension = SKYContainer.default().chatExtension else {
+            return
+        }
+
+        // The unread count is maintained locally by the chat extension, so there is no
+        // need to fetch it again when it changes.
+        self.unreadCountObserver = chatExtension.subscribeToUnreadCount { [weak self] (count, _) in
+            self?.updateUnreadCount(count)
+        }
+
+        if let count = chatExtension.cachedTotalUnreadCount() {
+            self.updateUnreadCount(count)
+            return
+        }
+
+        chatExtension.fetchTotalUnreadCount { (response, error) in
             if let err = error {
                 let alert = UIAlertController(title: "Unable to get unread count", message: err.localizedDescription, preferredStyle: .alert)
                 alert.addAction(UIAlertAction(title: "OK", style: .default, handler: nil))
@@ -44,15 +60,24 @@ class CurrentUserUnreadCountViewController: UITableViewController {
             }
 
             if let resp = response {
-                self.unreadConversationCount = resp[SKYChatConversationUnreadCountKey] as? Int
-                self.unreadMessageCount = resp[SKYChatMessageUnreadCountKey] as? Int
-
-                self.tableView.reloadData()
+                self.updateUnreadCount(resp)
             }
+        }
+    }
 
+    deinit {
+        if let observer = self.unreadCountObserver {
+            SKYContainer.default().chatExtension?.unsubscribeToUnreadCount(withObserver: observer)
         }
     }
 
+    func updateUnreadCount(_ count: [String: NSNumber]) {
+        self.unreadConversationCount = count[SKYChatConversationUnreadCountKey]?.intValue
+        self.unreadMessageCount = count[SKYChatMessageUnreadCountKey]?.intValue
+
+        self.tableView.reloadData()
+    }
+
     // MARK: - Table view data source
 
     override func numberOfSections(in tableView: UITableView) -> Int {
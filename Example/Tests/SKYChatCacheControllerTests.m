@@ -19,11 +19,16 @@
 
 #import "SKYChatCacheController+Private.h"
 #import "SKYChatCacheController.h"
+#import "SKYChatCacheLiveQuery+Private.h"
 #import "SKYChatCacheRealmStore+Private.h"
 #import "SKYChatRecordChange_Private.h"
+#import "SKYChatSearchTokenizer.h"
+
+#import "SKYConversation.h"
 
 #import "SKYMessageCacheObject.h"
 #import "SKYMessageOperationCacheObject.h"
+#import "SKYMessageSearchTermCacheObject.h"
 
 SpecBegin(SKYChatCacheController)
 
@@ -93,6 +98,74 @@ SpecBegin(SKYChatCacheController)
                                      }];
         });
 
+        it(@"fetch message by afterMessage", ^{
+            [cacheController
+                fetchMessagesWithConversationID:@"c1"
+                                          limit:2
+                                 afterMessageID:@"m3"
+                                          order:nil
+                                     completion:^(NSArray<SKYMessage *> *_Nullable messageList,
+                                                  BOOL isCached, NSError *_Nullable error) {
+                                         expect(messageList).to.haveLength(2);
+                                         expect(messageList[0].seq).to.equal(7);
+                                         expect(messageList[1].seq).to.equal(5);
+                                     }];
+        });
+
+        it(@"fetch message by aroundMessage", ^{
+            [cacheController
+                fetchMessagesWithConversationID:@"c1"
+                                          limit:3
+                                aroundMessageID:@"m5"
+                                          order:nil
+                                     completion:^(NSArray<SKYMessage *> *_Nullable messageList,
+                                                  BOOL isCached, NSError *_Nullable error) {
+                                         expect(messageList).to.haveLength(3);
+                                         expect(messageList[0].seq).to.equal(7);
+                                         expect(messageList[1].seq).to.equal(5);
+                                         expect(messageList[2].seq).to.equal(3);
+                                     }];
+        });
+
+        it(@"tell whether message is cached", ^{
+            expect([cacheController hasMessageWithID:@"m3"]).to.beTruthy();
+            expect([cacheController hasMessageWithID:@"m99"]).to.beFalsy();
+
+            SKYMessage *deletedMessage = [[SKYMessage alloc]
+                initWithRecordData:[SKYRecord recordWithRecordType:@"message"
+                                                              name:@"m3"
+                                                              data:@{
+                                                                  @"deleted" : @YES
+                                                              }]];
+            deletedMessage.conversationRef = [SKYReference
+                referenceWithRecordID:[SKYRecordID recordIDWithRecordType:@"conversation"
+                                                                     name:@"c1"]];
+            [cacheController didFetchMessages:@[] deletedMessages:@[ deletedMessage ]];
+            expect([cacheController hasMessageWithID:@"m3"]).to.beFalsy();
+        });
+
+        it(@"fetch no message around uncached message", ^{
+            __block NSInteger completionCount = 0;
+            void (^completion)(NSArray<SKYMessage *> *, BOOL, NSError *) =
+                ^(NSArray<SKYMessage *> *_Nullable messageList, BOOL isCached,
+                  NSError *_Nullable error) {
+                    expect(messageList).to.haveLength(0);
+                    expect(isCached).to.beTruthy();
+                    completionCount++;
+                };
+            [cacheController fetchMessagesWithConversationID:@"c1"
+                                                       limit:2
+                                              afterMessageID:@"m99"
+                                                       order:nil
+                                                  completion:completion];
+            [cacheController fetchMessagesWithConversationID:@"c1"
+                                                       limit:3
+                                             aroundMessageID:@"m99"
+                                                       order:nil
+                                                  completion:completion];
+            expect(completionCount).to.equal(2);
+        });
+
         it(@"store insert new record for new record id", ^{
             SKYChatCacheRealmStore *store = cacheController.store;
 
@@ -554,6 +627,47 @@ describe(@"Cache Controller handle message operations", ^{
         expect(operationInStore.error).to.equal(error);
     });
 
+    it(@"record results of a batch of messages", ^{
+        RLMRealm *realm = cacheController.store.realmInstance;
+
+        SKYRecordID *conversationID = [SKYRecordID recordIDWithRecordType:@"conversation"];
+        SKYMessage *message1 = [SKYMessage message];
+        message1.conversationRef = [SKYReference referenceWithRecordID:conversationID];
+        SKYMessage *message2 = [SKYMessage message];
+        message2.conversationRef = [SKYReference referenceWithRecordID:conversationID];
+
+        NSArray<SKYMessageOperation *> *operations =
+            [cacheController didStartMessages:@[ message1, message2 ]
+                               conversationID:conversationID.recordName
+                                operationType:SKYMessageOperationTypeAdd];
+        expect(operations.count).to.equal(2);
+        expect(operations[0].message.recordID).to.equal(message1.recordID);
+        expect(operations[1].message.recordID).to.equal(message2.recordID);
+        expect([SKYMessageOperationCacheObject allObjectsInRealm:realm].count).to.equal(2);
+
+        NSError *error = [NSError errorWithDomain:NSGenericException code:10000 userInfo:nil];
+        [cacheController didSaveMessages:@[ message1 ]
+              completedMessageOperations:@[ operations[0] ]
+                 failedMessageOperations:@[ operations[1] ]
+                                  errors:@[ error ]];
+        expect(operations[0].status).to.equal(SKYMessageOperationStatusSuccess);
+        expect(operations[1].status).to.equal(SKYMessageOperationStatusFailed);
+
+        expect([SKYMessageOperationCacheObject objectInRealm:realm
+                                               forPrimaryKey:operations[0].operationID])
+            .to.beNil();
+        SKYMessageOperation *failedOperation =
+            [[SKYMessageOperationCacheObject objectInRealm:realm
+                                             forPrimaryKey:operations[1].operationID]
+                messageOperation];
+        expect(failedOperation.status).to.equal(SKYMessageOperationStatusFailed);
+        expect(failedOperation.error).to.equal(error);
+        expect([SKYMessageCacheObject objectInRealm:realm forPrimaryKey:message1.recordName])
+            .notTo.beNil();
+        expect([SKYMessageCacheObject objectInRealm:realm forPrimaryKey:message2.recordName])
+            .to.beNil();
+    });
+
     it(@"fetch messages by type", ^{
         SKYRecordID *conversationID1 = [SKYRecordID recordIDWithRecordType:@"conversation"];
         SKYRecordID *conversationID2 = [SKYRecordID recordIDWithRecordType:@"conversation"];
@@ -634,4 +748,499 @@ describe(@"Cache Controller handle message operations", ^{
     });
 });
 
+describe(@"Cache Controller conversation pages", ^{
+    __block SKYChatCacheController *cacheController = nil;
+    __block NSArray<SKYConversation *> *conversations = nil;
+
+    NSArray<NSString *> * (^conversationIDs)(NSArray<SKYConversation *> *) =
+        ^NSArray<NSString *> *(NSArray<SKYConversation *> *list)
+    {
+        NSMutableArray<NSString *> *ids = [NSMutableArray array];
+        for (SKYConversation *conversation in list) {
+            [ids addObject:conversation.recordName];
+        }
+        return ids;
+    };
+
+    beforeEach(^{
+        cacheController = [[SKYChatCacheController alloc]
+            initWithStore:[[SKYChatCacheRealmStore alloc] initInMemoryWithName:@"ChatTest"]];
+
+        NSMutableArray<SKYConversation *> *list = [NSMutableArray array];
+        for (NSInteger i = 0; i < 4; i++) {
+            SKYRecord *record =
+                [SKYRecord recordWithRecordType:@"conversation"
+                                           name:[NSString stringWithFormat:@"c%ld", i]];
+            [list addObject:[SKYConversation recordWithRecord:record]];
+        }
+        conversations = list;
+
+        [cacheController didFetchConversations:@[ conversations[0], conversations[1] ]
+                                          page:1
+                                      pageSize:2];
+        [cacheController didFetchConversations:@[ conversations[2], conversations[3] ]
+                                          page:2
+                                      pageSize:2];
+    });
+
+    afterEach(^{
+        RLMRealm *realm = cacheController.store.realmInstance;
+        [realm transactionWithBlock:^{
+            [realm deleteAllObjects];
+        }];
+    });
+
+    it(@"fetch cached pages", ^{
+        [cacheController fetchConversationsWithPage:2
+                                           pageSize:2
+                                         completion:^(NSArray<SKYConversation *> *list,
+                                                      NSError *error) {
+                                             expect(conversationIDs(list)).to.equal(@[
+                                                 @"c2", @"c3"
+                                             ]);
+                                         }];
+    });
+
+    it(@"refresh first page", ^{
+        [cacheController didFetchConversations:@[ conversations[3], conversations[0] ]
+                                          page:1
+                                      pageSize:2];
+
+        [cacheController fetchConversationsWithPage:1
+                                           pageSize:2
+                                         completion:^(NSArray<SKYConversation *> *list,
+                                                      NSError *error) {
+                                             expect(conversationIDs(list)).to.equal(@[
+                                                 @"c3", @"c0"
+                                             ]);
+                                         }];
+        [cacheController fetchConversationsWithPage:2
+                                           pageSize:2
+                                         completion:^(NSArray<SKYConversation *> *list,
+                                                      NSError *error) {
+                                             expect(conversationIDs(list)).to.equal(@[ @"c2" ]);
+                                         }];
+    });
+
+    it(@"remove conversations after the last page", ^{
+        [cacheController didFetchConversations:@[ conversations[1] ] page:1 pageSize:2];
+
+        [cacheController fetchConversationsWithPage:1
+                                           pageSize:10
+                                         completion:^(NSArray<SKYConversation *> *list,
+                                                      NSError *error) {
+                                             expect(conversationIDs(list)).to.equal(@[ @"c1" ]);
+                                         }];
+    });
+});
+
+describe(@"Cache Controller message search", ^{
+    __block SKYChatCacheController *cacheController = nil;
+
+    SKYMessage * (^messageWithBody)(NSString *, NSString *, NSString *, NSTimeInterval) =
+        ^SKYMessage *(NSString *messageID, NSString *conversationID, NSString *body,
+                      NSTimeInterval time)
+    {
+        SKYMessage *message = [[SKYMessage alloc]
+            initWithRecordData:[SKYRecord recordWithRecordType:@"message" name:messageID]];
+        message.conversationRef = [SKYReference
+            referenceWithRecordID:[SKYRecordID recordIDWithRecordType:@"conversation"
+                                                                 name:conversationID]];
+        message.creationDate = [NSDate dateWithTimeIntervalSince1970:time];
+        message.body = body;
+        return message;
+    };
+
+    NSArray<NSString *> * (^searchResultIDs)(NSString *, NSString *) =
+        ^NSArray<NSString *> *(NSString *query, NSString *conversationID)
+    {
+        NSMutableArray<NSString *> *ids = [NSMutableArray array];
+        [cacheController searchMessagesWithQuery:query
+                                  conversationID:conversationID
+                                           limit:-1
+                                      completion:^(NSArray<SKYMessage *> *messageList,
+                                                   BOOL isCached, NSError *error) {
+                                          for (SKYMessage *message in messageList) {
+                                              [ids addObject:message.recordName];
+                                          }
+                                      }];
+        return ids;
+    };
+
+    beforeEach(^{
+        cacheController = [[SKYChatCacheController alloc]
+            initWithStore:[[SKYChatCacheRealmStore alloc] initInMemoryWithName:@"ChatTest"]];
+        [cacheController.store setMessages:@[
+            messageWithBody(@"m0", @"c0", @"Meet at the Café tomorrow", 0),
+            messageWithBody(@"m1", @"c0", @"cafe cafe CAFE", 1000),
+            messageWithBody(@"m2", @"c1", @"See you at the cafe", 2000),
+            messageWithBody(@"m3", @"c1", @"我們在東京都見面", 3000),
+        ]];
+    });
+
+    afterEach(^{
+        RLMRealm *realm = cacheController.store.realmInstance;
+        [realm transactionWithBlock:^{
+            [realm deleteAllObjects];
+        }];
+    });
+
+    it(@"tokenize text", ^{
+        expect([SKYChatSearchTokenizer termsWithText:@"Café HELLO, 東京都"])
+            .to.equal(@[ @"cafe", @"hello", @"東京", @"京都" ]);
+        expect([SKYChatSearchTokenizer termsWithText:@"東"]).to.equal(@[ @"東" ]);
+        expect([SKYChatSearchTokenizer termFrequenciesWithText:@"東京都"]).to.equal(@{
+            @"東" : @1,
+            @"京" : @1,
+            @"都" : @1,
+            @"東京" : @1,
+            @"京都" : @1,
+        });
+    });
+
+    it(@"search ignoring case and diacritics", ^{
+        expect(searchResultIDs(@"CAFÉ", nil)).to.equal(@[ @"m1", @"m2", @"m0" ]);
+        expect(searchResultIDs(@"cafe tomorrow", nil)).to.equal(@[ @"m0" ]);
+        expect(searchResultIDs(@"cafe tonight", nil)).to.haveLength(0);
+    });
+
+    it(@"search CJK text", ^{
+        expect(searchResultIDs(@"京都", nil)).to.equal(@[ @"m3" ]);
+        expect(searchResultIDs(@"東京 見面", nil)).to.equal(@[ @"m3" ]);
+        expect(searchResultIDs(@"京見", nil)).to.haveLength(0);
+        expect(searchResultIDs(@"京", nil)).to.equal(@[ @"m3" ]);
+        expect(searchResultIDs(@"面", nil)).to.equal(@[ @"m3" ]);
+    });
+
+    it(@"search in conversation", ^{
+        expect(searchResultIDs(@"cafe", @"c1")).to.equal(@[ @"m2" ]);
+    });
+
+    it(@"update index when message is edited", ^{
+        SKYMessage *message = messageWithBody(@"m2", @"c1", @"See you at the bar", 2000);
+        message.record[@"edited_at"] = [NSDate dateWithTimeIntervalSince1970:5000];
+        [cacheController didSaveMessage:message];
+
+        expect(searchResultIDs(@"cafe", nil)).to.equal(@[ @"m1", @"m0" ]);
+        expect(searchResultIDs(@"bar", nil)).to.equal(@[ @"m2" ]);
+    });
+
+    it(@"remove index when message is deleted", ^{
+        SKYMessage *message = messageWithBody(@"m1", @"c0", @"cafe cafe CAFE", 1000);
+        message.record[@"deleted"] = @YES;
+        [cacheController didDeleteMessage:message];
+
+        expect(searchResultIDs(@"cafe", nil)).to.equal(@[ @"m2", @"m0" ]);
+
+        [cacheController.store deleteMessages:@[ messageWithBody(@"m2", @"c1", nil, 0) ]];
+        expect(searchResultIDs(@"cafe", nil)).to.equal(@[ @"m0" ]);
+        expect([SKYMessageSearchTermCacheObject
+                   objectsInRealm:cacheController.store.realmInstance
+                            where:@"messageID IN %@", @[ @"m1", @"m2" ]]
+                   .count)
+            .to.equal(0);
+    });
+});
+
+describe(@"Cache Controller per user", ^{
+    NSURL *endPoint = [NSURL URLWithString:@"https://test.skygeario.com/"];
+    NSURL *otherEndPoint = [NSURL URLWithString:@"https://other.skygeario.com/"];
+
+    afterEach(^{
+        [SKYChatCacheController removeCacheWithUserID:@"u1" endPoint:endPoint];
+        [SKYChatCacheController removeCacheWithUserID:@"u2" endPoint:endPoint];
+        [SKYChatCacheController removeCacheWithUserID:@"u3" endPoint:endPoint];
+        [SKYChatCacheController removeCacheWithUserID:@"u4" endPoint:endPoint];
+        [SKYChatCacheController removeCacheWithUserID:@"u1" endPoint:otherEndPoint];
+    });
+
+    it(@"keep a separate store for each user and endpoint", ^{
+        SKYChatCacheController *controller =
+            [SKYChatCacheController cacheControllerWithUserID:@"u1" endPoint:endPoint];
+
+        expect([SKYChatCacheController cacheControllerWithUserID:@"u1" endPoint:endPoint])
+            .to.beIdenticalTo(controller);
+        expect([SKYChatCacheController cacheControllerWithUserID:@"u2" endPoint:endPoint])
+            .notTo.beIdenticalTo(controller);
+        expect([SKYChatCacheController cacheControllerWithUserID:@"u1" endPoint:otherEndPoint]
+                   .store.realmConfig.fileURL)
+            .notTo.equal(controller.store.realmConfig.fileURL);
+        expect(controller.store.realmConfig.fileURL)
+            .notTo.equal([SKYChatCacheController defaultController].store.realmConfig.fileURL);
+    });
+
+    it(@"not return cached data of another user", ^{
+        SKYMessage *message = [[SKYMessage alloc]
+            initWithRecordData:[SKYRecord recordWithRecordType:@"message" name:@"m1"]];
+        message.conversationRef = [SKYReference
+            referenceWithRecordID:[SKYRecordID recordIDWithRecordType:@"conversation"
+                                                                 name:@"c1"]];
+        message.creationDate = [NSDate dateWithTimeIntervalSince1970:0];
+        [[SKYChatCacheController cacheControllerWithUserID:@"u1" endPoint:endPoint].store
+            setMessages:@[ message ]];
+
+        expect([[SKYChatCacheController cacheControllerWithUserID:@"u1" endPoint:endPoint].store
+                   getMessageWithID:@"m1"])
+            .notTo.beNil();
+        expect([[SKYChatCacheController cacheControllerWithUserID:@"u2" endPoint:endPoint].store
+                   getMessageWithID:@"m1"])
+            .to.beNil();
+    });
+
+    it(@"create a new store after removing the cache", ^{
+        SKYChatCacheController *controller =
+            [SKYChatCacheController cacheControllerWithUserID:@"u1" endPoint:endPoint];
+        [SKYChatCacheController removeCacheWithUserID:@"u1" endPoint:endPoint];
+
+        expect([SKYChatCacheController cacheControllerWithUserID:@"u1" endPoint:endPoint])
+            .notTo.beIdenticalTo(controller);
+    });
+
+    it(@"keep only the cache controllers of recent users", ^{
+        SKYChatCacheController *controller =
+            [SKYChatCacheController cacheControllerWithUserID:@"u1" endPoint:endPoint];
+        [SKYChatCacheController cacheControllerWithUserID:@"u2" endPoint:endPoint];
+        [SKYChatCacheController cacheControllerWithUserID:@"u3" endPoint:endPoint];
+        expect([SKYChatCacheController cacheControllerWithUserID:@"u1" endPoint:endPoint])
+            .to.beIdenticalTo(controller);
+
+        [SKYChatCacheController cacheControllerWithUserID:@"u2" endPoint:endPoint];
+        [SKYChatCacheController cacheControllerWithUserID:@"u4" endPoint:endPoint];
+        [SKYChatCacheController cacheControllerWithUserID:@"u3" endPoint:endPoint];
+        expect([SKYChatCacheController cacheControllerWithUserID:@"u1" endPoint:endPoint])
+            .notTo.beIdenticalTo(controller);
+    });
+});
+
+describe(@"Encrypted cache store", ^{
+    NSString *storeName = @"ChatEncryptionTest";
+    NSMutableData *encryptionKey = [NSMutableData dataWithLength:64];
+    memset(encryptionKey.mutableBytes, 0x2a, encryptionKey.length);
+
+    SKYMessage * (^message)(NSString *) = ^SKYMessage *(NSString *messageID) {
+        SKYMessage *message = [[SKYMessage alloc]
+            initWithRecordData:[SKYRecord recordWithRecordType:@"message" name:messageID]];
+        message.conversationRef = [SKYReference
+            referenceWithRecordID:[SKYRecordID recordIDWithRecordType:@"conversation"
+                                                                 name:@"c1"]];
+        message.creationDate = [NSDate dateWithTimeIntervalSince1970:0];
+        return message;
+    };
+
+    afterEach(^{
+        [[[SKYChatCacheRealmStore alloc] initWithName:storeName] deleteFilesInBackground];
+    });
+
+    it(@"read and write with encryption key", ^{
+        @autoreleasepool {
+            SKYChatCacheRealmStore *store =
+                [[SKYChatCacheRealmStore alloc] initWithName:storeName encryptionKey:encryptionKey];
+            [store setMessages:@[ message(@"m1") ]];
+        }
+
+        SKYChatCacheRealmStore *store =
+            [[SKYChatCacheRealmStore alloc] initWithName:storeName encryptionKey:encryptionKey];
+        expect([store getMessageWithID:@"m1"]).notTo.beNil();
+    });
+
+    it(@"encrypt existing unencrypted store", ^{
+        @autoreleasepool {
+            SKYChatCacheRealmStore *plainStore =
+                [[SKYChatCacheRealmStore alloc] initWithName:storeName];
+            [plainStore setMessages:@[ message(@"m1") ]];
+        }
+
+        @autoreleasepool {
+            SKYChatCacheRealmStore *store =
+                [[SKYChatCacheRealmStore alloc] initWithName:storeName encryptionKey:encryptionKey];
+            expect([store getMessageWithID:@"m1"]).notTo.beNil();
+        }
+
+        RLMRealmConfiguration *plainConfig =
+            [[SKYChatCacheRealmStore alloc] initWithName:storeName].realmConfig;
+        expect([RLMRealm realmWithConfiguration:plainConfig error:nil]).to.beNil();
+    });
+
+    it(@"keep data of in-memory store between accesses", ^{
+        // The store used when the encryption key is unavailable.
+        SKYChatCacheRealmStore *store =
+            [[SKYChatCacheRealmStore alloc] initInMemoryWithName:storeName];
+        @autoreleasepool {
+            [store setMessages:@[ message(@"m1") ]];
+        }
+
+        @autoreleasepool {
+            expect([store getMessageWithID:@"m1"]).notTo.beNil();
+        }
+    });
+});
+
+describe(@"Cache live query", ^{
+    __block SKYChatCacheController *cacheController = nil;
+    __block RLMRealm *realm = nil;
+
+    SKYMessage * (^message)(NSString *, NSInteger) = ^SKYMessage *(NSString *messageID,
+                                                                   NSInteger seq)
+    {
+        SKYMessage *message = [[SKYMessage alloc]
+            initWithRecordData:[SKYRecord recordWithRecordType:@"message" name:messageID]];
+        message.conversationRef = [SKYReference
+            referenceWithRecordID:[SKYRecordID recordIDWithRecordType:@"conversation"
+                                                                 name:@"c1"]];
+        message.creationDate = [NSDate dateWithTimeIntervalSince1970:seq * 1000];
+        message.record[@"seq"] = @(seq);
+        return message;
+    };
+
+    beforeEach(^{
+        cacheController = [[SKYChatCacheController alloc]
+            initWithStore:[[SKYChatCacheRealmStore alloc] initInMemoryWithName:@"ChatLiveQuery"]];
+        realm = cacheController.store.realmInstance;
+        [cacheController.store setMessages:@[ message(@"m1", 1), message(@"m2", 2) ]];
+    });
+
+    afterEach(^{
+        [realm transactionWithBlock:^{
+            [realm deleteAllObjects];
+        }];
+        realm = nil;
+    });
+
+    it(@"deliver initial result and changes", ^{
+        NSMutableArray<NSArray<NSString *> *> *deliveries = [NSMutableArray array];
+        NSMutableArray<SKYChatCacheChange *> *changes = [NSMutableArray array];
+        __block SKYChatCacheLiveQuery *liveQuery = nil;
+
+        waitUntil(^(DoneCallback done) {
+            SKYChatMessagesLiveQueryHandler handler = ^(NSArray<SKYMessage *> *messages,
+                                                        SKYChatCacheChange *change) {
+                expect([NSThread isMainThread]).to.beTruthy();
+                [deliveries addObject:[messages valueForKeyPath:@"recordName"]];
+                if (change) {
+                    [changes addObject:change];
+                }
+
+                if (deliveries.count == 1) {
+                    [cacheController.store setMessages:@[ message(@"m3", 3) ]];
+                } else {
+                    done();
+                }
+            };
+            liveQuery = [cacheController liveQueryForMessagesWithConversationID:@"c1"
+                                                                          limit:10
+                                                                        handler:handler];
+        });
+
+        expect(deliveries).to.equal(@[ @[ @"m2", @"m1" ], @[ @"m3", @"m2", @"m1" ] ]);
+        expect(changes[0].insertions).to.equal([NSIndexSet indexSetWithIndex:0]);
+        expect(changes[0].deletions.count).to.equal(0);
+        expect(liveQuery.objects).to.haveLength(3);
+
+        [liveQuery invalidate];
+    });
+
+    it(@"deliver only the latest messages within the limit", ^{
+        NSMutableArray<NSArray<NSString *> *> *deliveries = [NSMutableArray array];
+        NSMutableArray<SKYChatCacheChange *> *changes = [NSMutableArray array];
+        __block SKYChatCacheLiveQuery *liveQuery = nil;
+
+        waitUntil(^(DoneCallback done) {
+            SKYChatMessagesLiveQueryHandler handler = ^(NSArray<SKYMessage *> *messages,
+                                                        SKYChatCacheChange *change) {
+                [deliveries addObject:[messages valueForKeyPath:@"recordName"]];
+                if (change) {
+                    [changes addObject:change];
+                }
+
+                if (deliveries.count == 1) {
+                    // m1 is out of the limit, so changing it is not delivered
+                    SKYMessage *editedMessage = message(@"m1", 1);
+                    editedMessage.body = @"edited";
+                    [cacheController.store setMessages:@[ editedMessage ]];
+                    [cacheController.store setMessages:@[ message(@"m3", 3) ]];
+                } else {
+                    done();
+                }
+            };
+            liveQuery = [cacheController liveQueryForMessagesWithConversationID:@"c1"
+                                                                          limit:1
+                                                                        handler:handler];
+        });
+
+        expect(deliveries).to.equal(@[ @[ @"m2" ], @[ @"m3" ] ]);
+        expect(changes[0].deletions).to.equal([NSIndexSet indexSetWithIndex:0]);
+        expect(changes[0].insertions).to.equal([NSIndexSet indexSetWithIndex:0]);
+        expect(changes[0].modifications.count).to.equal(0);
+
+        [liveQuery invalidate];
+    });
+
+    it(@"deliver modified and deleted messages", ^{
+        NSMutableArray<NSArray<NSString *> *> *deliveries = [NSMutableArray array];
+        NSMutableArray<SKYChatCacheChange *> *changes = [NSMutableArray array];
+        __block SKYChatCacheLiveQuery *liveQuery = nil;
+
+        waitUntil(^(DoneCallback done) {
+            SKYChatMessagesLiveQueryHandler handler = ^(NSArray<SKYMessage *> *messages,
+                                                        SKYChatCacheChange *change) {
+                [deliveries addObject:[messages valueForKeyPath:@"recordName"]];
+                if (change) {
+                    [changes addObject:change];
+                }
+
+                if (deliveries.count == 1) {
+                    SKYMessage *editedMessage = message(@"m2", 2);
+                    editedMessage.body = @"edited";
+                    [cacheController.store setMessages:@[ editedMessage ]];
+                } else if (deliveries.count == 2) {
+                    expect(messages[0].body).to.equal(@"edited");
+                    SKYMessage *deletedMessage = message(@"m1", 1);
+                    deletedMessage.record[@"deleted"] = @YES;
+                    [cacheController.store setMessages:@[ deletedMessage ]];
+                } else {
+                    done();
+                }
+            };
+            liveQuery = [cacheController liveQueryForMessagesWithConversationID:@"c1"
+                                                                          limit:10
+                                                                        handler:handler];
+        });
+
+        expect(deliveries).to.equal(@[ @[ @"m2", @"m1" ], @[ @"m2", @"m1" ], @[ @"m2" ] ]);
+        expect(changes[0].modifications).to.equal([NSIndexSet indexSetWithIndex:0]);
+        expect(changes[1].deletions).to.equal([NSIndexSet indexSetWithIndex:1]);
+
+        [liveQuery invalidate];
+    });
+
+    it(@"skip objects failing to decode", ^{
+        __block NSArray<NSString *> *delivery = nil;
+        __block SKYChatCacheLiveQuery *liveQuery = nil;
+
+        waitUntil(^(DoneCallback done) {
+            RLMResults *results =
+                [[SKYMessageCacheObject objectsInRealm:realm where:@"conversationID == 'c1'"]
+                    sortedResultsUsingKeyPath:@"creationDate"
+                                    ascending:NO];
+            liveQuery = [[SKYChatCacheLiveQuery alloc] initWithResults:results
+                limit:0
+                transform:^id(RLMObject *cacheObject) {
+                    SKYMessageCacheObject *messageObject = (SKYMessageCacheObject *)cacheObject;
+                    if ([messageObject.recordID isEqualToString:@"m2"]) {
+                        return nil;
+                    }
+                    return [messageObject messageRecord];
+                }
+                handler:^(NSArray *objects, SKYChatCacheChange *change) {
+                    delivery = [objects valueForKeyPath:@"recordName"];
+                    done();
+                }];
+        });
+
+        expect(delivery).to.equal(@[ @"m1" ]);
+
+        [liveQuery invalidate];
+    });
+});
+
 SpecEnd
@@ -17,18 +17,90 @@
 //  limitations under the License.
 //
 
+#import "SKYAsset+mimeType.h"
 #import "SKYChatCacheController+Private.h"
 #import "SKYChatCacheController.h"
 #import "SKYChatCacheRealmStore+Private.h"
 #import "SKYChatExtension.h"
 #import "SKYChatExtension_Private.h"
+#import "SKYChatLogger.h"
+#import "SKYChatMessagesReconciliation.h"
+#import "SKYChatMessagesResponseDecoder.h"
+#import "SKYChatMetrics.h"
+#import "SKYChatTypingIndicatorThrottle.h"
+#import "SKYChatTypingIndicator_Private.h"
+#import "SKYChatTypingStateStore.h"
+#import "SKYChatUnreadCountTracker.h"
+#import <OHHTTPStubs/NSURLRequest+HTTPBodyTesting.h>
 #import <OHHTTPStubs/OHHTTPStubs.h>
+#import <objc/runtime.h>
 
 #import "SKYConversation.h"
 #import "SKYMessageCacheObject.h"
 #import "SKYMessageOperationCacheObject.h"
 #import "SKYMessageOperation_Private.h"
 
+/**
+ *  Stubs record:save with the records of the request as the saved records, except those named
+ *  in failedRecordNames, which are returned as per-record errors.
+ */
+static void SKYChatStubSaveRecords(NSArray<NSString *> *failedRecordNames)
+{
+    [OHHTTPStubs stubRequestsPassingTest:^BOOL(NSURLRequest *request) {
+        NSArray<NSString *> *components = request.URL.pathComponents;
+        return [components[components.count - 2] isEqualToString:@"record"] &&
+               [components.lastObject isEqualToString:@"save"];
+    }
+        withStubResponse:^OHHTTPStubsResponse *(NSURLRequest *request) {
+            NSDictionary *payload =
+                [NSJSONSerialization JSONObjectWithData:request.OHHTTPStubs_HTTPBody
+                                                options:0
+                                                  error:nil];
+            NSMutableArray *results = [NSMutableArray array];
+            for (NSDictionary *record in payload[@"records"]) {
+                NSString *recordName =
+                    [[record[@"_id"] componentsSeparatedByString:@"/"] lastObject];
+                if ([failedRecordNames containsObject:recordName]) {
+                    [results addObject:@{
+                        @"_type" : @"error",
+                        @"_id" : record[@"_id"],
+                        @"code" : @(SKYErrorInvalidArgument),
+                        @"name" : @"InvalidArgument",
+                        @"message" : @"invalid message",
+                    }];
+                    continue;
+                }
+
+                NSMutableDictionary *result = [record mutableCopy];
+                [result addEntriesFromDictionary:@{
+                    @"_type" : @"record",
+                    @"_access" : [NSNull null],
+                    @"_created_at" : @"2017-12-25T00:00:00.000000Z",
+                    @"_created_by" : @"u1",
+                    @"_ownerID" : @"u1",
+                    @"_updated_at" : @"2017-12-25T00:00:00.000000Z",
+                    @"_updated_by" : @"u1",
+                }];
+                [results addObject:result];
+            }
+
+            NSDictionary *parameters = @{ @"database_id" : @"_public", @"result" : results };
+            NSData *data = [NSJSONSerialization dataWithJSONObject:parameters options:0 error:nil];
+            return [OHHTTPStubsResponse responseWithData:data statusCode:200 headers:@{}];
+        }];
+}
+
+static NSArray<SKYMessage *> *SKYChatNewMessages(NSInteger count)
+{
+    NSMutableArray<SKYMessage *> *messages = [NSMutableArray arrayWithCapacity:count];
+    for (NSInteger i = 0; i < count; i++) {
+        NSString *recordName = [NSString stringWithFormat:@"mb%ld", (long)i];
+        SKYRecord *record = [SKYRecord recordWithRecordType:@"message" name:recordName];
+        [messages addObject:[SKYMessage recordWithRecord:record]];
+    }
+    return messages;
+}
+
 SpecBegin(SKYChatExtension)
 
     describe(@"Conversation messages", ^{
@@ -253,6 +325,56 @@ SpecBegin(SKYChatExtension)
             });
         });
 
+        it(@"prefetch messages", ^{
+            SKYConversation *conversation = [SKYConversation
+                recordWithRecord:[SKYRecord recordWithRecordType:@"conversation" name:@"c0"]];
+            conversation.participantIds = @[];
+
+            waitUntil(^(DoneCallback done) {
+                [chatExtension
+                    prefetchMessagesWithConversations:@[ conversation ]
+                                                limit:10
+                                           byteBudget:0
+                                           completion:^(NSUInteger fetchedBytes,
+                                                        NSError *_Nullable error) {
+                                               expect(error).to.beNil();
+                                               expect(fetchedBytes).to.beGreaterThan(0);
+
+                                               RLMRealm *realm = cacheController.store.realmInstance;
+                                               RLMResults<SKYMessageCacheObject *> *results =
+                                                   [SKYMessageCacheObject allObjectsInRealm:realm];
+                                               expect(results.count).to.equal(20);
+                                               done();
+                                           }];
+            });
+        });
+
+        it(@"skip prefetching conversation with cached last message", ^{
+            SKYConversation *conversation = [SKYConversation
+                recordWithRecord:[SKYRecord recordWithRecordType:@"conversation" name:@"c0"]];
+            conversation.participantIds = @[];
+            conversation.lastMessage = [SKYMessage
+                recordWithRecord:[SKYRecord recordWithRecordType:@"message" name:@"m9"]];
+
+            waitUntil(^(DoneCallback done) {
+                [chatExtension
+                    prefetchMessagesWithConversations:@[ conversation ]
+                                                limit:10
+                                           byteBudget:0
+                                           completion:^(NSUInteger fetchedBytes,
+                                                        NSError *_Nullable error) {
+                                               expect(error).to.beNil();
+                                               expect(fetchedBytes).to.equal(0);
+
+                                               RLMRealm *realm = cacheController.store.realmInstance;
+                                               RLMResults<SKYMessageCacheObject *> *results =
+                                                   [SKYMessageCacheObject allObjectsInRealm:realm];
+                                               expect(results.count).to.equal(10);
+                                               done();
+                                           }];
+            });
+        });
+
         it(@"save message", ^{
             SKYMessage *message = [SKYMessage
                 recordWithRecord:[SKYRecord recordWithRecordType:@"message" name:@"mm1"]];
@@ -281,6 +403,143 @@ SpecBegin(SKYChatExtension)
             });
         });
 
+        it(@"save messages in order", ^{
+            SKYChatStubSaveRecords(@[]);
+            NSArray<SKYMessage *> *messages = SKYChatNewMessages(3);
+            SKYConversation *conversation = [SKYConversation
+                recordWithRecord:[SKYRecord recordWithRecordType:@"conversation" name:@"c0"]];
+
+            waitUntil(^(DoneCallback done) {
+                [chatExtension
+                       addMessages:messages
+                    toConversation:conversation
+                        completion:^(NSArray<SKYMessage *> *savedMessages,
+                                     NSDictionary<NSNumber *, NSError *> *errorsByIndex) {
+                            expect(errorsByIndex).to.haveCountOf(0);
+                            expect(savedMessages).to.haveCountOf(messages.count);
+                            [savedMessages enumerateObjectsUsingBlock:^(
+                                               SKYMessage *message, NSUInteger idx, BOOL *stop) {
+                                expect(message.recordName).to.equal(messages[idx].recordName);
+                            }];
+
+                            RLMRealm *realm = cacheController.store.realmInstance;
+                            expect([SKYMessageCacheObject allObjectsInRealm:realm].count)
+                                .to.equal(13);
+                            expect([SKYMessageOperationCacheObject allObjectsInRealm:realm].count)
+                                .to.equal(0);
+                            done();
+                        }];
+            });
+        });
+
+        it(@"report messages failed to save", ^{
+            SKYChatStubSaveRecords(@[ @"mb1" ]);
+            NSArray<SKYMessage *> *messages = SKYChatNewMessages(3);
+            SKYConversation *conversation = [SKYConversation
+                recordWithRecord:[SKYRecord recordWithRecordType:@"conversation" name:@"c0"]];
+
+            waitUntil(^(DoneCallback done) {
+                [chatExtension
+                       addMessages:messages
+                    toConversation:conversation
+                        completion:^(NSArray<SKYMessage *> *savedMessages,
+                                     NSDictionary<NSNumber *, NSError *> *errorsByIndex) {
+                            expect(savedMessages).to.haveCountOf(messages.count);
+                            expect(errorsByIndex.allKeys).to.equal(@[ @1 ]);
+                            expect(savedMessages[1]).to.beIdenticalTo(messages[1]);
+
+                            RLMRealm *realm = cacheController.store.realmInstance;
+                            expect([SKYMessageCacheObject allObjectsInRealm:realm].count)
+                                .to.equal(12);
+                            RLMResults<SKYMessageOperationCacheObject *> *results =
+                                [SKYMessageOperationCacheObject allObjectsInRealm:realm];
+                            expect(results.count).to.equal(1);
+                            SKYMessageOperation *operation = results[0].messageOperation;
+                            expect(operation.message.recordName).to.equal(@"mb1");
+                            expect(operation.status).to.equal(SKYMessageOperationStatusFailed);
+                            done();
+                        }];
+            });
+        });
+
+        it(@"complete adding no messages", ^{
+            SKYConversation *conversation = [SKYConversation
+                recordWithRecord:[SKYRecord recordWithRecordType:@"conversation" name:@"c0"]];
+
+            __block BOOL completed = NO;
+            [chatExtension addMessages:@[]
+                        toConversation:conversation
+                            completion:^(NSArray<SKYMessage *> *savedMessages,
+                                         NSDictionary<NSNumber *, NSError *> *errorsByIndex) {
+                                expect(savedMessages).to.haveCountOf(0);
+                                expect(errorsByIndex).to.haveCountOf(0);
+                                completed = YES;
+                            }];
+            expect(completed).to.beTruthy();
+        });
+
+        it(@"upload attachments concurrently up to the limit", ^{
+            SKYChatStubSaveRecords(@[]);
+            NSArray<SKYMessage *> *messages = SKYChatNewMessages(5);
+            NSData *data = [@"attachment" dataUsingEncoding:NSUTF8StringEncoding];
+            for (SKYMessage *message in messages) {
+                message.attachment =
+                    [SKYAsset assetWithName:message.recordName mimeType:@"text/plain" data:data];
+            }
+            SKYConversation *conversation = [SKYConversation
+                recordWithRecord:[SKYRecord recordWithRecordType:@"conversation" name:@"c0"]];
+
+            // Uploads finish after a delay, so that concurrent uploads overlap.
+            __block NSInteger uploadCount = 0;
+            __block NSInteger inFlightCount = 0;
+            __block NSInteger maxInFlightCount = 0;
+            NSObject *lock = [[NSObject alloc] init];
+            SEL uploadSelector = @selector(uploadAsset:completionHandler:);
+            Method uploadMethod = class_getInstanceMethod([SKYDatabase class], uploadSelector);
+            IMP originalUpload = method_getImplementation(uploadMethod);
+            method_setImplementation(
+                uploadMethod,
+                imp_implementationWithBlock(^(SKYDatabase *database, SKYAsset *asset,
+                                              void (^completionHandler)(SKYAsset *, NSError *)) {
+                    @synchronized(lock) {
+                        uploadCount++;
+                        inFlightCount++;
+                        maxInFlightCount = MAX(maxInFlightCount, inFlightCount);
+                    }
+                    NSURL *url = [NSURL
+                        URLWithString:[@"https://test.skygeario.com/files/"
+                                          stringByAppendingString:asset.name]];
+                    dispatch_time_t time =
+                        dispatch_time(DISPATCH_TIME_NOW, (int64_t)(0.05 * NSEC_PER_SEC));
+                    dispatch_queue_t queue =
+                        dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+                    dispatch_after(time, queue, ^{
+                        @synchronized(lock) {
+                            inFlightCount--;
+                        }
+                        completionHandler([SKYAsset assetWithName:asset.name url:url], nil);
+                    });
+                }));
+
+            chatExtension.maxConcurrentAttachmentUploads = 2;
+            waitUntil(^(DoneCallback done) {
+                [chatExtension addMessages:messages
+                            toConversation:conversation
+                                completion:^(NSArray<SKYMessage *> *savedMessages,
+                                             NSDictionary<NSNumber *, NSError *> *errorsByIndex) {
+                                    expect(errorsByIndex).to.haveCountOf(0);
+                                    done();
+                                }];
+            });
+            method_setImplementation(uploadMethod, originalUpload);
+
+            expect(uploadCount).to.equal(5);
+            expect(maxInFlightCount).to.equal(2);
+            for (SKYMessage *message in messages) {
+                expect(message.attachment.url.isFileURL).to.beFalsy();
+            }
+        });
+
         it(@"delete message", ^{
             SKYMessage *message = [SKYMessage
                 recordWithRecord:[SKYRecord recordWithRecordType:@"message" name:@"m1"]];
@@ -417,6 +676,42 @@ describe(@"Conversation messages, with error response", ^{
         });
     });
 
+    it(@"continue prefetching after a conversation fails", ^{
+        __block NSInteger requestCount = 0;
+        [OHHTTPStubs stubRequestsPassingTest:^BOOL(NSURLRequest *request) {
+            NSArray<NSString *> *components = request.URL.pathComponents;
+            return [components.lastObject isEqualToString:@"get_messages"];
+        }
+            withStubResponse:^OHHTTPStubsResponse *(NSURLRequest *request) {
+                requestCount++;
+                return
+                    [OHHTTPStubsResponse responseWithError:[NSError errorWithDomain:NSURLErrorDomain
+                                                                               code:0
+                                                                           userInfo:nil]];
+            }];
+
+        NSMutableArray<SKYConversation *> *conversations = [NSMutableArray array];
+        for (NSString *name in @[ @"c1", @"c2" ]) {
+            SKYConversation *conversation = [SKYConversation
+                recordWithRecord:[SKYRecord recordWithRecordType:@"conversation" name:name]];
+            conversation.participantIds = @[];
+            [conversations addObject:conversation];
+        }
+
+        waitUntil(^(DoneCallback done) {
+            [chatExtension prefetchMessagesWithConversations:conversations
+                                                       limit:10
+                                                  byteBudget:0
+                                                  completion:^(NSUInteger fetchedBytes,
+                                                               NSError *_Nullable error) {
+                                                      expect(error).toNot.beNil();
+                                                      expect(fetchedBytes).to.equal(0);
+                                                      expect(requestCount).to.equal(2);
+                                                      done();
+                                                  }];
+        });
+    });
+
     it(@"save message", ^{
         SKYMessage *message =
             [SKYMessage recordWithRecord:[SKYRecord recordWithRecordType:@"message" name:@"mm1"]];
@@ -693,4 +988,444 @@ describe(@"Message Operations", ^{
     });
 });
 
+describe(@"Typing indicator throttle", ^{
+    __block SKYChatTypingIndicatorThrottle *throttle = nil;
+    __block NSMutableArray<NSString *> *sentEvents = nil;
+
+    beforeEach(^{
+        sentEvents = [NSMutableArray array];
+        throttle = [[SKYChatTypingIndicatorThrottle alloc]
+            initWithSendHandler:^(SKYChatTypingEvent event, NSString *conversationID,
+                                  NSDate *date) {
+                [sentEvents addObject:[NSString stringWithFormat:@"%@:%@", conversationID,
+                                                                 SKYChatTypingEventToString(event)]];
+            }];
+        throttle.beginInterval = 60;
+        throttle.pauseInterval = 60;
+    });
+
+    it(@"send begin once within interval", ^{
+        for (NSInteger i = 0; i < 10; i++) {
+            [throttle handleTypingEvent:SKYChatTypingEventBegin conversationID:@"c0"];
+        }
+        [throttle handleTypingEvent:SKYChatTypingEventBegin conversationID:@"c1"];
+
+        expect(sentEvents).to.equal(@[ @"c0:begin", @"c1:begin" ]);
+    });
+
+    it(@"suppress redundant events", ^{
+        [throttle handleTypingEvent:SKYChatTypingEventPause conversationID:@"c0"];
+        [throttle handleTypingEvent:SKYChatTypingEventFinished conversationID:@"c0"];
+        [throttle handleTypingEvent:SKYChatTypingEventBegin conversationID:@"c0"];
+        [throttle handleTypingEvent:SKYChatTypingEventPause conversationID:@"c0"];
+        [throttle handleTypingEvent:SKYChatTypingEventPause conversationID:@"c0"];
+        [throttle handleTypingEvent:SKYChatTypingEventBegin conversationID:@"c0"];
+        [throttle handleTypingEvent:SKYChatTypingEventFinished conversationID:@"c0"];
+        [throttle handleTypingEvent:SKYChatTypingEventFinished conversationID:@"c0"];
+
+        expect(sentEvents).to.equal(@[
+            @"c0:begin", @"c0:pause", @"c0:begin", @"c0:finished"
+        ]);
+    });
+
+    it(@"send pause after inactivity", ^{
+        throttle.pauseInterval = 0.1;
+        [throttle handleTypingEvent:SKYChatTypingEventBegin conversationID:@"c0"];
+
+        expect(sentEvents).after(1).to.equal(@[ @"c0:begin", @"c0:pause" ]);
+    });
+
+    it(@"send pause once after finished and begin again", ^{
+        throttle.pauseInterval = 0.2;
+        [throttle handleTypingEvent:SKYChatTypingEventBegin conversationID:@"c0"];
+        [throttle handleTypingEvent:SKYChatTypingEventFinished conversationID:@"c0"];
+        [throttle handleTypingEvent:SKYChatTypingEventBegin conversationID:@"c0"];
+
+        waitUntil(^(DoneCallback done) {
+            dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(0.1 * NSEC_PER_SEC)),
+                           dispatch_get_main_queue(), ^{
+                               // keep typing past the check scheduled before finished
+                               [throttle handleTypingEvent:SKYChatTypingEventBegin
+                                            conversationID:@"c0"];
+                               done();
+                           });
+        });
+
+        expect(sentEvents).after(1).to.equal(@[
+            @"c0:begin", @"c0:finished", @"c0:begin", @"c0:pause"
+        ]);
+    });
+
+    it(@"not send pause after reset", ^{
+        throttle.pauseInterval = 0.1;
+        [throttle handleTypingEvent:SKYChatTypingEventBegin conversationID:@"c0"];
+        [throttle reset];
+
+        waitUntil(^(DoneCallback done) {
+            dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(0.5 * NSEC_PER_SEC)),
+                           dispatch_get_main_queue(), ^{
+                               done();
+                           });
+        });
+        expect(sentEvents).to.equal(@[ @"c0:begin" ]);
+    });
+});
+
+describe(@"Typing state store", ^{
+    __block SKYChatTypingStateStore *store = nil;
+    __block NSMutableArray<NSArray<NSString *> *> *changes = nil;
+
+    SKYChatTypingIndicator * (^indicatorWithEvents)(NSDictionary<NSString *, NSString *> *) =
+        ^SKYChatTypingIndicator *(NSDictionary<NSString *, NSString *> *events)
+    {
+        NSString *at = [SKYDataSerialization stringFromDate:[NSDate date]];
+        NSMutableDictionary *dict = [NSMutableDictionary dictionary];
+        [events enumerateKeysAndObjectsUsingBlock:^(NSString *participantID, NSString *event,
+                                                    BOOL *stop) {
+            dict[participantID] = @{@"event" : event, @"at" : at};
+        }];
+        return [[SKYChatTypingIndicator alloc] initWithDictionary:dict conversationID:@"c0"];
+    };
+
+    beforeEach(^{
+        changes = [NSMutableArray array];
+        store = [[SKYChatTypingStateStore alloc]
+            initWithChangeHandler:^(NSString *conversationID,
+                                    NSArray<NSString *> *typingParticipantIDs) {
+                [changes addObject:[typingParticipantIDs
+                                       sortedArrayUsingSelector:@selector(compare:)]];
+            }];
+    });
+
+    it(@"merge typing indicators", ^{
+        [store mergeTypingIndicator:indicatorWithEvents(@{@"user/u1" : @"begin"})];
+        [store mergeTypingIndicator:indicatorWithEvents(@{@"user/u2" : @"begin"})];
+        [store mergeTypingIndicator:indicatorWithEvents(@{@"user/u1" : @"finished"})];
+
+        expect([store typingParticipantIDsWithConversationID:@"c0"]).to.equal(@[ @"user/u2" ]);
+        expect([store typingParticipantIDsWithConversationID:@"c1"]).to.haveLength(0);
+        expect(changes).to.equal(@[ @[ @"user/u1" ], @[ @"user/u1", @"user/u2" ], @[ @"user/u2" ] ]);
+    });
+
+    it(@"expire typing participants", ^{
+        store.expiryInterval = 0.2;
+        [store mergeTypingIndicator:indicatorWithEvents(@{@"user/u1" : @"begin"})];
+
+        expect(changes).after(2).to.equal(@[ @[ @"user/u1" ], @[] ]);
+        expect([store typingParticipantIDsWithConversationID:@"c0"]).to.haveLength(0);
+    });
+
+    it(@"expire typing participants of indicator with expiry interval", ^{
+        SKYChatTypingIndicator *indicator = indicatorWithEvents(@{@"user/u1" : @"begin"});
+        expect(indicator.typingParticipantIDs).to.equal(@[ @"user/u1" ]);
+
+        indicator.expiryInterval = 0;
+        expect(indicator.typingParticipantIDs).to.haveLength(0);
+    });
+});
+
+describe(@"Unread count tracker", ^{
+    __block SKYChatUnreadCountTracker *tracker = nil;
+    __block NSMutableArray<NSDictionary *> *changes = nil;
+
+    beforeEach(^{
+        changes = [NSMutableArray array];
+        tracker = [[SKYChatUnreadCountTracker alloc]
+            initWithChangeHandler:^(NSDictionary<NSString *, NSNumber *> *totalUnreadCount,
+                                    NSString *conversationID) {
+                [changes addObject:totalUnreadCount];
+            }];
+        [tracker updateWithTotalUnreadCount:@{
+            SKYChatMessageUnreadCountKey : @3,
+            SKYChatConversationUnreadCountKey : @1,
+        }];
+        [tracker updateWithUnreadCount:3 conversationID:@"c0"];
+        [tracker updateWithUnreadCount:0 conversationID:@"c1"];
+    });
+
+    it(@"seed counts from server", ^{
+        expect(tracker.hasTotalUnreadCount).to.beTruthy();
+        expect([tracker unreadCountWithConversationID:@"c0"]).to.equal(3);
+        expect([tracker unreadCountWithConversationID:@"c2"]).to.equal(-1);
+        expect([tracker totalUnreadCount]).to.equal(@{
+            SKYChatMessageUnreadCountKey : @3,
+            SKYChatConversationUnreadCountKey : @1,
+        });
+    });
+
+    it(@"count received messages", ^{
+        [tracker didReceiveMessageWithID:@"m1" conversationID:@"c1"];
+        [tracker didReceiveMessageWithID:@"m1" conversationID:@"c1"];
+        [tracker didReceiveMessageWithID:@"m2" conversationID:@"c0"];
+
+        expect([tracker unreadCountWithConversationID:@"c0"]).to.equal(4);
+        expect([tracker unreadCountWithConversationID:@"c1"]).to.equal(1);
+        expect([tracker totalUnreadCount]).to.equal(@{
+            SKYChatMessageUnreadCountKey : @5,
+            SKYChatConversationUnreadCountKey : @2,
+        });
+    });
+
+    it(@"clear read conversations", ^{
+        expect([tracker didReadConversationWithID:@"c0"]).to.beTruthy();
+        expect([tracker didReadConversationWithID:@"c2"]).to.beFalsy();
+
+        expect([tracker unreadCountWithConversationID:@"c0"]).to.equal(0);
+        expect([tracker totalUnreadCount]).to.equal(@{
+            SKYChatMessageUnreadCountKey : @0,
+            SKYChatConversationUnreadCountKey : @0,
+        });
+        expect(changes.count).to.equal(5);
+    });
+
+    it(@"reconcile total before receiving and reading messages", ^{
+        [tracker didReceiveMessageWithID:@"m1" conversationID:@"c0"];
+        [tracker updateWithTotalUnreadCount:@{
+            SKYChatMessageUnreadCountKey : @4,
+            SKYChatConversationUnreadCountKey : @1,
+        }];
+        expect([tracker unreadCountWithConversationID:@"c0"]).to.equal(-1);
+
+        // The reconciled total already includes the unread messages of c0.
+        [tracker didReceiveMessageWithID:@"m2" conversationID:@"c0"];
+        expect([tracker totalUnreadCount]).to.equal(@{
+            SKYChatMessageUnreadCountKey : @5,
+            SKYChatConversationUnreadCountKey : @1,
+        });
+
+        [tracker updateWithUnreadCount:5 conversationID:@"c0"];
+        expect([tracker didReadConversationWithID:@"c0"]).to.beTruthy();
+        expect([tracker totalUnreadCount]).to.equal(@{
+            SKYChatMessageUnreadCountKey : @0,
+            SKYChatConversationUnreadCountKey : @0,
+        });
+    });
+
+    it(@"reset", ^{
+        [tracker reset];
+
+        expect(tracker.hasTotalUnreadCount).to.beFalsy();
+        expect([tracker unreadCountWithConversationID:@"c0"]).to.equal(-1);
+    });
+});
+
+describe(@"Messages response decoder", ^{
+    __block SKYChatMessagesResponseDecoder *decoder = nil;
+
+    NSDictionary * (^messageDictionary)(NSInteger) = ^NSDictionary *(NSInteger i)
+    {
+        return @{
+            @"_access" : [NSNull null],
+            @"_created_at" : @"2017-12-01T00:00:00.000000Z",
+            @"_created_by" : @"u1",
+            @"_id" : [NSString stringWithFormat:@"message/m%ld", (long)i],
+            @"_ownerID" : @"u1",
+            @"_updated_at" : @"2017-12-01T00:00:00.000000Z",
+            @"_updated_by" : @"u1",
+            @"body" : [NSString stringWithFormat:@"message %ld", (long)i],
+            @"conversation" : @{@"$id" : @"conversation/c0", @"$type" : @"ref"},
+            @"deleted" : @NO,
+            @"revision" : @1,
+            @"seq" : @(i),
+        };
+    };
+
+    NSArray<NSDictionary *> * (^messageDictionaries)(NSInteger) =
+        ^NSArray<NSDictionary *> *(NSInteger count)
+    {
+        NSMutableArray<NSDictionary *> *dicts = [NSMutableArray arrayWithCapacity:count];
+        for (NSInteger i = 0; i < count; i++) {
+            [dicts addObject:messageDictionary(i)];
+        }
+        return dicts;
+    };
+
+    beforeEach(^{
+        decoder = [[SKYChatMessagesResponseDecoder alloc] init];
+    });
+
+    it(@"decode response", ^{
+        waitUntil(^(DoneCallback done) {
+            [decoder decodeResponse:@{
+                @"results" : messageDictionaries(25),
+                @"deleted" : @[ messageDictionary(30) ],
+            }
+                         completion:^(NSArray<SKYMessage *> *messages,
+                                      NSArray<SKYMessage *> *deletedMessages) {
+                             expect([NSThread isMainThread]).to.beTruthy();
+                             expect(messages).to.haveLength(25);
+                             expect(messages[24].recordID.recordName).to.equal(@"m24");
+                             expect(messages[24].seq).to.equal(24);
+                             expect(deletedMessages).to.haveLength(1);
+                             done();
+                         }];
+        });
+    });
+
+    it(@"decode messages synchronously", ^{
+        NSArray<SKYMessage *> *messages = [decoder messagesWithDictionaries:messageDictionaries(3)];
+        expect(messages).to.haveLength(3);
+        expect(messages[2].recordID.recordName).to.equal(@"m2");
+    });
+});
+
+describe(@"Logger", ^{
+    __block NSMutableArray<NSString *> *logs = nil;
+
+    beforeEach(^{
+        logs = [NSMutableArray array];
+        SKYChatLogger.logHandler =
+            ^(SKYChatLogLevel level, NSString *category, NSString *message) {
+                [logs addObject:[NSString stringWithFormat:@"%@ %@", category, message]];
+            };
+    });
+
+    afterEach(^{
+        SKYChatLogger.logHandler = nil;
+        SKYChatLogger.logLevel = SKYChatLogLevelWarning;
+    });
+
+    it(@"filter by level without evaluating arguments", ^{
+        __block NSInteger evaluationCount = 0;
+        NSString * (^argument)(void) = ^NSString *(void) {
+            evaluationCount++;
+            return @"arg";
+        };
+
+        SKYChatLogger.logLevel = SKYChatLogLevelWarning;
+        SKYChatLogError(@"test", @"error %@", argument());
+        SKYChatLogDebug(@"test", @"debug %@", argument());
+
+        expect(logs).to.equal(@[ @"test error arg" ]);
+        expect(evaluationCount).to.equal(1);
+    });
+
+    it(@"sample logs", ^{
+        SKYChatLogger.logLevel = SKYChatLogLevelDebug;
+        for (NSInteger i = 0; i < 10; i++) {
+            SKYChatLogSampled(SKYChatLogLevelDebug, 4, @"test", @"event %ld", (long)i);
+        }
+
+        expect(logs).to.equal(@[ @"test event 0", @"test event 4", @"test event 8" ]);
+    });
+});
+
+describe(@"Metrics", ^{
+    __block SKYChatMetrics *metrics = nil;
+
+    beforeEach(^{
+        metrics = [[SKYChatMetrics alloc] init];
+    });
+
+    it(@"not collect metrics without sink", ^{
+        expect(metrics.enabled).to.beFalsy();
+        expect([metrics beginSpanWithName:@"span"]).to.beNil();
+
+        [metrics incrementCounterWithName:@"counter" by:1];
+        expect([metrics counterValueWithName:@"counter"]).to.equal(0);
+    });
+
+    it(@"record spans and counters", ^{
+        metrics.recordsHistograms = YES;
+
+        SKYChatMetricsSpan *span = [metrics beginSpanWithName:@"span"];
+        [span end];
+        [span end];
+        [metrics incrementCounterWithName:@"counter" by:2];
+
+        expect([metrics histogramWithName:@"span"].count).to.equal(1);
+        expect([metrics counterValueWithName:@"counter"]).to.equal(2);
+
+        [metrics reset];
+        expect([metrics histogramWithName:@"span"]).to.beNil();
+    });
+
+    it(@"compute histogram percentiles", ^{
+        SKYChatLatencyHistogram *histogram = [[SKYChatLatencyHistogram alloc] init];
+        for (NSInteger i = 1; i <= 1000; i++) {
+            [histogram recordValue:i / 1000.0];
+        }
+
+        expect(histogram.count).to.equal(1000);
+        expect(histogram.minValue).to.beCloseToWithin(0.001, 0.0001);
+        expect(histogram.maxValue).to.beCloseToWithin(1, 0.0001);
+        expect(histogram.meanValue).to.beCloseToWithin(0.5005, 0.0001);
+        expect([histogram valueAtPercentile:50]).to.beCloseToWithin(0.5, 0.5 * 0.07);
+        expect([histogram valueAtPercentile:99]).to.beCloseToWithin(0.99, 0.99 * 0.07);
+        expect([histogram valueAtPercentile:100]).to.beCloseToWithin(1, 0.07);
+    });
+});
+
+describe(@"Messages reconciliation", ^{
+    NSDate *baseDate = [NSDate dateWithTimeIntervalSince1970:0];
+
+    SKYMessage * (^message)(NSString *) = ^SKYMessage *(NSString *messageID)
+    {
+        SKYMessage *message = [[SKYMessage alloc]
+            initWithRecordData:[SKYRecord recordWithRecordType:@"message" name:messageID]];
+        message.body = messageID;
+        message.record.modificationDate = baseDate;
+        message.record[SKYMessageStatusKey] = @"delivered";
+        return message;
+    };
+
+    it(@"report no changes for identical pages", ^{
+        SKYChatMessagesReconciliation *reconciliation = [[SKYChatMessagesReconciliation alloc]
+            initWithCachedMessages:@[ message(@"m1"), message(@"m2") ]
+                    serverMessages:@[ message(@"m1"), message(@"m2") ]];
+
+        expect(reconciliation.hasChanges).to.beFalsy();
+    });
+
+    it(@"diff pages by ID", ^{
+        SKYChatMessagesReconciliation *reconciliation = [[SKYChatMessagesReconciliation alloc]
+            initWithCachedMessages:@[ message(@"m1"), message(@"m2") ]
+                    serverMessages:@[ message(@"m1"), message(@"m3") ]];
+
+        expect(reconciliation.hasChanges).to.beTruthy();
+        expect([reconciliation.insertedMessages valueForKey:@"recordName"]).to.equal(@[ @"m3" ]);
+        expect(reconciliation.updatedMessages).to.haveLength(0);
+        expect([reconciliation.removedMessages valueForKey:@"recordName"]).to.equal(@[ @"m2" ]);
+    });
+
+    it(@"report edited message", ^{
+        SKYMessage *editedMessage = message(@"m1");
+        editedMessage.body = @"edited";
+        editedMessage.record.modificationDate = [baseDate dateByAddingTimeInterval:1];
+
+        SKYChatMessagesReconciliation *reconciliation = [[SKYChatMessagesReconciliation alloc]
+            initWithCachedMessages:@[ message(@"m1"), message(@"m2") ]
+                    serverMessages:@[ editedMessage, message(@"m2") ]];
+
+        expect(reconciliation.hasChanges).to.beTruthy();
+        expect(reconciliation.updatedMessages).to.haveLength(1);
+        expect(reconciliation.updatedMessages[0].body).to.equal(@"edited");
+    });
+
+    it(@"report message with changed status", ^{
+        SKYMessage *readMessage = message(@"m1");
+        readMessage.record[SKYMessageStatusKey] = @"all_read";
+
+        SKYChatMessagesReconciliation *reconciliation = [[SKYChatMessagesReconciliation alloc]
+            initWithCachedMessages:@[ message(@"m1") ]
+                    serverMessages:@[ readMessage ]];
+
+        expect(reconciliation.updatedMessages).to.haveLength(1);
+        expect(reconciliation.updatedMessages[0].conversationStatus)
+            .to.equal(SKYMessageConversationStatusAllRead);
+    });
+
+    it(@"report deleted message", ^{
+        SKYMessage *deletedMessage = message(@"m1");
+        deletedMessage.record[SKYMessageDeletedKey] = @YES;
+
+        SKYChatMessagesReconciliation *reconciliation = [[SKYChatMessagesReconciliation alloc]
+            initWithCachedMessages:@[ message(@"m1") ]
+                    serverMessages:@[ deletedMessage ]];
+
+        expect(reconciliation.updatedMessages).to.haveLength(1);
+        expect(reconciliation.updatedMessages[0].deleted).to.beTruthy();
+    });
+});
+
 SpecEnd
@@ -0,0 +1,137 @@
+//
+//  SKYChatBlurHashTests.m
+//  SKYKitChatUITests
+//
+//  Copyright 2016 Oursky Ltd.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <SKYKitChat/SKYKitChat-Swift.h>
+
+static UIImage *SKYChatBlurHashTestSolidImage(UIColor *color)
+{
+    CGRect rect = CGRectMake(0, 0, 64, 64);
+    UIGraphicsBeginImageContextWithOptions(rect.size, YES, 1);
+    [color setFill];
+    UIRectFill(rect);
+    UIImage *image = UIGraphicsGetImageFromCurrentImageContext();
+    UIGraphicsEndImageContext();
+    return image;
+}
+
+static double SKYChatBlurHashTestSRGBToLinear(uint8_t value)
+{
+    double v = value / 255.0;
+    return v <= 0.04045 ? v / 12.92 : pow((v + 0.055) / 1.055, 2.4);
+}
+
+static NSInteger SKYChatBlurHashTestLinearToSRGB(double value)
+{
+    double v = MAX(0, MIN(1, value));
+    if (v <= 0.0031308) {
+        return (NSInteger)(v * 12.92 * 255 + 0.5);
+    }
+    return (NSInteger)((1.055 * pow(v, 1 / 2.4) - 0.055) * 255 + 0.5);
+}
+
+// Averages the pixels of the image in linear colour space, returning the sRGB components.
+static NSArray<NSNumber *> *SKYChatBlurHashTestAverageColor(UIImage *image)
+{
+    size_t width = CGImageGetWidth(image.CGImage);
+    size_t height = CGImageGetHeight(image.CGImage);
+    size_t bytesPerRow = width * 4;
+    NSMutableData *pixels = [NSMutableData dataWithLength:bytesPerRow * height];
+    CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+    CGContextRef context =
+        CGBitmapContextCreate(pixels.mutableBytes, width, height, 8, bytesPerRow, colorSpace,
+                              (CGBitmapInfo)kCGImageAlphaNoneSkipLast);
+    CGContextDrawImage(context, CGRectMake(0, 0, width, height), image.CGImage);
+    CGContextRelease(context);
+    CGColorSpaceRelease(colorSpace);
+
+    const uint8_t *bytes = pixels.bytes;
+    double sums[3] = {0, 0, 0};
+    for (size_t offset = 0; offset < bytesPerRow * height; offset += 4) {
+        for (int k = 0; k < 3; k++) {
+            sums[k] += SKYChatBlurHashTestSRGBToLinear(bytes[offset + k]);
+        }
+    }
+
+    NSMutableArray<NSNumber *> *color = [NSMutableArray arrayWithCapacity:3];
+    for (int k = 0; k < 3; k++) {
+        [color addObject:@(SKYChatBlurHashTestLinearToSRGB(sums[k] / (width * height)))];
+    }
+    return color;
+}
+
+SpecBegin(SKYChatBlurHash)
+
+    describe(@"SKYChatBlurHash", ^{
+        NSString *const referenceHash = @"LEHV6nWB2yk8pyo0adR*.7kCMdnj";
+        CGSize const decodeSize = CGSizeMake(32, 32);
+
+        it(@"round trip solid colour image", ^{
+            UIImage *image = SKYChatBlurHashTestSolidImage([UIColor colorWithRed:0.2
+                                                                           green:0.4
+                                                                            blue:0.6
+                                                                           alpha:1]);
+            NSString *hash = [SKYChatBlurHash encodeWithImage:image componentsX:4 componentsY:3];
+            expect(hash).to.haveLengthOf(28);
+            expect([hash substringToIndex:1]).to.equal(@"L");
+            // DC component of #336699
+            expect([hash substringWithRange:NSMakeRange(2, 4)]).to.equal(@"5?}k");
+
+            UIImage *decoded = [SKYChatBlurHash decode:hash size:decodeSize];
+            expect(decoded.size).to.equal(decodeSize);
+            NSArray<NSNumber *> *color = SKYChatBlurHashTestAverageColor(decoded);
+            expect(color[0].integerValue).to.beCloseToWithin(51, 2);
+            expect(color[1].integerValue).to.beCloseToWithin(102, 2);
+            expect(color[2].integerValue).to.beCloseToWithin(153, 2);
+        });
+
+        it(@"decode reference hash to its DC colour", ^{
+            UIImage *decoded = [SKYChatBlurHash decode:referenceHash size:decodeSize];
+            expect(decoded).notTo.beNil();
+
+            // DC component of the reference hash is #979695
+            NSArray<NSNumber *> *color = SKYChatBlurHashTestAverageColor(decoded);
+            expect(color[0].integerValue).to.beCloseToWithin(151, 2);
+            expect(color[1].integerValue).to.beCloseToWithin(150, 2);
+            expect(color[2].integerValue).to.beCloseToWithin(149, 2);
+        });
+
+        it(@"reject hash of wrong length", ^{
+            expect([SKYChatBlurHash decode:@"" size:decodeSize]).to.beNil();
+            expect([SKYChatBlurHash decode:@"LEHV6" size:decodeSize]).to.beNil();
+            expect([SKYChatBlurHash decode:[referenceHash substringToIndex:27] size:decodeSize])
+                .to.beNil();
+            expect([SKYChatBlurHash decode:[referenceHash stringByAppendingString:@"00"]
+                                      size:decodeSize])
+                .to.beNil();
+        });
+
+        it(@"reject hash with invalid characters", ^{
+            NSString *invalidDC = [referenceHash stringByReplacingOccurrencesOfString:@"V6"
+                                                                           withString:@"V\""];
+            NSString *invalidAC = [referenceHash stringByReplacingOccurrencesOfString:@"nj"
+                                                                           withString:@"n "];
+            NSString *invalidSize =
+                [@"!" stringByAppendingString:[referenceHash substringFromIndex:1]];
+            expect([SKYChatBlurHash decode:invalidDC size:decodeSize]).to.beNil();
+            expect([SKYChatBlurHash decode:invalidAC size:decodeSize]).to.beNil();
+            expect([SKYChatBlurHash decode:invalidSize size:decodeSize]).to.beNil();
+        });
+    });
+
+SpecEnd
@@ -0,0 +1,213 @@
+//
+//  SKYChatMessagePagePrefetcherTests.m
+//  SKYKitChatUITests
+//
+//  Copyright 2016 Oursky Ltd.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <SKYKitChat/SKYKitChat-Swift.h>
+
+typedef void (^SKYChatPrefetchCompletion)(NSArray<SKYMessage *> *, BOOL, NSError *);
+
+static NSArray<SKYMessage *> *SKYChatPrefetchTestPage(NSInteger start, NSInteger count)
+{
+    NSMutableArray<SKYMessage *> *messages = [NSMutableArray arrayWithCapacity:count];
+    for (NSInteger i = start; i < start + count; i++) {
+        NSString *recordName = [NSString stringWithFormat:@"m%ld", (long)i];
+        [messages addObject:[[SKYMessage alloc]
+                                initWithRecordData:[SKYRecord recordWithRecordType:@"message"
+                                                                              name:recordName]]];
+    }
+    return messages;
+}
+
+SpecBegin(SKYChatMessagePagePrefetcher)
+
+    describe(@"SKYChatMessagePagePrefetcher", ^{
+        NSInteger const pageSize = 5;
+
+        __block SKYChatMessagePagePrefetcher *prefetcher = nil;
+        __block NSMutableArray<SKYMessage *> *cursors = nil;
+        __block NSMutableArray<SKYChatPrefetchCompletion> *completions = nil;
+        __block NSMutableArray<SKYChatPrefetchedMessagePage *> *readyPages = nil;
+
+        beforeEach(^{
+            cursors = [NSMutableArray array];
+            completions = [NSMutableArray array];
+            readyPages = [NSMutableArray array];
+            prefetcher = [[SKYChatMessagePagePrefetcher alloc]
+                initWithPageSize:pageSize
+                         fetcher:^(SKYMessage *before, NSInteger limit,
+                                   SKYChatPrefetchCompletion completion) {
+                             [cursors addObject:before ?: (id)[NSNull null]];
+                             [completions addObject:[completion copy]];
+                         }];
+            prefetcher.pageDidBecomeReady = ^(SKYChatPrefetchedMessagePage *page) {
+                [readyPages addObject:page];
+            };
+        });
+
+        it(@"buffer pages up to the limit", ^{
+            SKYMessage *oldestMessage = SKYChatPrefetchTestPage(0, 1).firstObject;
+            NSArray<SKYMessage *> *firstPage = SKYChatPrefetchTestPage(1, pageSize);
+
+            [prefetcher prefetchIfNeededWithDistanceToTop:0 oldestMessage:oldestMessage];
+            [prefetcher prefetchIfNeededWithDistanceToTop:0 oldestMessage:oldestMessage];
+            expect(completions).to.haveCountOf(1);
+            expect(cursors.firstObject).to.equal(oldestMessage);
+            expect(prefetcher.isFetching).to.beTruthy();
+
+            completions[0](firstPage, NO, nil);
+            expect(prefetcher.isFetching).to.beFalsy();
+            expect(prefetcher.bufferedPageCount).to.equal(1);
+            expect(readyPages).to.haveCountOf(1);
+            expect(readyPages.firstObject.isFromServer).to.beTruthy();
+
+            // the next page continues from the buffered page
+            [prefetcher prefetchIfNeededWithDistanceToTop:0 oldestMessage:oldestMessage];
+            expect(completions).to.haveCountOf(2);
+            expect(cursors.lastObject).to.equal(firstPage.lastObject);
+
+            completions[1](SKYChatPrefetchTestPage(6, pageSize), NO, nil);
+            expect(prefetcher.bufferedPageCount).to.equal(2);
+
+            [prefetcher prefetchIfNeededWithDistanceToTop:0 oldestMessage:oldestMessage];
+            expect(completions).to.haveCountOf(2);
+        });
+
+        it(@"not prefetch beyond the lookahead distance", ^{
+            CGFloat distance = prefetcher.lookaheadDistance;
+            [prefetcher prefetchIfNeededWithDistanceToTop:distance oldestMessage:nil];
+            expect(completions).to.haveCountOf(0);
+
+            [prefetcher prefetchIfNeededWithDistanceToTop:distance - 1 oldestMessage:nil];
+            expect(completions).to.haveCountOf(1);
+        });
+
+        it(@"dequeue pages within the insertion distance", ^{
+            [prefetcher prefetchIfNeededWithDistanceToTop:0 oldestMessage:nil];
+            expect([prefetcher dequeuePageWithDistanceToTop:0]).to.beNil();
+
+            completions[0](SKYChatPrefetchTestPage(0, pageSize), NO, nil);
+            CGFloat distance = prefetcher.insertionDistance;
+            expect([prefetcher dequeuePageWithDistanceToTop:distance]).to.beNil();
+
+            SKYChatPrefetchedMessagePage *page =
+                [prefetcher dequeuePageWithDistanceToTop:distance - 1];
+            expect(page.messages).to.haveCountOf(pageSize);
+            expect(prefetcher.bufferedPageCount).to.equal(0);
+        });
+
+        it(@"hand out cached page before server page", ^{
+            __block SKYChatPrefetchedMessagePage *arrivedPage = nil;
+            prefetcher.serverPageDidArriveAfterInsertion = ^(SKYChatPrefetchedMessagePage *page) {
+                arrivedPage = page;
+            };
+            NSArray<SKYMessage *> *cachedMessages = SKYChatPrefetchTestPage(0, 3);
+            NSArray<SKYMessage *> *serverMessages = SKYChatPrefetchTestPage(0, pageSize);
+
+            [prefetcher prefetchIfNeededWithDistanceToTop:0 oldestMessage:nil];
+            completions[0](cachedMessages, YES, nil);
+            expect(prefetcher.isFetching).to.beTruthy();
+            expect(readyPages).to.haveCountOf(1);
+
+            SKYChatPrefetchedMessagePage *page = [prefetcher dequeuePageWithDistanceToTop:0];
+            expect(page.messages).to.equal(cachedMessages);
+            expect(page.isFromServer).to.beFalsy();
+
+            completions[0](serverMessages, NO, nil);
+            expect(arrivedPage).to.beIdenticalTo(page);
+            expect(page.messages).to.equal(serverMessages);
+            expect(page.cachedMessages).to.equal(cachedMessages);
+            expect(page.isFromServer).to.beTruthy();
+            expect(readyPages).to.haveCountOf(1);
+        });
+
+        it(@"ignore completions fetched before reset", ^{
+            [prefetcher prefetchIfNeededWithDistanceToTop:0 oldestMessage:nil];
+            [prefetcher reset];
+            expect(prefetcher.isFetching).to.beFalsy();
+
+            completions[0](SKYChatPrefetchTestPage(0, 3), YES, nil);
+            completions[0](SKYChatPrefetchTestPage(0, pageSize), NO, nil);
+            expect(readyPages).to.haveCountOf(0);
+            expect(prefetcher.bufferedPageCount).to.equal(0);
+            expect(prefetcher.isFetching).to.beFalsy();
+
+            [prefetcher prefetchIfNeededWithDistanceToTop:0 oldestMessage:nil];
+            expect(completions).to.haveCountOf(2);
+        });
+
+        it(@"request the page again after an error", ^{
+            SKYMessage *oldestMessage = SKYChatPrefetchTestPage(0, 1).firstObject;
+            NSError *error = [NSError errorWithDomain:NSURLErrorDomain
+                                                 code:NSURLErrorNotConnectedToInternet
+                                             userInfo:nil];
+
+            [prefetcher prefetchIfNeededWithDistanceToTop:0 oldestMessage:oldestMessage];
+            completions[0](nil, NO, error);
+            expect(prefetcher.isFetching).to.beFalsy();
+            expect(prefetcher.hasMorePages).to.beTruthy();
+            expect(readyPages).to.haveCountOf(0);
+
+            [prefetcher prefetchIfNeededWithDistanceToTop:0 oldestMessage:oldestMessage];
+            expect(completions).to.haveCountOf(2);
+            expect(cursors.lastObject).to.equal(oldestMessage);
+        });
+
+        it(@"keep cached page after an error", ^{
+            NSArray<SKYMessage *> *cachedMessages = SKYChatPrefetchTestPage(0, 3);
+            NSError *error = [NSError errorWithDomain:NSURLErrorDomain
+                                                 code:NSURLErrorTimedOut
+                                             userInfo:nil];
+
+            [prefetcher prefetchIfNeededWithDistanceToTop:0 oldestMessage:nil];
+            completions[0](cachedMessages, YES, nil);
+            completions[0](nil, NO, error);
+            expect(prefetcher.bufferedPageCount).to.equal(1);
+            expect([prefetcher dequeuePageWithDistanceToTop:0].messages).to.equal(cachedMessages);
+        });
+
+        it(@"stop after a short page", ^{
+            [prefetcher prefetchIfNeededWithDistanceToTop:0 oldestMessage:nil];
+            completions[0](SKYChatPrefetchTestPage(0, pageSize - 1), NO, nil);
+            expect(prefetcher.hasMorePages).to.beFalsy();
+            expect(prefetcher.bufferedPageCount).to.equal(1);
+
+            [prefetcher prefetchIfNeededWithDistanceToTop:0 oldestMessage:nil];
+            expect(completions).to.haveCountOf(1);
+        });
+
+        it(@"drop empty server page", ^{
+            [prefetcher prefetchIfNeededWithDistanceToTop:0 oldestMessage:nil];
+            completions[0](@[], NO, nil);
+            expect(prefetcher.hasMorePages).to.beFalsy();
+            expect(prefetcher.bufferedPageCount).to.equal(0);
+            expect(readyPages).to.haveCountOf(0);
+        });
+
+        it(@"not take content offset shift as velocity", ^{
+            [prefetcher scrollViewDidScrollWithOffsetY:1000 timestamp:1.0];
+            [prefetcher scrollViewDidScrollWithOffsetY:700 timestamp:1.5];
+            expect(prefetcher.velocity).to.equal(-300);
+
+            // a page of 600 points is inserted above while scrolling
+            [prefetcher contentOffsetDidShiftBy:600];
+            [prefetcher scrollViewDidScrollWithOffsetY:1000 timestamp:2.0];
+            expect(prefetcher.velocity).to.equal(-450);
+        });
+    });
+
+SpecEnd
@@ -0,0 +1,115 @@
+//
+//  SKYChatMessageViewModelCacheTests.m
+//  SKYKitChatUITests
+//
+//  Copyright 2016 Oursky Ltd.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <JSQMessagesViewController/JSQMessage.h>
+#import <SKYKitChat/SKYKitChat-Swift.h>
+
+static SKYMessage *SKYChatViewModelTestMessage(NSString *recordName)
+{
+    SKYRecord *record = [SKYRecord recordWithRecordType:@"message" name:recordName];
+    record[@"edited_at"] = [NSDate dateWithTimeIntervalSince1970:1000];
+    return [[SKYMessage alloc] initWithRecordData:record];
+}
+
+SpecBegin(SKYChatMessageViewModelCache)
+
+    describe(@"SKYChatMessageViewModelCache", ^{
+        __block SKYChatMessageViewModelCache *cache = nil;
+        __block NSInteger buildCount = 0;
+        __block JSQMessage * (^builder)(SKYMessage *) = nil;
+
+        beforeEach(^{
+            cache = [[SKYChatMessageViewModelCache alloc] initWithMaxCount:2];
+            buildCount = 0;
+            builder = ^JSQMessage *(SKYMessage *message) {
+                buildCount++;
+                return [[JSQMessage alloc] initWithSenderId:@"user1"
+                                          senderDisplayName:@"User 1"
+                                                       date:[NSDate date]
+                                                       text:message.recordName];
+            };
+        });
+
+        it(@"reuse message data of the same revision", ^{
+            SKYMessage *message = SKYChatViewModelTestMessage(@"m1");
+
+            JSQMessage *first = [cache messageDataFor:message builder:builder];
+            JSQMessage *second =
+                [cache messageDataFor:SKYChatViewModelTestMessage(@"m1") builder:builder];
+            expect(second).to.beIdenticalTo(first);
+            expect(buildCount).to.equal(1);
+            expect([cache revisionOf:message])
+                .to.equal([cache revisionOf:SKYChatViewModelTestMessage(@"m1")]);
+        });
+
+        it(@"rebuild message data when message is updated", ^{
+            SKYMessage *message = SKYChatViewModelTestMessage(@"m1");
+            JSQMessage *first = [cache messageDataFor:message builder:builder];
+            NSString *oldRevision = [cache revisionOf:message];
+
+            message.record[@"edited_at"] = [NSDate dateWithTimeIntervalSince1970:2000];
+            expect([cache revisionOf:message]).notTo.equal(oldRevision);
+
+            JSQMessage *second = [cache messageDataFor:message builder:builder];
+            expect(second).notTo.beIdenticalTo(first);
+            expect(buildCount).to.equal(2);
+
+            // the updated revision replaces the old one
+            expect([cache messageDataFor:message builder:builder]).to.beIdenticalTo(second);
+            expect(buildCount).to.equal(2);
+        });
+
+        it(@"rebuild message data after invalidation", ^{
+            SKYMessage *message1 = SKYChatViewModelTestMessage(@"m1");
+            SKYMessage *message2 = SKYChatViewModelTestMessage(@"m2");
+            [cache messageDataFor:message1 builder:builder];
+            [cache messageDataFor:message2 builder:builder];
+
+            [cache invalidateWithMessageID:@"m1"];
+            [cache messageDataFor:message1 builder:builder];
+            [cache messageDataFor:message2 builder:builder];
+            expect(buildCount).to.equal(3);
+
+            [cache invalidateAll];
+            [cache messageDataFor:message1 builder:builder];
+            [cache messageDataFor:message2 builder:builder];
+            expect(buildCount).to.equal(5);
+        });
+
+        it(@"evict least recently used message over count limit", ^{
+            SKYMessage *message1 = SKYChatViewModelTestMessage(@"m1");
+            SKYMessage *message2 = SKYChatViewModelTestMessage(@"m2");
+            SKYMessage *message3 = SKYChatViewModelTestMessage(@"m3");
+            [cache messageDataFor:message1 builder:builder];
+            [cache messageDataFor:message2 builder:builder];
+
+            // touch m1 so that m2 is the least recently used
+            [cache messageDataFor:message1 builder:builder];
+            [cache messageDataFor:message3 builder:builder];
+            expect(buildCount).to.equal(3);
+
+            [cache messageDataFor:message1 builder:builder];
+            expect(buildCount).to.equal(3);
+
+            [cache messageDataFor:message2 builder:builder];
+            expect(buildCount).to.equal(4);
+        });
+    });
+
+SpecEnd
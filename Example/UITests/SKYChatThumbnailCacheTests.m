@@ -0,0 +1,112 @@
+//
+//  SKYChatThumbnailCacheTests.m
+//  SKYKitChatUITests
+//
+//  Copyright 2016 Oursky Ltd.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <SKYKitChat/SKYKitChat-Swift.h>
+
+static SKYMessage *SKYChatThumbnailTestMessage(NSString *recordName, NSDictionary *metadata)
+{
+    SKYMessage *message = [[SKYMessage alloc]
+        initWithRecordData:[SKYRecord recordWithRecordType:@"message" name:recordName]];
+    message.metadata = metadata;
+    return message;
+}
+
+SpecBegin(SKYChatThumbnailCache)
+
+    describe(@"SKYChatThumbnailCache", ^{
+        CGSize const thumbnailSize = CGSizeMake(40, 30);
+
+        __block SKYChatThumbnailCache *cache = nil;
+
+        beforeEach(^{
+            cache = [[SKYChatThumbnailCache alloc] initWithCountLimit:10];
+        });
+
+        it(@"share a single decode between concurrent requests", ^{
+            SKYMessage *message = SKYChatThumbnailTestMessage(
+                @"m1", @{@"blurhash" : @"LEHV6nWB2yk8pyo0adR*.7kCMdnj"});
+            NSMutableArray<UIImage *> *images = [NSMutableArray array];
+
+            waitUntil(^(DoneCallback done) {
+                for (NSInteger i = 0; i < 3; i++) {
+                    [cache thumbnailFor:message
+                                   size:thumbnailSize
+                             completion:^(UIImage *image) {
+                                 expect([NSThread isMainThread]).to.beTruthy();
+                                 [images addObject:image];
+                                 if (images.count == 3) {
+                                     done();
+                                 }
+                             }];
+                }
+                expect([cache cachedThumbnailForMessageID:@"m1"]).to.beNil();
+            });
+
+            expect(images[0].size).to.equal(thumbnailSize);
+            expect(images[1]).to.beIdenticalTo(images[0]);
+            expect(images[2]).to.beIdenticalTo(images[0]);
+            expect([cache cachedThumbnailForMessageID:@"m1"]).to.beIdenticalTo(images[0]);
+        });
+
+        it(@"return cached thumbnail synchronously", ^{
+            SKYMessage *message = SKYChatThumbnailTestMessage(
+                @"m1", @{@"blurhash" : @"LEHV6nWB2yk8pyo0adR*.7kCMdnj"});
+
+            __block UIImage *decoded = nil;
+            waitUntil(^(DoneCallback done) {
+                [cache thumbnailFor:message
+                               size:thumbnailSize
+                         completion:^(UIImage *image) {
+                             decoded = image;
+                             done();
+                         }];
+            });
+
+            __block UIImage *cached = nil;
+            [cache thumbnailFor:message
+                           size:thumbnailSize
+                     completion:^(UIImage *image) {
+                         cached = image;
+                     }];
+            expect(cached).to.beIdenticalTo(decoded);
+        });
+
+        it(@"complete all requests with nil without thumbnail", ^{
+            SKYMessage *message = SKYChatThumbnailTestMessage(@"m1", nil);
+            __block NSInteger completionCount = 0;
+
+            waitUntil(^(DoneCallback done) {
+                for (NSInteger i = 0; i < 2; i++) {
+                    [cache thumbnailFor:message
+                                   size:thumbnailSize
+                             completion:^(UIImage *image) {
+                                 expect(image).to.beNil();
+                                 completionCount++;
+                                 if (completionCount == 2) {
+                                     done();
+                                 }
+                             }];
+                }
+            });
+
+            expect([cache cachedThumbnailForMessageID:@"m1"]).to.beNil();
+        });
+    });
+
+SpecEnd
@@ -19,7 +19,10 @@
 
 #import <Foundation/Foundation.h>
 
+#import "SKYChatCacheEncryptionKeyProvider.h"
+#import "SKYChatCacheLiveQuery.h"
 #import "SKYChatExtension.h"
+#import "SKYConversation.h"
 #import "SKYMessage.h"
 #import "SKYMessageOperation.h"
 #import "SKYParticipant.h"
@@ -28,13 +31,49 @@ NS_ASSUME_NONNULL_BEGIN
 
 @interface SKYChatCacheController : NSObject
 
+/**
+ Gets or sets the provider of encryption keys for cache stores.
+
+ When this is set, cache stores are encrypted with keys from the provider, and existing
+ unencrypted stores are encrypted when they are opened. If the provider does not return a key,
+ the cache is kept in memory only. Set this before the chat extension is first used.
+
+ The default is nil, which means cache stores are not encrypted.
+ */
+@property (class, nonatomic, strong, nullable) id<SKYChatCacheEncryptionKeyProvider>
+    encryptionKeyProvider;
+
 + (instancetype)defaultController;
 
+/**
+ Returns the cache controller of the specified user at the specified server endpoint.
+
+ Each user has a separate cache store, so that data cached for one user is never returned to
+ another. The store is opened when the cache controller is first requested. The stores of the
+ few most recently used users are kept open, so switching back to a recent account does not
+ reopen its store.
+ */
++ (instancetype)cacheControllerWithUserID:(NSString *)userID endPoint:(NSURL *_Nullable)endPoint;
+
+/**
+ Removes the cache of the specified user at the specified server endpoint. The store files are
+ deleted on a background queue.
+ */
++ (void)removeCacheWithUserID:(NSString *)userID endPoint:(NSURL *_Nullable)endPoint;
+
 - (void)fetchParticipants:(NSArray<NSString *> *)participantIDs
                completion:(SKYChatFetchParticpantsCompletion _Nullable)completion;
 
 - (void)didFetchParticipants:(NSArray<SKYParticipant *> *)participants;
 
+- (void)fetchConversationsWithPage:(NSInteger)page
+                          pageSize:(NSInteger)pageSize
+                        completion:(SKYChatFetchConversationListCompletion _Nullable)completion;
+
+- (void)didFetchConversations:(NSArray<SKYConversation *> *)conversations
+                         page:(NSInteger)page
+                     pageSize:(NSInteger)pageSize;
+
 - (void)fetchMessagesWithConversationID:(NSString *)conversationId
                                   limit:(NSInteger)limit
                              beforeTime:(NSDate *)beforeTime
@@ -47,9 +86,59 @@ NS_ASSUME_NONNULL_BEGIN
                                   order:(NSString *)order
                              completion:(SKYChatFetchMessagesListCompletion)completion;
 
+/**
+ Fetches the cached messages following the specified message by seq, in descending order.
+ The completion is not called if the specified message is not cached.
+ */
+- (void)fetchMessagesWithConversationID:(NSString *)conversationId
+                                  limit:(NSInteger)limit
+                         afterMessageID:(NSString *)afterMessageID
+                                  order:(NSString *)order
+                             completion:(SKYChatFetchMessagesListCompletion)completion;
+
+/**
+ Fetches a window of cached messages around the specified message by seq, including the
+ message itself, in descending order. The completion is not called if the specified message is
+ not cached.
+ */
+- (void)fetchMessagesWithConversationID:(NSString *)conversationId
+                                  limit:(NSInteger)limit
+                        aroundMessageID:(NSString *)aroundMessageID
+                                  order:(NSString *)order
+                             completion:(SKYChatFetchMessagesListCompletion)completion;
+
+/**
+ Observes the latest cached messages of the specified conversation up to the limit, in
+ descending order of creation date. This must be called on the main thread.
+ */
+- (SKYChatCacheLiveQuery *)liveQueryForMessagesWithConversationID:(NSString *)conversationId
+                                                            limit:(NSUInteger)limit
+                                                          handler:
+                                                              (SKYChatMessagesLiveQueryHandler)
+                                                                  handler;
+
+/**
+ Observes the message operations of the specified type in the specified conversation, in
+ descending order of send date. This must be called on the main thread.
+ */
+- (SKYChatCacheLiveQuery *)
+liveQueryForMessageOperationsWithConversationID:(NSString *)conversationId
+                                  operationType:(SKYMessageOperationType)type
+                                        handler:(SKYChatMessageOperationsLiveQueryHandler)handler;
+
 - (void)fetchMessagesWithIDs:(NSArray<NSString *> *)messageIDs
                   completion:(SKYChatFetchMessagesListCompletion)completion;
 
+/**
+ Returns whether the message is cached and not deleted, reading the cache synchronously.
+ */
+- (BOOL)hasMessageWithID:(NSString *)messageID;
+
+- (void)searchMessagesWithQuery:(NSString *)query
+                 conversationID:(NSString *_Nullable)conversationID
+                          limit:(NSInteger)limit
+                     completion:(SKYChatFetchMessagesListCompletion)completion;
+
 - (void)didFetchMessages:(NSArray<SKYMessage *> *)messages
          deletedMessages:(NSArray<SKYMessage *> *)deletedMessages;
 
@@ -72,6 +161,23 @@ NS_ASSUME_NONNULL_BEGIN
                           conversationID:(NSString *)conversationID
                            operationType:(SKYMessageOperationType)operationType;
 
+/**
+ Starts an operation for each of the messages, recording them in a single cache transaction.
+ */
+- (NSArray<SKYMessageOperation *> *)didStartMessages:(NSArray<SKYMessage *> *)messages
+                                      conversationID:(NSString *)conversationID
+                                       operationType:(SKYMessageOperationType)operationType;
+
+/**
+ Records the result of saving a batch of messages in a single cache transaction. The saved
+ messages are cached and the completed operations removed. Each failed operation is marked as
+ failed with the error at the same index of `errors`.
+ */
+- (void)didSaveMessages:(NSArray<SKYMessage *> *)savedMessages
+    completedMessageOperations:(NSArray<SKYMessageOperation *> *)completedOperations
+       failedMessageOperations:(NSArray<SKYMessageOperation *> *)failedOperations
+                        errors:(NSArray<NSError *> *)errors;
+
 - (void)didCompleteMessageOperation:(SKYMessageOperation *)messageOperation;
 
 - (void)didFailMessageOperation:(SKYMessageOperation *)messageOperation error:(NSError *)error;
@@ -20,11 +20,21 @@
 #import "SKYChatCacheController.h"
 #import "SKYChatCacheController+Private.h"
 
+#import "SKYChatLogger.h"
+#import "SKYChatSearchTokenizer.h"
 #import "SKYMessageOperationCacheObject.h"
 #import "SKYMessageOperation_Private.h"
 
+#import <CommonCrypto/CommonDigest.h>
+
 static NSString *SKYChatCacheStoreName = @"SKYChatCache";
 
+// The cache controllers of the most recently used users are kept, so that switching back to a
+// recent account does not reopen its store.
+static NSUInteger SKYChatCacheMaxUserCacheControllers = 3;
+
+static id<SKYChatCacheEncryptionKeyProvider> SKYChatCacheEncryptionKeyProviderInstance = nil;
+
 @implementation SKYChatCacheController
 
 + (instancetype)defaultController
@@ -32,8 +42,7 @@ static NSString *SKYChatCacheStoreName = @"SKYChatCache";
     static dispatch_once_t onceToken;
     static SKYChatCacheController *controller;
     dispatch_once(&onceToken, ^{
-        SKYChatCacheRealmStore *store =
-            [[SKYChatCacheRealmStore alloc] initWithName:SKYChatCacheStoreName];
+        SKYChatCacheRealmStore *store = [self storeWithName:SKYChatCacheStoreName];
         controller = [[SKYChatCacheController alloc] initWithStore:store];
 
         // It is assumed that when the default cache controller is created,
@@ -45,6 +54,125 @@ static NSString *SKYChatCacheStoreName = @"SKYChatCache";
     return controller;
 }
 
++ (id<SKYChatCacheEncryptionKeyProvider>)encryptionKeyProvider
+{
+    @synchronized(self) {
+        return SKYChatCacheEncryptionKeyProviderInstance;
+    }
+}
+
++ (void)setEncryptionKeyProvider:(id<SKYChatCacheEncryptionKeyProvider>)encryptionKeyProvider
+{
+    @synchronized(self) {
+        SKYChatCacheEncryptionKeyProviderInstance = encryptionKeyProvider;
+    }
+}
+
++ (SKYChatCacheRealmStore *)storeWithName:(NSString *)storeName
+{
+    id<SKYChatCacheEncryptionKeyProvider> keyProvider = self.encryptionKeyProvider;
+    if (!keyProvider) {
+        return [[SKYChatCacheRealmStore alloc] initWithName:storeName];
+    }
+
+    NSData *encryptionKey = [keyProvider encryptionKeyForStoreName:storeName];
+    if (encryptionKey.length != SKYChatCacheEncryptionKeyLength) {
+        SKYChatLogError(@"cache", @"Encryption key of %@ is unavailable, caching in memory only",
+                        storeName);
+        return [[SKYChatCacheRealmStore alloc] initInMemoryWithName:storeName];
+    }
+
+    return [[SKYChatCacheRealmStore alloc] initWithName:storeName encryptionKey:encryptionKey];
+}
+
++ (NSMutableDictionary<NSString *, SKYChatCacheController *> *)userCacheControllers
+{
+    static dispatch_once_t onceToken;
+    static NSMutableDictionary<NSString *, SKYChatCacheController *> *controllers;
+    dispatch_once(&onceToken, ^{
+        controllers = [NSMutableDictionary dictionary];
+    });
+
+    return controllers;
+}
+
++ (NSMutableArray<NSString *> *)recentUserStoreNames
+{
+    static dispatch_once_t onceToken;
+    static NSMutableArray<NSString *> *storeNames;
+    dispatch_once(&onceToken, ^{
+        storeNames = [NSMutableArray array];
+    });
+
+    return storeNames;
+}
+
++ (NSString *)storeNameWithUserID:(NSString *)userID endPoint:(NSURL *)endPoint
+{
+    // Hash the user and endpoint so that the store name is a valid file name.
+    NSString *key = [NSString stringWithFormat:@"%@|%@", endPoint.absoluteString ?: @"", userID];
+    NSData *data = [key dataUsingEncoding:NSUTF8StringEncoding];
+    unsigned char digest[CC_SHA1_DIGEST_LENGTH];
+    CC_SHA1(data.bytes, (CC_LONG)data.length, digest);
+
+    NSMutableString *name = [NSMutableString stringWithFormat:@"%@-", SKYChatCacheStoreName];
+    for (NSInteger i = 0; i < CC_SHA1_DIGEST_LENGTH; i++) {
+        [name appendFormat:@"%02x", digest[i]];
+    }
+    return name;
+}
+
++ (instancetype)cacheControllerWithUserID:(NSString *)userID endPoint:(NSURL *)endPoint
+{
+    NSString *storeName = [self storeNameWithUserID:userID endPoint:endPoint];
+
+    SKYChatCacheController *controller;
+    SKYChatCacheController *evictedController;
+    @synchronized(self) {
+        controller = [self userCacheControllers][storeName];
+        if (!controller) {
+            controller =
+                [[SKYChatCacheController alloc] initWithStore:[self storeWithName:storeName]];
+            [controller cleanUpOnLaunch];
+            [self userCacheControllers][storeName] = controller;
+        }
+
+        NSMutableArray<NSString *> *storeNames = [self recentUserStoreNames];
+        [storeNames removeObject:storeName];
+        [storeNames addObject:storeName];
+        if (storeNames.count > SKYChatCacheMaxUserCacheControllers) {
+            evictedController = [self userCacheControllers][storeNames[0]];
+            [[self userCacheControllers] removeObjectForKey:storeNames[0]];
+            [storeNames removeObjectAtIndex:0];
+        }
+    }
+
+    [evictedController.store closeWarmInstance];
+    [controller.store keepWarm];
+    return controller;
+}
+
++ (void)removeCacheWithUserID:(NSString *)userID endPoint:(NSURL *)endPoint
+{
+    NSString *storeName = [self storeNameWithUserID:userID endPoint:endPoint];
+
+    SKYChatCacheController *controller;
+    @synchronized(self) {
+        controller = [self userCacheControllers][storeName];
+        [[self userCacheControllers] removeObjectForKey:storeName];
+        [[self recentUserStoreNames] removeObject:storeName];
+    }
+
+    SKYChatCacheRealmStore *store =
+        controller.store ?: [[SKYChatCacheRealmStore alloc] initWithName:storeName];
+    [store deleteFilesInBackground];
+
+    id<SKYChatCacheEncryptionKeyProvider> keyProvider = self.encryptionKeyProvider;
+    if ([keyProvider respondsToSelector:@selector(removeEncryptionKeyForStoreName:)]) {
+        [keyProvider removeEncryptionKeyForStoreName:storeName];
+    }
+}
+
 - (id)initWithStore:(SKYChatCacheRealmStore *)store
 {
     self = [super init];
@@ -95,26 +223,73 @@ static NSString *SKYChatCacheStoreName = @"SKYChatCache";
     [self.store setParticipants:participants];
 }
 
+- (void)fetchConversationsWithPage:(NSInteger)page
+                          pageSize:(NSInteger)pageSize
+                        completion:(SKYChatFetchConversationListCompletion)completion
+{
+    if (!completion) {
+        // do nothing
+        return;
+    }
+
+    NSInteger startPosition = (page - 1) * pageSize;
+    NSPredicate *predicate =
+        [NSPredicate predicateWithFormat:@"position >= %ld", (long)startPosition];
+    completion([self.store getConversationsWithPredicate:predicate limit:pageSize], nil);
+}
+
+- (void)didFetchConversations:(NSArray<SKYConversation *> *)conversations
+                         page:(NSInteger)page
+                     pageSize:(NSInteger)pageSize
+{
+    NSInteger startPosition = (page - 1) * pageSize;
+    NSMutableArray<NSString *> *conversationIDs =
+        [NSMutableArray arrayWithCapacity:conversations.count];
+    for (SKYConversation *conversation in conversations) {
+        [conversationIDs addObject:conversation.recordName];
+    }
+
+    // Conversations cached in the range of this page are either moved to
+    // another page or no longer available. If this is the last page, all
+    // conversations cached after this page are no longer available.
+    NSPredicate *stalePredicate;
+    if ((NSInteger)conversations.count < pageSize) {
+        stalePredicate = [NSPredicate predicateWithFormat:@"position >= %ld AND NOT (recordID IN %@)",
+                                                          (long)startPosition, conversationIDs];
+    } else {
+        stalePredicate = [NSPredicate
+            predicateWithFormat:@"position >= %ld AND position < %ld AND NOT (recordID IN %@)",
+                                (long)startPosition, (long)(startPosition + pageSize),
+                                conversationIDs];
+    }
+    [self.store deleteConversations:[self.store getConversationsWithPredicate:stalePredicate
+                                                                        limit:-1]];
+
+    [self.store setConversations:conversations startPosition:startPosition];
+}
+
 - (void)fetchMessagesWithPredicate:(NSPredicate *)predicate
                              limit:(NSInteger)limit
                              order:(NSString *)order
                         completion:(SKYChatFetchMessagesListCompletion)completion
 {
     if (completion && predicate) {
-        NSString *resolvedOrder = order;
-
-        if ([resolvedOrder isEqualToString:@"edited_at"]) {
-            resolvedOrder = @"editionDate";
-        } else {
-            resolvedOrder = @"creationDate";
-        }
-
         NSArray<SKYMessage *> *messages =
-            [self.store getMessagesWithPredicate:predicate limit:limit order:resolvedOrder];
+            [self.store getMessagesWithPredicate:predicate
+                                           limit:limit
+                                           order:[self resolvedMessagesOrder:order]];
         completion(messages, YES, nil);
     }
 }
 
+- (NSString *)resolvedMessagesOrder:(NSString *)order
+{
+    if ([order isEqualToString:@"edited_at"]) {
+        return @"editionDate";
+    }
+    return @"creationDate";
+}
+
 - (NSMutableArray *)messagesPredicateWithConversationID:(NSString *)conversationId
                                                   limit:(NSInteger)limit
 {
@@ -180,6 +355,86 @@ static NSString *SKYChatCacheStoreName = @"SKYChatCache";
     [self fetchMessagesWithPredicate:predicate limit:limit order:order completion:completion];
 }
 
+- (NSArray<SKYMessage *> *)messagesWithConversationID:(NSString *)conversationId
+                                                limit:(NSInteger)limit
+                                         afterMessage:(SKYMessage *)afterMessage
+                                                order:(NSString *)order
+{
+    NSMutableArray *predicates =
+        [self messagesPredicateWithConversationID:conversationId limit:limit];
+    [predicates addObject:[NSPredicate predicateWithFormat:@"seq > %d", afterMessage.seq]];
+
+    // take the messages nearest to the specified one, then sort them as other pages
+    NSArray<SKYMessage *> *messages = [self.store
+        getMessagesWithPredicate:[NSCompoundPredicate andPredicateWithSubpredicates:predicates]
+                           limit:limit
+                           order:[self resolvedMessagesOrder:order]
+                       ascending:YES];
+    return [[messages reverseObjectEnumerator] allObjects];
+}
+
+- (void)fetchMessagesWithConversationID:(NSString *)conversationId
+                                  limit:(NSInteger)limit
+                         afterMessageID:(NSString *)afterMessageID
+                                  order:(NSString *)order
+                             completion:(SKYChatFetchMessagesListCompletion)completion
+{
+    if (!completion) {
+        return;
+    }
+
+    SKYMessage *afterMessage = [self.store getMessageWithID:afterMessageID];
+    if (!afterMessage) {
+        completion(@[], YES, nil);
+        return;
+    }
+
+    completion([self messagesWithConversationID:conversationId
+                                          limit:limit
+                                   afterMessage:afterMessage
+                                          order:order],
+               YES, nil);
+}
+
+- (void)fetchMessagesWithConversationID:(NSString *)conversationId
+                                  limit:(NSInteger)limit
+                        aroundMessageID:(NSString *)aroundMessageID
+                                  order:(NSString *)order
+                             completion:(SKYChatFetchMessagesListCompletion)completion
+{
+    if (!completion) {
+        return;
+    }
+
+    SKYMessage *aroundMessage = [self.store getMessageWithID:aroundMessageID];
+    if (!aroundMessage) {
+        completion(@[], YES, nil);
+        return;
+    }
+
+    NSString *resolvedOrder = [self resolvedMessagesOrder:order];
+    NSInteger afterLimit = limit / 2;
+    NSInteger beforeLimit = MAX(limit - afterLimit - 1, 0);
+
+    NSMutableArray<SKYMessage *> *messages = [NSMutableArray array];
+    [messages addObjectsFromArray:[self messagesWithConversationID:conversationId
+                                                             limit:afterLimit
+                                                      afterMessage:aroundMessage
+                                                             order:order]];
+    if (!aroundMessage.deleted) {
+        [messages addObject:aroundMessage];
+    }
+    if (beforeLimit > 0) {
+        NSPredicate *predicate = [self messagesPredicateWithConversationID:conversationId
+                                                                     limit:beforeLimit
+                                                           beforeMessageID:aroundMessageID];
+        [messages addObjectsFromArray:[self.store getMessagesWithPredicate:predicate
+                                                                     limit:beforeLimit
+                                                                     order:resolvedOrder]];
+    }
+    completion(messages, YES, nil);
+}
+
 - (void)fetchMessagesWithIDs:(NSArray<NSString *> *)messageIDs
                   completion:(SKYChatFetchMessagesListCompletion)completion
 {
@@ -196,6 +451,27 @@ static NSString *SKYChatCacheStoreName = @"SKYChatCache";
     }
 }
 
+- (BOOL)hasMessageWithID:(NSString *)messageID
+{
+    SKYMessage *message = [self.store getMessageWithID:messageID];
+    return message && !message.deleted;
+}
+
+- (void)searchMessagesWithQuery:(NSString *)query
+                 conversationID:(NSString *)conversationID
+                          limit:(NSInteger)limit
+                     completion:(SKYChatFetchMessagesListCompletion)completion
+{
+    if (!completion) {
+        return;
+    }
+
+    NSArray<NSString *> *terms = [SKYChatSearchTokenizer termsWithText:query];
+    NSArray<SKYMessage *> *messages =
+        [self.store searchMessagesWithTerms:terms conversationID:conversationID limit:limit];
+    completion(messages, YES, nil);
+}
+
 - (void)didFetchMessages:(NSArray<SKYMessage *> *)messages
          deletedMessages:(NSArray<SKYMessage *> *)deletedMessages
 {
@@ -224,6 +500,12 @@ static NSString *SKYChatCacheStoreName = @"SKYChatCache";
     if ([recordChange.recordType isEqualToString:@"message"]) {
         [self handleChangeEvent:recordChange.event
                      forMessage:[[SKYMessage alloc] initWithRecordData:recordChange.record]];
+    } else if ([recordChange.recordType isEqualToString:@"conversation"] &&
+               recordChange.event == SKYChatRecordChangeEventDelete) {
+        // Updated conversations are refreshed by fetching the conversation
+        // list because the event does not carry the last message.
+        [self.store
+            deleteConversations:@[ [SKYConversation recordWithRecord:recordChange.record] ]];
     }
 }
 
@@ -244,6 +526,37 @@ static NSString *SKYChatCacheStoreName = @"SKYChatCache";
 
 #pragma mark - Message Operations
 
+- (SKYChatCacheLiveQuery *)liveQueryForMessagesWithConversationID:(NSString *)conversationId
+                                                            limit:(NSUInteger)limit
+                                                          handler:
+                                                              (SKYChatMessagesLiveQueryHandler)
+                                                                  handler
+{
+    NSPredicate *predicate = [NSCompoundPredicate
+        andPredicateWithSubpredicates:[self messagesPredicateWithConversationID:conversationId
+                                                                          limit:-1]];
+    return [self.store liveQueryForMessagesWithPredicate:predicate
+                                                   order:@"creationDate"
+                                                   limit:limit
+                                                 handler:handler];
+}
+
+- (SKYChatCacheLiveQuery *)
+liveQueryForMessageOperationsWithConversationID:(NSString *)conversationId
+                                  operationType:(SKYMessageOperationType)type
+                                        handler:(SKYChatMessageOperationsLiveQueryHandler)handler
+{
+    NSString *operationTypeKey =
+        [SKYMessageOperationCacheObject messageOperationTypeKeyWithType:type];
+    NSPredicate *predicate = [NSCompoundPredicate andPredicateWithSubpredicates:@[
+        [NSPredicate predicateWithFormat:@"conversationID == %@", conversationId],
+        [NSPredicate predicateWithFormat:@"type == %@", operationTypeKey],
+    ]];
+    return [self.store liveQueryForMessageOperationsWithPredicate:predicate
+                                                            order:@"sendDate"
+                                                          handler:handler];
+}
+
 - (void)fetchMessageOperationsWithConversationID:(NSString *)conversationId
                                    operationType:(SKYMessageOperationType)type
                                       completion:
@@ -294,6 +607,40 @@ static NSString *SKYChatCacheStoreName = @"SKYChatCache";
     return operation;
 }
 
+- (NSArray<SKYMessageOperation *> *)didStartMessages:(NSArray<SKYMessage *> *)messages
+                                      conversationID:(NSString *)conversationID
+                                       operationType:(SKYMessageOperationType)operationType
+{
+    NSMutableArray<SKYMessageOperation *> *operations = [NSMutableArray array];
+    for (SKYMessage *message in messages) {
+        [operations addObject:[[SKYMessageOperation alloc] initWithMessage:message
+                                                            conversationID:conversationID
+                                                                      type:operationType]];
+    }
+    [self.store setMessageOperations:operations];
+    return operations;
+}
+
+- (void)didSaveMessages:(NSArray<SKYMessage *> *)savedMessages
+    completedMessageOperations:(NSArray<SKYMessageOperation *> *)completedOperations
+       failedMessageOperations:(NSArray<SKYMessageOperation *> *)failedOperations
+                        errors:(NSArray<NSError *> *)errors
+{
+    for (SKYMessageOperation *operation in completedOperations) {
+        operation.status = SKYMessageOperationStatusSuccess;
+    }
+    [failedOperations enumerateObjectsUsingBlock:^(SKYMessageOperation *operation, NSUInteger idx,
+                                                   BOOL *stop) {
+        operation.status = SKYMessageOperationStatusFailed;
+        operation.error = [errors[idx] copy];
+    }];
+
+    // Completed message operations are removed from cache store.
+    [self.store setMessages:savedMessages
+                messageOperations:failedOperations
+        deletingMessageOperations:completedOperations];
+}
+
 - (void)didCompleteMessageOperation:(SKYMessageOperation *)messageOperation
 {
     // Completed message operation is removed from cache store.
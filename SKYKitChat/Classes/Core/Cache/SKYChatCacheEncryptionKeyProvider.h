@@ -0,0 +1,73 @@
+//
+//  SKYChatCacheEncryptionKeyProvider.h
+//  SKYKitChat
+//
+//
+//  Copyright 2016 Oursky Ltd.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ The length in bytes of a cache encryption key.
+ */
+extern NSUInteger const SKYChatCacheEncryptionKeyLength;
+
+/**
+ SKYChatCacheEncryptionKeyProvider provides the keys to encrypt cache stores with.
+
+ Cache stores are encrypted by Realm page by page with AES-256, which uses the hardware
+ accelerated implementation of CommonCrypto.
+ */
+@protocol SKYChatCacheEncryptionKeyProvider <NSObject>
+
+/**
+ Returns the encryption key of the specified cache store, creating one if the store does not
+ have a key yet. The key must be SKYChatCacheEncryptionKeyLength bytes long.
+
+ Returns nil if the key is not available, in which case the store is not opened.
+ */
+- (NSData *_Nullable)encryptionKeyForStoreName:(NSString *)storeName;
+
+@optional
+
+/**
+ Removes the encryption key of the specified cache store after the store is deleted.
+ */
+- (void)removeEncryptionKeyForStoreName:(NSString *)storeName;
+
+@end
+
+/**
+ SKYChatKeychainEncryptionKeyProvider generates random cache encryption keys and keeps them
+ in the keychain of this device.
+ */
+@interface SKYChatKeychainEncryptionKeyProvider : NSObject <SKYChatCacheEncryptionKeyProvider>
+
+/**
+ The keychain service under which the keys are stored.
+ */
+@property (nonatomic, readonly, copy) NSString *service;
+
+- (instancetype)init;
+
+- (instancetype)initWithService:(NSString *)service NS_DESIGNATED_INITIALIZER;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,97 @@
+//
+//  SKYChatCacheEncryptionKeyProvider.m
+//  SKYKitChat
+//
+//
+//  Copyright 2016 Oursky Ltd.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+//
+
+#import "SKYChatCacheEncryptionKeyProvider.h"
+
+#import <Security/Security.h>
+
+#import "SKYChatLogger.h"
+
+NSUInteger const SKYChatCacheEncryptionKeyLength = 64;
+
+@implementation SKYChatKeychainEncryptionKeyProvider
+
+- (instancetype)init
+{
+    return [self initWithService:@"io.skygear.chat.cache"];
+}
+
+- (instancetype)initWithService:(NSString *)service
+{
+    if ((self = [super init])) {
+        _service = [service copy];
+    }
+    return self;
+}
+
+- (NSDictionary *)queryWithStoreName:(NSString *)storeName
+{
+    return @{
+        (__bridge id)kSecClass : (__bridge id)kSecClassGenericPassword,
+        (__bridge id)kSecAttrService : self.service,
+        (__bridge id)kSecAttrAccount : storeName,
+    };
+}
+
+- (NSData *)encryptionKeyForStoreName:(NSString *)storeName
+{
+    @synchronized(self) {
+        NSMutableDictionary *query = [[self queryWithStoreName:storeName] mutableCopy];
+        query[(__bridge id)kSecReturnData] = @YES;
+        query[(__bridge id)kSecMatchLimit] = (__bridge id)kSecMatchLimitOne;
+
+        CFTypeRef result = NULL;
+        OSStatus status = SecItemCopyMatching((__bridge CFDictionaryRef)query, &result);
+        if (status == errSecSuccess) {
+            return (__bridge_transfer NSData *)result;
+        } else if (status != errSecItemNotFound) {
+            SKYChatLogError(@"cache", @"Failed to read cache encryption key: %d", (int)status);
+            return nil;
+        }
+
+        NSMutableData *key = [NSMutableData dataWithLength:SKYChatCacheEncryptionKeyLength];
+        if (SecRandomCopyBytes(kSecRandomDefault, key.length, key.mutableBytes) != 0) {
+            SKYChatLogError(@"cache", @"Failed to generate cache encryption key");
+            return nil;
+        }
+
+        NSMutableDictionary *attributes = [[self queryWithStoreName:storeName] mutableCopy];
+        attributes[(__bridge id)kSecValueData] = key;
+        attributes[(__bridge id)kSecAttrAccessible] =
+            (__bridge id)kSecAttrAccessibleAfterFirstUnlockThisDeviceOnly;
+        status = SecItemAdd((__bridge CFDictionaryRef)attributes, NULL);
+        if (status != errSecSuccess) {
+            SKYChatLogError(@"cache", @"Failed to save cache encryption key: %d", (int)status);
+            return nil;
+        }
+
+        return [key copy];
+    }
+}
+
+- (void)removeEncryptionKeyForStoreName:(NSString *)storeName
+{
+    @synchronized(self) {
+        SecItemDelete((__bridge CFDictionaryRef)[self queryWithStoreName:storeName]);
+    }
+}
+
+@end
@@ -0,0 +1,47 @@
+//
+//  SKYChatCacheLiveQuery+Private.h
+//  SKYKitChat
+//
+//
+//  Copyright 2016 Oursky Ltd.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+//
+
+#import <Realm/Realm.h>
+
+#import "SKYChatCacheLiveQuery.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface SKYChatCacheLiveQuery ()
+
+/**
+ Creates a live query of the results. This must be called on the main thread.
+
+ @param results the results to observe
+ @param limit the maximum number of leading objects to observe, or 0 to observe all of them
+ @param transform converts a detached cache object to the object delivered to the handler,
+ called on a background queue, which returns nil for an object that cannot be decoded
+ @param handler called on the main thread with the transformed objects
+ */
+- (instancetype)initWithResults:(RLMResults *)results
+                          limit:(NSUInteger)limit
+                      transform:(id _Nullable (^)(RLMObject *cacheObject))transform
+                        handler:(void (^)(NSArray *objects,
+                                          SKYChatCacheChange *_Nullable change))handler;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,88 @@
+//
+//  SKYChatCacheLiveQuery.h
+//  SKYKitChat
+//
+//
+//  Copyright 2016 Oursky Ltd.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+//
+
+#import <Foundation/Foundation.h>
+
+#import "SKYMessage.h"
+#import "SKYMessageOperation.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ SKYChatCacheChange describes how the result of a live query changed since the previous
+ delivery.
+ */
+@interface SKYChatCacheChange : NSObject
+
+/**
+ Indexes of the removed objects in the previous result.
+ */
+@property (nonatomic, readonly) NSIndexSet *deletions;
+
+/**
+ Indexes of the added objects in the new result.
+ */
+@property (nonatomic, readonly) NSIndexSet *insertions;
+
+/**
+ Indexes of the updated objects in the new result.
+ */
+@property (nonatomic, readonly) NSIndexSet *modifications;
+
+- (instancetype)initWithDeletions:(NSIndexSet *)deletions
+                       insertions:(NSIndexSet *)insertions
+                    modifications:(NSIndexSet *)modifications;
+
+@end
+
+/**
+ The handler of a live query. It is called on the main thread with the whole result, first
+ with a nil change and then with the change every time the cached objects change. The change
+ is also nil when the result is delivered as a whole again, such as when objects are reordered.
+ */
+typedef void (^SKYChatMessagesLiveQueryHandler)(NSArray<SKYMessage *> *messages,
+                                                SKYChatCacheChange *_Nullable change);
+typedef void (^SKYChatMessageOperationsLiveQueryHandler)(
+    NSArray<SKYMessageOperation *> *messageOperations, SKYChatCacheChange *_Nullable change);
+
+/**
+ SKYChatCacheLiveQuery keeps the result of a cache query up to date.
+
+ Changes are observed with Realm collection notifications. When the query has a limit, only
+ the objects within the limit are read on the main thread, and only the inserted and modified
+ ones are decoded, on a background queue, before the handler is called on the main thread.
+ Objects that cannot be decoded are left out of the result.
+ */
+@interface SKYChatCacheLiveQuery : NSObject
+
+/**
+ The result last delivered to the handler.
+ */
+@property (nonatomic, readonly) NSArray *objects;
+
+/**
+ Stops observing the cache. The handler is not called after this method returns.
+ */
+- (void)invalidate;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,244 @@
+//
+//  SKYChatCacheLiveQuery.m
+//  SKYKitChat
+//
+//
+//  Copyright 2016 Oursky Ltd.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+//
+
+#import "SKYChatCacheLiveQuery.h"
+#import "SKYChatCacheLiveQuery+Private.h"
+
+#import "SKYChatLogger.h"
+
+@implementation SKYChatCacheChange
+
+- (instancetype)initWithDeletions:(NSIndexSet *)deletions
+                       insertions:(NSIndexSet *)insertions
+                    modifications:(NSIndexSet *)modifications
+{
+    if ((self = [super init])) {
+        _deletions = [deletions copy];
+        _insertions = [insertions copy];
+        _modifications = [modifications copy];
+    }
+    return self;
+}
+
+@end
+
+@implementation SKYChatCacheLiveQuery {
+    RLMResults *observedResults;
+    NSUInteger limit;
+    NSString *primaryKey;
+    RLMNotificationToken *notificationToken;
+    id (^transform)(RLMObject *);
+    void (^handler)(NSArray *, SKYChatCacheChange *);
+    dispatch_queue_t transformQueue;
+    NSArray<NSString *> *observedKeys;                     // only accessed on main thread
+    NSArray<NSString *> *transformedKeys;                  // only accessed on transformQueue
+    NSDictionary<NSString *, id> *transformedObjectsByKey; // only accessed on transformQueue
+    BOOL invalidated;
+}
+
+- (instancetype)initWithResults:(RLMResults *)results
+                          limit:(NSUInteger)resultsLimit
+                      transform:(id (^)(RLMObject *))transformBlock
+                        handler:(void (^)(NSArray *, SKYChatCacheChange *))handlerBlock
+{
+    if ((self = [super init])) {
+        _objects = @[];
+        observedResults = results;
+        limit = resultsLimit;
+        primaryKey = [NSClassFromString(results.objectClassName) primaryKey];
+        transform = [transformBlock copy];
+        handler = [handlerBlock copy];
+        transformQueue =
+            dispatch_queue_create("io.skygear.chat.cache.livequery", DISPATCH_QUEUE_SERIAL);
+        observedKeys = @[];
+        transformedObjectsByKey = @{};
+
+        __weak typeof(self) weakSelf = self;
+        notificationToken = [results addNotificationBlock:^(RLMResults *notifiedResults,
+                                                            RLMCollectionChange *change,
+                                                            NSError *error) {
+            [weakSelf handleResults:notifiedResults change:change error:error];
+        }];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [notificationToken invalidate];
+}
+
+- (void)invalidate
+{
+    invalidated = YES;
+    [notificationToken invalidate];
+    notificationToken = nil;
+    observedResults = nil;
+}
+
+- (void)handleResults:(RLMResults *)results
+               change:(RLMCollectionChange *)collectionChange
+                error:(NSError *)error
+{
+    if (error) {
+        SKYChatLogError(@"cache", @"Failed to observe cache: %@", error.localizedDescription);
+        [self invalidate];
+        return;
+    }
+
+    // Only the objects within the limit are read on the main thread, so the cost of a
+    // notification does not grow with the number of cached objects.
+    NSUInteger count = limit > 0 ? MIN(limit, results.count) : results.count;
+    NSMutableArray<NSString *> *keys = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        [keys addObject:results[i][primaryKey]];
+    }
+
+    // The modified indexes are looked up in both the previous and the new keys, which
+    // over-reports modifications when objects also move, but never misses one.
+    NSMutableSet<NSString *> *modifiedKeys = [NSMutableSet set];
+    for (NSNumber *index in collectionChange.modifications) {
+        NSUInteger i = index.unsignedIntegerValue;
+        if (i < observedKeys.count) {
+            [modifiedKeys addObject:observedKeys[i]];
+        }
+        if (i < keys.count) {
+            [modifiedKeys addObject:keys[i]];
+        }
+    }
+
+    // Realm objects cannot be passed across threads, so the inserted and modified objects are
+    // copied into unmanaged objects, which are decoded on the background queue.
+    NSSet<NSString *> *previousKeys = [NSSet setWithArray:observedKeys];
+    NSMutableDictionary<NSString *, RLMObject *> *detachedObjects =
+        [NSMutableDictionary dictionary];
+    [keys enumerateObjectsUsingBlock:^(NSString *key, NSUInteger index, BOOL *stop) {
+        if (collectionChange && [previousKeys containsObject:key] &&
+            ![modifiedKeys containsObject:key]) {
+            return;
+        }
+        RLMObject *object = results[index];
+        detachedObjects[key] = [[[object class] alloc] initWithValue:object];
+    }];
+    observedKeys = keys;
+
+    dispatch_async(transformQueue, ^{
+        [self transformObjectsWithKeys:keys detachedObjects:detachedObjects];
+    });
+}
+
+- (void)transformObjectsWithKeys:(NSArray<NSString *> *)keys
+                 detachedObjects:(NSDictionary<NSString *, RLMObject *> *)detachedObjects
+{
+    NSMutableDictionary<NSString *, id> *objectsByKey =
+        [NSMutableDictionary dictionaryWithCapacity:keys.count];
+    NSMutableArray *objects = [NSMutableArray arrayWithCapacity:keys.count];
+    NSMutableArray<NSString *> *objectKeys = [NSMutableArray arrayWithCapacity:keys.count];
+    for (NSString *key in keys) {
+        id object = nil;
+        RLMObject *detachedObject = detachedObjects[key];
+        if (detachedObject) {
+            object = transform(detachedObject);
+            if (!object) {
+                SKYChatLogWarning(@"cache", @"Skipped cached object %@ that failed to decode",
+                                  key);
+            }
+        } else {
+            object = transformedObjectsByKey[key];
+        }
+
+        if (object) {
+            objectsByKey[key] = object;
+            [objects addObject:object];
+            [objectKeys addObject:key];
+        }
+    }
+
+    NSArray<NSString *> *previousKeys = transformedKeys;
+    transformedKeys = objectKeys;
+    transformedObjectsByKey = objectsByKey;
+
+    SKYChatCacheChange *change = nil;
+    if (previousKeys) {
+        change = [self changeFromKeys:previousKeys
+                               toKeys:objectKeys
+                         modifiedKeys:[NSSet setWithArray:detachedObjects.allKeys]];
+        if (change && !change.deletions.count && !change.insertions.count &&
+            !change.modifications.count) {
+            return;
+        }
+    }
+
+    NSArray *snapshot = [objects copy];
+    dispatch_async(dispatch_get_main_queue(), ^{
+        if (self->invalidated) {
+            return;
+        }
+        self->_objects = snapshot;
+        self->handler(snapshot, change);
+    });
+}
+
+/**
+ Returns the change between the delivered results, or nil if the remaining objects are
+ reordered, in which case the result is delivered as a whole.
+ */
+- (SKYChatCacheChange *)changeFromKeys:(NSArray<NSString *> *)previousKeys
+                                toKeys:(NSArray<NSString *> *)keys
+                          modifiedKeys:(NSSet<NSString *> *)modifiedKeys
+{
+    NSSet<NSString *> *previousKeySet = [NSSet setWithArray:previousKeys];
+    NSSet<NSString *> *keySet = [NSSet setWithArray:keys];
+
+    NSMutableIndexSet *deletions = [NSMutableIndexSet indexSet];
+    NSMutableArray<NSString *> *remainingKeys = [NSMutableArray array];
+    [previousKeys enumerateObjectsUsingBlock:^(NSString *key, NSUInteger index, BOOL *stop) {
+        if ([keySet containsObject:key]) {
+            [remainingKeys addObject:key];
+        } else {
+            [deletions addIndex:index];
+        }
+    }];
+
+    NSMutableIndexSet *insertions = [NSMutableIndexSet indexSet];
+    NSMutableIndexSet *modifications = [NSMutableIndexSet indexSet];
+    NSMutableArray<NSString *> *keptKeys = [NSMutableArray array];
+    [keys enumerateObjectsUsingBlock:^(NSString *key, NSUInteger index, BOOL *stop) {
+        if (![previousKeySet containsObject:key]) {
+            [insertions addIndex:index];
+            return;
+        }
+        [keptKeys addObject:key];
+        if ([modifiedKeys containsObject:key]) {
+            [modifications addIndex:index];
+        }
+    }];
+
+    if (![remainingKeys isEqualToArray:keptKeys]) {
+        return nil;
+    }
+
+    return [[SKYChatCacheChange alloc] initWithDeletions:deletions
+                                              insertions:insertions
+                                           modifications:modifications];
+}
+
+@end
@@ -19,6 +19,8 @@
 
 #import <Realm/Realm.h>
 
+#import "SKYChatCacheLiveQuery.h"
+#import "SKYConversation.h"
 #import "SKYMessage.h"
 #import "SKYMessageOperation.h"
 #import "SKYParticipant.h"
@@ -29,22 +31,89 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (instancetype)initWithName:(NSString *)name;
 
+/**
+ Creates a store that is encrypted with the specified 64-byte key.
+
+ If the store file exists but is not encrypted, it is encrypted with the key before the store
+ is used.
+ */
+- (instancetype)initWithName:(NSString *)name encryptionKey:(NSData *_Nullable)encryptionKey;
+
 - (instancetype)initInMemoryWithName:(NSString *)name;
 
+/**
+ Keeps a Realm instance of this store open on the main thread, so that subsequent accesses
+ on the main thread do not reopen the Realm file.
+ */
+- (void)keepWarm;
+
+/**
+ Closes the Realm instance kept open by `-keepWarm`.
+ */
+- (void)closeWarmInstance;
+
+/**
+ Closes the Realm instance kept open by `-keepWarm` and deletes the files of this store on a
+ background queue, once no other Realm instance of this store is open. Opening a store with the
+ same name deletes the files right away instead. The store should not be used after calling
+ this method.
+ */
+- (void)deleteFilesInBackground;
+
 - (NSArray<SKYParticipant *> *)getParticipantsWithPredicate:(NSPredicate *)predicate;
 
 - (void)setParticipants:(NSArray<SKYParticipant *> *)participants;
 
+- (NSArray<SKYConversation *> *)getConversationsWithPredicate:(NSPredicate *)predicate
+                                                        limit:(NSInteger)limit;
+
+- (void)setConversations:(NSArray<SKYConversation *> *)conversations
+           startPosition:(NSInteger)startPosition;
+
+- (void)deleteConversations:(NSArray<SKYConversation *> *)conversations;
+
 - (NSArray<SKYMessage *> *)getMessagesWithPredicate:(NSPredicate *)predicate
                                               limit:(NSInteger)limit
                                               order:(NSString *)order;
 
+/**
+ Returns at most limit messages matching the predicate, taken from the lowest values of order
+ when ascending is YES. The returned messages are sorted in the same direction.
+ */
+- (NSArray<SKYMessage *> *)getMessagesWithPredicate:(NSPredicate *)predicate
+                                              limit:(NSInteger)limit
+                                              order:(NSString *)order
+                                          ascending:(BOOL)ascending;
+
 - (SKYMessage *)getMessageWithID:(NSString *)messageID;
 
 - (void)setMessages:(NSArray<SKYMessage *> *)messages;
 
 - (void)deleteMessages:(NSArray<SKYMessage *> *)messages;
 
+- (NSArray<SKYMessage *> *)searchMessagesWithTerms:(NSArray<NSString *> *)terms
+                                    conversationID:(NSString *_Nullable)conversationID
+                                             limit:(NSInteger)limit;
+
+/**
+ Observes the first messages matching the predicate up to the limit, sorted by the key path in
+ descending order. This must be called on the main thread.
+ */
+- (SKYChatCacheLiveQuery *)liveQueryForMessagesWithPredicate:(NSPredicate *)predicate
+                                                       order:(NSString *)order
+                                                       limit:(NSUInteger)limit
+                                                     handler:
+                                                         (SKYChatMessagesLiveQueryHandler)handler;
+
+/**
+ Observes the message operations matching the predicate, sorted by the key path in descending
+ order. This must be called on the main thread.
+ */
+- (SKYChatCacheLiveQuery *)
+liveQueryForMessageOperationsWithPredicate:(NSPredicate *)predicate
+                                     order:(NSString *)order
+                                   handler:(SKYChatMessageOperationsLiveQueryHandler)handler;
+
 - (NSArray<SKYMessageOperation *> *)getMessageOperationsWithPredicate:(NSPredicate *)predicate
                                                                 limit:(NSInteger)limit
                                                                 order:(NSString *)order;
@@ -55,6 +124,14 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (void)deleteMessageOperations:(NSArray<SKYMessageOperation *> *)messageOperations;
 
+/**
+ Saves the messages and the message operations, and deletes the other message operations, in a
+ single write transaction.
+ */
+- (void)setMessages:(NSArray<SKYMessage *> *)messages
+            messageOperations:(NSArray<SKYMessageOperation *> *)messageOperations
+    deletingMessageOperations:(NSArray<SKYMessageOperation *> *)deletedMessageOperations;
+
 - (void)failMessageOperationsWithPredicate:(NSPredicate *)predicate error:(NSError *)error;
 
 @end
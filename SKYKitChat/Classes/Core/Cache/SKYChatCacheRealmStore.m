@@ -20,13 +20,36 @@
 #import "SKYChatCacheRealmStore.h"
 #import "SKYChatCacheRealmStore+Private.h"
 
+#import "SKYChatCacheLiveQuery+Private.h"
+#import "SKYChatLogger.h"
+#import "SKYChatMetrics.h"
+
+#import "SKYConversationCacheObject.h"
 #import "SKYMessageCacheObject.h"
 #import "SKYMessageOperationCacheObject.h"
+#import "SKYMessageSearchTermCacheObject.h"
 #import "SKYParticipantCacheObject.h"
 
-@implementation SKYChatCacheRealmStore
+// When only a few messages are left after matching the rarest terms, the
+// remaining terms are looked up for those messages only.
+static NSUInteger SKYChatSearchCandidateLookupThreshold = 64;
+
+// Realm does not delete the files of a Realm that is still open on another thread, so the
+// deletion of a removed store is retried until those instances are released.
+static NSInteger SKYChatCacheFileDeletionAttempts = 5;
+static NSTimeInterval SKYChatCacheFileDeletionRetryInterval = 1;
+
+@implementation SKYChatCacheRealmStore {
+    RLMRealm *warmRealmInstance;
+    RLMRealm *inMemoryRealmInstance;
+}
 
 - (instancetype)initWithName:(NSString *)name
+{
+    return [self initWithName:name encryptionKey:nil];
+}
+
+- (instancetype)initWithName:(NSString *)name encryptionKey:(NSData *)encryptionKey
 {
     self = [super init];
     if (!self)
@@ -37,13 +60,75 @@
     NSURL *url = [NSURL URLWithString:[dir stringByAppendingPathComponent:name]];
 
     self.realmConfig = [RLMRealmConfiguration defaultConfiguration];
-    self.realmConfig.schemaVersion = 2;
+    self.realmConfig.schemaVersion = 5;
     self.realmConfig.migrationBlock = ^(RLMMigration *migration, uint64_t oldSchemaVersion) {
+        if (oldSchemaVersion < 5) {
+            // The index is rebuilt in version 5 to include single CJK characters.
+            [migration deleteDataForClassName:[SKYMessageSearchTermCacheObject className]];
+            [SKYChatCacheRealmStore migrateMessageSearchIndex:migration];
+        }
     };
     self.realmConfig.fileURL = url;
+
+    // A removed store with the same name may be waiting for deletion. Its files are deleted
+    // now, so that they are not deleted under this store later.
+    [SKYChatCacheRealmStore deletePendingFilesWithConfiguration:self.realmConfig];
+
+    if (encryptionKey) {
+        [self encryptExistingFileWithKey:encryptionKey];
+        self.realmConfig.encryptionKey = encryptionKey;
+    }
     return self;
 }
 
+- (void)encryptExistingFileWithKey:(NSData *)encryptionKey
+{
+    NSString *path = self.realmConfig.fileURL.path;
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    if (![fileManager fileExistsAtPath:path]) {
+        return;
+    }
+
+    RLMRealmConfiguration *encryptedConfig = [self.realmConfig copy];
+    encryptedConfig.encryptionKey = encryptionKey;
+    NSString *encryptedPath = [path stringByAppendingString:@".encrypted"];
+
+    NSError *error = nil;
+    BOOL copied = NO;
+    @autoreleasepool {
+        if ([RLMRealm realmWithConfiguration:encryptedConfig error:nil]) {
+            return;
+        }
+
+        // The file cannot be opened with the key, so it is expected to be a store created
+        // before encryption is enabled. Write an encrypted copy and replace the file with it.
+        [fileManager removeItemAtPath:encryptedPath error:nil];
+        RLMRealm *realm = [RLMRealm realmWithConfiguration:self.realmConfig error:&error];
+        copied = [realm writeCopyToURL:[NSURL fileURLWithPath:encryptedPath]
+                         encryptionKey:encryptionKey
+                                 error:&error];
+    }
+
+    // Cached data can be fetched again, so the file is discarded if it cannot be encrypted.
+    NSError *deleteError = nil;
+    [RLMRealm deleteFilesForConfiguration:self.realmConfig error:&deleteError];
+    if (deleteError) {
+        SKYChatLogError(@"cache", @"Failed to delete unencrypted cache: %@",
+                        deleteError.localizedDescription);
+    }
+    if (!copied) {
+        SKYChatLogWarning(@"cache", @"Failed to encrypt cache, discarding it: %@",
+                          error.localizedDescription);
+        return;
+    }
+
+    if (![fileManager moveItemAtPath:encryptedPath toPath:path error:&error]) {
+        SKYChatLogWarning(@"cache", @"Failed to replace cache with encrypted copy: %@",
+                          error.localizedDescription);
+        [fileManager removeItemAtPath:encryptedPath error:nil];
+    }
+}
+
 - (instancetype)initInMemoryWithName:(NSString *)name
 {
     self = [super init];
@@ -53,9 +138,37 @@
     self.realmConfig = [RLMRealmConfiguration defaultConfiguration];
     self.realmConfig.inMemoryIdentifier = name;
 
+    // An in-memory Realm discards its data once all of its instances are closed, so an
+    // instance is held for the lifetime of the store. It is never used for access.
+    inMemoryRealmInstance = self.realmInstance;
+
     return self;
 }
 
++ (void)migrateMessageSearchIndex:(RLMMigration *)migration
+{
+    // Index the messages cached before the current search index is introduced.
+    [migration
+        enumerateObjects:[SKYMessageCacheObject className]
+                   block:^(RLMObject *oldObject, RLMObject *newObject) {
+                       if ([newObject[@"deleted"] boolValue]) {
+                           return;
+                       }
+                       SKYRecord *record =
+                           [NSKeyedUnarchiver unarchiveObjectWithData:newObject[@"recordData"]];
+                       NSArray<SKYMessageSearchTermCacheObject *> *termObjects =
+                           [SKYMessageSearchTermCacheObject
+                               cacheObjectsWithBody:record[@"body"]
+                                          messageID:newObject[@"recordID"]
+                                     conversationID:newObject[@"conversationID"]
+                                       creationDate:newObject[@"creationDate"]];
+                       for (SKYMessageSearchTermCacheObject *termObject in termObjects) {
+                           [migration createObject:[SKYMessageSearchTermCacheObject className]
+                                         withValue:termObject];
+                       }
+                   }];
+}
+
 - (RLMRealm *)realmInstance
 {
     // create realm instance for each access, prevent cross thread access
@@ -63,13 +176,161 @@
     RLMRealm *realmInstance = [RLMRealm realmWithConfiguration:self.realmConfig error:&error];
 
     if (error) {
-        NSLog(@"Failed to create Realm instance: %@", error.localizedDescription);
+        SKYChatLogError(@"cache", @"Failed to create Realm instance: %@",
+                        error.localizedDescription);
         return nil;
     }
 
     return realmInstance;
 }
 
+- (void)keepWarm
+{
+    dispatch_block_t openRealm = ^{
+        if (!self->warmRealmInstance) {
+            self->warmRealmInstance = self.realmInstance;
+        }
+    };
+
+    if ([NSThread isMainThread]) {
+        openRealm();
+    } else {
+        dispatch_async(dispatch_get_main_queue(), openRealm);
+    }
+}
+
+- (void)closeWarmInstance
+{
+    if ([NSThread isMainThread]) {
+        warmRealmInstance = nil;
+    } else {
+        dispatch_async(dispatch_get_main_queue(), ^{
+            self->warmRealmInstance = nil;
+        });
+    }
+}
+
+- (void)deleteFilesInBackground
+{
+    RLMRealmConfiguration *config = self.realmConfig;
+    NSString *path = config.fileURL.path;
+    if (path) {
+        NSMutableSet<NSString *> *pendingPaths = [SKYChatCacheRealmStore pendingDeletionPaths];
+        @synchronized(pendingPaths) {
+            [pendingPaths addObject:path];
+        }
+    }
+
+    // The warm instance is closed on the main thread before the deletion is queued, as
+    // Realm refuses to delete the files of an open Realm.
+    dispatch_block_t closeAndDelete = ^{
+        self->warmRealmInstance = nil;
+        if (!path) {
+            return;
+        }
+        dispatch_async([SKYChatCacheRealmStore fileDeletionQueue], ^{
+            [SKYChatCacheRealmStore deleteFilesWithConfiguration:config
+                                               remainingAttempts:SKYChatCacheFileDeletionAttempts];
+        });
+    };
+
+    if ([NSThread isMainThread]) {
+        closeAndDelete();
+    } else {
+        dispatch_async(dispatch_get_main_queue(), closeAndDelete);
+    }
+}
+
++ (void)deleteFilesWithConfiguration:(RLMRealmConfiguration *)config
+                   remainingAttempts:(NSInteger)remainingAttempts
+{
+    if ([self deleteFilesIfPendingWithConfiguration:config]) {
+        return;
+    }
+
+    if (remainingAttempts <= 1) {
+        SKYChatLogWarning(@"cache", @"Cache %@ is still open, not deleting it",
+                          config.fileURL.lastPathComponent);
+        [self cancelFileDeletionWithConfiguration:config];
+        return;
+    }
+
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW,
+                                 (int64_t)(SKYChatCacheFileDeletionRetryInterval * NSEC_PER_SEC)),
+                   [self fileDeletionQueue], ^{
+                       [self deleteFilesWithConfiguration:config
+                                        remainingAttempts:remainingAttempts - 1];
+                   });
+}
+
++ (void)deletePendingFilesWithConfiguration:(RLMRealmConfiguration *)config
+{
+    if (![self deleteFilesIfPendingWithConfiguration:config]) {
+        SKYChatLogWarning(@"cache", @"Removed cache %@ is still open, reusing it",
+                          config.fileURL.lastPathComponent);
+        [self cancelFileDeletionWithConfiguration:config];
+    }
+}
+
+/**
+ Deletes the files of a removed store, unless they are still open. Returns NO if the files
+ are still open and remain pending for deletion.
+ */
++ (BOOL)deleteFilesIfPendingWithConfiguration:(RLMRealmConfiguration *)config
+{
+    NSString *path = config.fileURL.path;
+    NSMutableSet<NSString *> *pendingPaths = [self pendingDeletionPaths];
+    @synchronized(pendingPaths) {
+        if (!path || ![pendingPaths containsObject:path]) {
+            return YES;
+        }
+
+        NSError *error = nil;
+        [RLMRealm deleteFilesForConfiguration:config error:&error];
+        if ([error.domain isEqualToString:RLMErrorDomain] && error.code == RLMErrorAlreadyOpen) {
+            return NO;
+        }
+        if (error) {
+            SKYChatLogError(@"cache", @"Failed to delete cache %@: %@", path.lastPathComponent,
+                            error.localizedDescription);
+        }
+        [pendingPaths removeObject:path];
+        return YES;
+    }
+}
+
++ (void)cancelFileDeletionWithConfiguration:(RLMRealmConfiguration *)config
+{
+    NSMutableSet<NSString *> *pendingPaths = [self pendingDeletionPaths];
+    @synchronized(pendingPaths) {
+        [pendingPaths removeObject:config.fileURL.path];
+    }
+}
+
++ (NSMutableSet<NSString *> *)pendingDeletionPaths
+{
+    static dispatch_once_t onceToken;
+    static NSMutableSet<NSString *> *paths;
+    dispatch_once(&onceToken, ^{
+        paths = [NSMutableSet set];
+    });
+
+    return paths;
+}
+
++ (dispatch_queue_t)fileDeletionQueue
+{
+    static dispatch_once_t onceToken;
+    static dispatch_queue_t queue;
+    dispatch_once(&onceToken, ^{
+        queue = dispatch_queue_create("io.skygear.chat.cache.deletion", DISPATCH_QUEUE_SERIAL);
+        dispatch_set_target_queue(queue,
+                                  dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0));
+    });
+
+    return queue;
+}
+
 - (NSArray<SKYParticipant *> *)getParticipantsWithPredicate:(NSPredicate *)predicate
 {
     RLMRealm *realmInstance = self.realmInstance;
@@ -101,15 +362,91 @@
     [realmInstance commitWriteTransaction];
 }
 
+#pragma mark - Conversations
+
+- (NSArray<SKYConversation *> *)getConversationsWithPredicate:(NSPredicate *)predicate
+                                                        limit:(NSInteger)limit
+{
+    SKYChatMetricsSpan *span =
+        [[SKYChatMetrics sharedMetrics] beginSpanWithName:@"cache.getConversations"];
+
+    RLMRealm *realmInstance = self.realmInstance;
+    RLMResults<SKYConversationCacheObject *> *results =
+        [[SKYConversationCacheObject objectsInRealm:realmInstance withPredicate:predicate]
+            sortedResultsUsingKeyPath:@"position"
+                            ascending:YES];
+    NSMutableArray<SKYConversation *> *conversations =
+        [NSMutableArray arrayWithCapacity:results.count];
+
+    NSUInteger resultCount = results.count;
+
+    for (NSInteger i = 0; (limit == -1 || i < limit) && i < resultCount; i++) {
+        SKYConversationCacheObject *cacheObject = results[i];
+        SKYConversation *conversation = [cacheObject conversationRecord];
+        [conversations addObject:conversation];
+    }
+
+    [span end];
+    return [conversations copy];
+}
+
+- (void)setConversations:(NSArray<SKYConversation *> *)conversations
+           startPosition:(NSInteger)startPosition
+{
+    RLMRealm *realmInstance = self.realmInstance;
+    [realmInstance beginWriteTransaction];
+
+    [conversations enumerateObjectsUsingBlock:^(SKYConversation *conversation, NSUInteger idx,
+                                                BOOL *stop) {
+        SKYConversationCacheObject *cacheObject =
+            [SKYConversationCacheObject cacheObjectFromConversation:conversation
+                                                           position:startPosition + idx];
+        [realmInstance addOrUpdateObject:cacheObject];
+    }];
+
+    [realmInstance commitWriteTransaction];
+}
+
+- (void)deleteConversations:(NSArray<SKYConversation *> *)conversations
+{
+    RLMRealm *realmInstance = self.realmInstance;
+    [realmInstance beginWriteTransaction];
+
+    for (SKYConversation *conversation in conversations) {
+        SKYConversationCacheObject *cacheObject =
+            [SKYConversationCacheObject objectInRealm:realmInstance
+                                        forPrimaryKey:conversation.recordName];
+
+        if (cacheObject) {
+            [realmInstance deleteObject:cacheObject];
+        }
+    }
+
+    [realmInstance commitWriteTransaction];
+}
+
+#pragma mark - Messages
+
+- (NSArray<SKYMessage *> *)getMessagesWithPredicate:(NSPredicate *)predicate
+                                              limit:(NSInteger)limit
+                                              order:(NSString *)order
+{
+    return [self getMessagesWithPredicate:predicate limit:limit order:order ascending:NO];
+}
+
 - (NSArray<SKYMessage *> *)getMessagesWithPredicate:(NSPredicate *)predicate
                                               limit:(NSInteger)limit
                                               order:(NSString *)order
+                                          ascending:(BOOL)ascending
 {
+    SKYChatMetricsSpan *span =
+        [[SKYChatMetrics sharedMetrics] beginSpanWithName:@"cache.getMessages"];
+
     RLMRealm *realmInstance = self.realmInstance;
     RLMResults<SKYMessageCacheObject *> *results =
         [[SKYMessageCacheObject objectsInRealm:realmInstance withPredicate:predicate]
             sortedResultsUsingKeyPath:order
-                            ascending:NO];
+                            ascending:ascending];
     NSMutableArray<SKYMessage *> *messages = [NSMutableArray arrayWithCapacity:results.count];
 
     NSUInteger resultCount = results.count;
@@ -120,6 +457,7 @@
         [messages addObject:message];
     }
 
+    [span end];
     return [messages copy];
 }
 
@@ -133,15 +471,43 @@
 
 - (void)setMessages:(NSArray<SKYMessage *> *)messages
 {
+    SKYChatMetricsSpan *span =
+        [[SKYChatMetrics sharedMetrics] beginSpanWithName:@"cache.setMessages"];
+
     RLMRealm *realmInstance = self.realmInstance;
     [realmInstance beginWriteTransaction];
+    [self setMessages:messages inRealm:realmInstance];
+    [realmInstance commitWriteTransaction];
 
+    [span end];
+}
+
+- (void)setMessages:(NSArray<SKYMessage *> *)messages inRealm:(RLMRealm *)realmInstance
+{
     for (SKYMessage *message in messages) {
         SKYMessageCacheObject *cacheObject = [SKYMessageCacheObject cacheObjectFromMessage:message];
+        SKYMessageCacheObject *existingObject =
+            [SKYMessageCacheObject objectInRealm:realmInstance forPrimaryKey:cacheObject.recordID];
+
+        // The body can only change by editing or deleting the message, so
+        // the search index is not rebuilt when the message is saved again.
+        BOOL needsIndex = !existingObject || existingObject.deleted != cacheObject.deleted ||
+                          (existingObject.editionDate != cacheObject.editionDate &&
+                           ![existingObject.editionDate isEqualToDate:cacheObject.editionDate]);
+        if (needsIndex) {
+            [self deleteSearchIndexWithMessageID:cacheObject.recordID inRealm:realmInstance];
+            if (!cacheObject.deleted) {
+                [realmInstance
+                    addObjects:[SKYMessageSearchTermCacheObject
+                                   cacheObjectsWithBody:message.body
+                                              messageID:cacheObject.recordID
+                                         conversationID:cacheObject.conversationID
+                                           creationDate:cacheObject.creationDate]];
+            }
+        }
+
         [realmInstance addOrUpdateObject:cacheObject];
     }
-
-    [realmInstance commitWriteTransaction];
 }
 
 - (void)deleteMessages:(NSArray<SKYMessage *> *)messages
@@ -157,13 +523,166 @@
         if (cacheObject) {
             [realmInstance deleteObject:cacheObject];
         }
+        [self deleteSearchIndexWithMessageID:message.recordID.recordName inRealm:realmInstance];
     }
 
     [realmInstance commitWriteTransaction];
 }
 
+#pragma mark - Message Search
+
+- (void)deleteSearchIndexWithMessageID:(NSString *)messageID inRealm:(RLMRealm *)realmInstance
+{
+    RLMResults<SKYMessageSearchTermCacheObject *> *termObjects =
+        [SKYMessageSearchTermCacheObject objectsInRealm:realmInstance
+                                                  where:@"messageID == %@", messageID];
+    [realmInstance deleteObjects:termObjects];
+}
+
+- (NSArray<SKYMessage *> *)searchMessagesWithTerms:(NSArray<NSString *> *)terms
+                                    conversationID:(NSString *)conversationID
+                                             limit:(NSInteger)limit
+{
+    if (!terms.count) {
+        return @[];
+    }
+
+    SKYChatMetricsSpan *span =
+        [[SKYChatMetrics sharedMetrics] beginSpanWithName:@"cache.searchMessages"];
+    RLMRealm *realmInstance = self.realmInstance;
+
+    NSMutableArray<RLMResults<SKYMessageSearchTermCacheObject *> *> *termResults =
+        [NSMutableArray arrayWithCapacity:terms.count];
+    for (NSString *term in terms) {
+        NSPredicate *predicate =
+            conversationID
+                ? [NSPredicate predicateWithFormat:@"term == %@ AND conversationID == %@", term,
+                                                   conversationID]
+                : [NSPredicate predicateWithFormat:@"term == %@", term];
+        RLMResults<SKYMessageSearchTermCacheObject *> *results =
+            [SKYMessageSearchTermCacheObject objectsInRealm:realmInstance withPredicate:predicate];
+        if (results.count == 0) {
+            // Every term has to be matched.
+            [span end];
+            return @[];
+        }
+        [termResults addObject:results];
+    }
+
+    // Start from the rarest term so that the candidates are the fewest.
+    [termResults sortUsingComparator:^NSComparisonResult(RLMResults *r1, RLMResults *r2) {
+        return [@(r1.count) compare:@(r2.count)];
+    }];
+
+    double messageCount = MAX([SKYMessageCacheObject allObjectsInRealm:realmInstance].count, 1);
+    NSMutableDictionary<NSString *, NSNumber *> *scores = nil;
+    NSMutableDictionary<NSString *, NSDate *> *dates = [NSMutableDictionary dictionary];
+
+    for (RLMResults<SKYMessageSearchTermCacheObject *> *results in termResults) {
+        double idf = log(1 + messageCount / results.count);
+        RLMResults<SKYMessageSearchTermCacheObject *> *candidateResults = results;
+        if (scores && scores.count <= SKYChatSearchCandidateLookupThreshold) {
+            candidateResults = [results objectsWhere:@"messageID IN %@", scores.allKeys];
+        }
+
+        NSMutableDictionary<NSString *, NSNumber *> *matchedScores =
+            [NSMutableDictionary dictionaryWithCapacity:MIN(candidateResults.count, 1024)];
+        for (SKYMessageSearchTermCacheObject *termObject in candidateResults) {
+            NSString *messageID = termObject.messageID;
+            NSNumber *score = scores ? scores[messageID] : @0;
+            if (!score) {
+                continue;
+            }
+            matchedScores[messageID] = @(score.doubleValue + (1 + log(termObject.frequency)) * idf);
+            if (!scores && termObject.creationDate) {
+                dates[messageID] = termObject.creationDate;
+            }
+        }
+
+        scores = matchedScores;
+        if (!scores.count) {
+            [span end];
+            return @[];
+        }
+    }
+
+    NSArray<NSString *> *rankedIDs =
+        [scores.allKeys sortedArrayUsingComparator:^NSComparisonResult(NSString *id1, NSString *id2) {
+            NSComparisonResult result = [scores[id2] compare:scores[id1]];
+            if (result != NSOrderedSame) {
+                return result;
+            }
+            // More recent messages are ranked first for the same score.
+            NSDate *date1 = dates[id1] ?: [NSDate distantPast];
+            NSDate *date2 = dates[id2] ?: [NSDate distantPast];
+            return [date2 compare:date1];
+        }];
+    if (limit >= 0 && rankedIDs.count > (NSUInteger)limit) {
+        rankedIDs = [rankedIDs subarrayWithRange:NSMakeRange(0, limit)];
+    }
+
+    RLMResults<SKYMessageCacheObject *> *messageObjects =
+        [SKYMessageCacheObject objectsInRealm:realmInstance
+                                        where:@"recordID IN %@ AND deleted == FALSE", rankedIDs];
+    NSMutableDictionary<NSString *, SKYMessage *> *messagesByID =
+        [NSMutableDictionary dictionaryWithCapacity:messageObjects.count];
+    for (SKYMessageCacheObject *cacheObject in messageObjects) {
+        messagesByID[cacheObject.recordID] = [cacheObject messageRecord];
+    }
+
+    NSMutableArray<SKYMessage *> *messages = [NSMutableArray arrayWithCapacity:rankedIDs.count];
+    for (NSString *messageID in rankedIDs) {
+        SKYMessage *message = messagesByID[messageID];
+        if (message) {
+            [messages addObject:message];
+        }
+    }
+
+    [span end];
+    return [messages copy];
+}
+
 #pragma mark - Message Operations
 
+- (SKYChatCacheLiveQuery *)liveQueryForMessagesWithPredicate:(NSPredicate *)predicate
+                                                       order:(NSString *)order
+                                                       limit:(NSUInteger)limit
+                                                     handler:
+                                                         (SKYChatMessagesLiveQueryHandler)handler
+{
+    RLMResults<SKYMessageCacheObject *> *results =
+        [[SKYMessageCacheObject objectsInRealm:self.realmInstance withPredicate:predicate]
+            sortedResultsUsingKeyPath:order
+                            ascending:NO];
+    return [[SKYChatCacheLiveQuery alloc] initWithResults:results
+        limit:limit
+        transform:^id(RLMObject *cacheObject) {
+            return [(SKYMessageCacheObject *)cacheObject messageRecord];
+        }
+        handler:^(NSArray *objects, SKYChatCacheChange *change) {
+            handler(objects, change);
+        }];
+}
+
+- (SKYChatCacheLiveQuery *)
+liveQueryForMessageOperationsWithPredicate:(NSPredicate *)predicate
+                                     order:(NSString *)order
+                                   handler:(SKYChatMessageOperationsLiveQueryHandler)handler
+{
+    RLMResults<SKYMessageOperationCacheObject *> *results =
+        [[SKYMessageOperationCacheObject objectsInRealm:self.realmInstance withPredicate:predicate]
+            sortedResultsUsingKeyPath:order
+                            ascending:NO];
+    return [[SKYChatCacheLiveQuery alloc] initWithResults:results
+        limit:0
+        transform:^id(RLMObject *cacheObject) {
+            return [(SKYMessageOperationCacheObject *)cacheObject messageOperation];
+        }
+        handler:^(NSArray *objects, SKYChatCacheChange *change) {
+            handler(objects, change);
+        }];
+}
+
 - (NSArray<SKYMessageOperation *> *)getMessageOperationsWithPredicate:(NSPredicate *)predicate
                                                                 limit:(NSInteger)limit
                                                                 order:(NSString *)order
@@ -199,21 +718,31 @@
 {
     RLMRealm *realmInstance = self.realmInstance;
     [realmInstance beginWriteTransaction];
+    [self setMessageOperations:messageOperations inRealm:realmInstance];
+    [realmInstance commitWriteTransaction];
+}
 
+- (void)setMessageOperations:(NSArray<SKYMessageOperation *> *)messageOperations
+                     inRealm:(RLMRealm *)realmInstance
+{
     for (SKYMessageOperation *operation in messageOperations) {
         SKYMessageOperationCacheObject *cacheObject =
             [SKYMessageOperationCacheObject cacheObjectFromMessageOperation:operation];
         [realmInstance addOrUpdateObject:cacheObject];
     }
-
-    [realmInstance commitWriteTransaction];
 }
 
 - (void)deleteMessageOperations:(NSArray<SKYMessageOperation *> *)messageOperations
 {
     RLMRealm *realmInstance = self.realmInstance;
     [realmInstance beginWriteTransaction];
+    [self deleteMessageOperations:messageOperations inRealm:realmInstance];
+    [realmInstance commitWriteTransaction];
+}
 
+- (void)deleteMessageOperations:(NSArray<SKYMessageOperation *> *)messageOperations
+                        inRealm:(RLMRealm *)realmInstance
+{
     for (SKYMessageOperation *operation in messageOperations) {
         SKYMessageOperationCacheObject *cacheObject =
             [SKYMessageOperationCacheObject objectInRealm:realmInstance
@@ -223,8 +752,23 @@
             [realmInstance deleteObject:cacheObject];
         }
     }
+}
 
+- (void)setMessages:(NSArray<SKYMessage *> *)messages
+            messageOperations:(NSArray<SKYMessageOperation *> *)messageOperations
+    deletingMessageOperations:(NSArray<SKYMessageOperation *> *)deletedMessageOperations
+{
+    SKYChatMetricsSpan *span =
+        [[SKYChatMetrics sharedMetrics] beginSpanWithName:@"cache.setMessages"];
+
+    RLMRealm *realmInstance = self.realmInstance;
+    [realmInstance beginWriteTransaction];
+    [self setMessages:messages inRealm:realmInstance];
+    [self setMessageOperations:messageOperations inRealm:realmInstance];
+    [self deleteMessageOperations:deletedMessageOperations inRealm:realmInstance];
     [realmInstance commitWriteTransaction];
+
+    [span end];
 }
 
 - (void)failMessageOperationsWithPredicate:(NSPredicate *)predicate error:(NSError *)error
@@ -0,0 +1,46 @@
+//
+//  SKYChatSearchTokenizer.h
+//  SKYKitChat
+//
+//  Copyright 2016 Oursky Ltd.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ SKYChatSearchTokenizer splits text into terms for the message search index.
+
+ Text is folded to be case, diacritic and width insensitive. Words are split by the word
+ boundaries of the text, except that runs of CJK characters are split into overlapping bigrams,
+ because CJK text is not delimited by spaces. Indexed text also has the single characters of
+ CJK runs, so that a query of one character matches it.
+ */
+@interface SKYChatSearchTokenizer : NSObject
+
+/**
+ Returns the terms of the text to be indexed, mapped to the number of occurrences.
+ */
++ (NSDictionary<NSString *, NSNumber *> *)termFrequenciesWithText:(NSString *)text;
+
+/**
+ Returns the distinct terms of the text to be searched.
+ */
++ (NSArray<NSString *> *)termsWithText:(NSString *)text;
+
+@end
+
+NS_ASSUME_NONNULL_END
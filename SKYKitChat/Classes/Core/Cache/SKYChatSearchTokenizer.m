@@ -0,0 +1,131 @@
+//
+//  SKYChatSearchTokenizer.m
+//  SKYKitChat
+//
+//  Copyright 2016 Oursky Ltd.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "SKYChatSearchTokenizer.h"
+
+static BOOL SKYChatSearchIsCJKCharacter(unichar c)
+{
+    return (c >= 0x3040 && c <= 0x30FF)     // Hiragana and Katakana
+           || (c >= 0x3400 && c <= 0x4DBF)  // CJK Unified Ideographs Extension A
+           || (c >= 0x4E00 && c <= 0x9FFF)  // CJK Unified Ideographs
+           || (c >= 0xAC00 && c <= 0xD7AF)  // Hangul Syllables
+           || (c >= 0xF900 && c <= 0xFAFF); // CJK Compatibility Ideographs
+}
+
+@implementation SKYChatSearchTokenizer
+
++ (NSDictionary<NSString *, NSNumber *> *)termFrequenciesWithText:(NSString *)text
+{
+    NSMutableDictionary<NSString *, NSNumber *> *frequencies = [NSMutableDictionary dictionary];
+    [self enumerateTermsWithText:text
+                includesUnigrams:YES
+                           block:^(NSString *term) {
+                               frequencies[term] = @(frequencies[term].integerValue + 1);
+                           }];
+    return frequencies;
+}
+
++ (NSArray<NSString *> *)termsWithText:(NSString *)text
+{
+    NSMutableOrderedSet<NSString *> *terms = [NSMutableOrderedSet orderedSet];
+    [self enumerateTermsWithText:text
+                includesUnigrams:NO
+                           block:^(NSString *term) {
+                               [terms addObject:term];
+                           }];
+    return terms.array;
+}
+
++ (void)enumerateTermsWithText:(NSString *)text
+              includesUnigrams:(BOOL)includesUnigrams
+                         block:(void (^)(NSString *term))block
+{
+    if (!text.length) {
+        return;
+    }
+
+    NSString *folded = [text stringByFoldingWithOptions:NSCaseInsensitiveSearch |
+                                                        NSDiacriticInsensitiveSearch |
+                                                        NSWidthInsensitiveSearch
+                                                 locale:nil];
+    folded = [folded lowercaseString];
+
+    // Split the text into runs of CJK and non-CJK characters. Each run is
+    // tokenized separately.
+    NSUInteger length = folded.length;
+    NSUInteger runStart = 0;
+    BOOL isCJKRun = NO;
+    for (NSUInteger i = 0; i <= length; i++) {
+        BOOL isCJK = i < length && SKYChatSearchIsCJKCharacter([folded characterAtIndex:i]);
+        if (i < length && (i == runStart || isCJK == isCJKRun)) {
+            isCJKRun = isCJK;
+            continue;
+        }
+
+        NSRange runRange = NSMakeRange(runStart, i - runStart);
+        if (isCJKRun) {
+            [self enumerateBigramsInString:folded
+                                     range:runRange
+                          includesUnigrams:includesUnigrams
+                                     block:block];
+        } else {
+            [self enumerateWordsInString:folded range:runRange block:block];
+        }
+        runStart = i;
+        isCJKRun = isCJK;
+    }
+}
+
++ (void)enumerateWordsInString:(NSString *)string
+                         range:(NSRange)range
+                         block:(void (^)(NSString *term))block
+{
+    [string enumerateSubstringsInRange:range
+                               options:NSStringEnumerationByWords
+                            usingBlock:^(NSString *word, NSRange wordRange,
+                                         NSRange enclosingRange, BOOL *stop) {
+                                if (word.length) {
+                                    block(word);
+                                }
+                            }];
+}
+
++ (void)enumerateBigramsInString:(NSString *)string
+                           range:(NSRange)range
+                includesUnigrams:(BOOL)includesUnigrams
+                           block:(void (^)(NSString *term))block
+{
+    if (range.length == 1) {
+        block([string substringWithRange:range]);
+        return;
+    }
+
+    for (NSUInteger i = range.location; i < NSMaxRange(range); i++) {
+        // A query of a single character is a unigram, so unigrams are indexed for it to
+        // match the character inside a longer run.
+        if (includesUnigrams) {
+            block([string substringWithRange:NSMakeRange(i, 1)]);
+        }
+        if (i + 1 < NSMaxRange(range)) {
+            block([string substringWithRange:NSMakeRange(i, 2)]);
+        }
+    }
+}
+
+@end
@@ -0,0 +1,48 @@
+//
+//  SKYConversationCacheObject.m
+//  SKYKitChat
+//
+//  Copyright 2016 Oursky Ltd.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "SKYConversationCacheObject.h"
+
+@implementation SKYConversationCacheObject
+
++ (NSString *)primaryKey
+{
+    return @"recordID";
+}
+
++ (SKYConversationCacheObject *)cacheObjectFromConversation:(SKYConversation *)conversation
+                                                   position:(NSInteger)position
+{
+    SKYConversationCacheObject *cacheObject = [[SKYConversationCacheObject alloc] init];
+    cacheObject.recordID = conversation.recordName;
+    cacheObject.position = position;
+    cacheObject.recordData = [NSKeyedArchiver archivedDataWithRootObject:conversation.record];
+
+    return cacheObject;
+}
+
+- (SKYConversation *)conversationRecord
+{
+    SKYRecord *record = [NSKeyedUnarchiver unarchiveObjectWithData:self.recordData];
+    SKYConversation *conversation = [SKYConversation recordWithRecord:record];
+
+    return conversation;
+}
+
+@end
@@ -0,0 +1,46 @@
+//
+//  SKYMessageSearchTermCacheObject.h
+//  SKYKitChat
+//
+//  Copyright 2016 Oursky Ltd.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <Realm/Realm.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ SKYMessageSearchTermCacheObject is an entry of the message search index, which records the
+ number of occurrences of a term in a message.
+ */
+@interface SKYMessageSearchTermCacheObject : RLMObject
+
+@property NSString *term;
+@property NSString *messageID;
+@property NSString *_Nullable conversationID;
+@property NSDate *_Nullable creationDate;
+@property NSInteger frequency;
+
+/**
+ Returns the index entries of the terms in the body of a message.
+ */
++ (NSArray<SKYMessageSearchTermCacheObject *> *)cacheObjectsWithBody:(NSString *_Nullable)body
+                                                          messageID:(NSString *)messageID
+                                                     conversationID:(NSString *_Nullable)conversationID
+                                                       creationDate:(NSDate *_Nullable)creationDate;
+
+@end
+
+NS_ASSUME_NONNULL_END
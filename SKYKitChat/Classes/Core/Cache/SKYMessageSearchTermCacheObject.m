@@ -0,0 +1,54 @@
+//
+//  SKYMessageSearchTermCacheObject.m
+//  SKYKitChat
+//
+//  Copyright 2016 Oursky Ltd.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "SKYMessageSearchTermCacheObject.h"
+
+#import "SKYChatSearchTokenizer.h"
+
+@implementation SKYMessageSearchTermCacheObject
+
++ (NSArray<NSString *> *)indexedProperties
+{
+    return @[ @"term", @"messageID" ];
+}
+
++ (NSArray<SKYMessageSearchTermCacheObject *> *)cacheObjectsWithBody:(NSString *)body
+                                                          messageID:(NSString *)messageID
+                                                     conversationID:(NSString *)conversationID
+                                                       creationDate:(NSDate *)creationDate
+{
+    NSDictionary<NSString *, NSNumber *> *frequencies =
+        [SKYChatSearchTokenizer termFrequenciesWithText:body];
+    NSMutableArray<SKYMessageSearchTermCacheObject *> *cacheObjects =
+        [NSMutableArray arrayWithCapacity:frequencies.count];
+    [frequencies enumerateKeysAndObjectsUsingBlock:^(NSString *term, NSNumber *frequency,
+                                                     BOOL *stop) {
+        SKYMessageSearchTermCacheObject *cacheObject =
+            [[SKYMessageSearchTermCacheObject alloc] init];
+        cacheObject.term = term;
+        cacheObject.messageID = messageID;
+        cacheObject.conversationID = conversationID;
+        cacheObject.creationDate = creationDate;
+        cacheObject.frequency = frequency.integerValue;
+        [cacheObjects addObject:cacheObject];
+    }];
+    return cacheObjects;
+}
+
+@end
@@ -24,6 +24,8 @@
 NS_ASSUME_NONNULL_BEGIN
 
 extern NSString *const SKYMessageTypeMetadataKey;
+extern NSString *const SKYMessageStatusKey;
+extern NSString *const SKYMessageDeletedKey;
 
 @class SKYReference;
 
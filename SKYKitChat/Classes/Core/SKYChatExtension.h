@@ -19,6 +19,7 @@
 
 #import <SKYKit/SKYKit.h>
 
+#import "SKYChatCacheLiveQuery.h"
 #import "SKYChatReceipt.h"
 #import "SKYChatRecordChange.h"
 #import "SKYChatTypingIndicator.h"
@@ -43,6 +44,17 @@ extern NSString *const SKYChatConversationUnreadCountKey;
  */
 extern NSString *const SKYChatDidReceiveTypingIndicatorNotification;
 
+/**
+ This notification is posted when the participants typing in a conversation changes,
+ including when the typing event of a participant expires.
+ */
+extern NSString *const SKYChatDidChangeTypingParticipantsNotification;
+
+/**
+ This notification is posted when the locally maintained unread count changes.
+ */
+extern NSString *const SKYChatDidChangeUnreadCountNotification;
+
 /**
  This notification is posted when the client receives an event for record change.
  */
@@ -54,6 +66,25 @@ extern NSString *const SKYChatDidReceiveRecordChangeNotification;
  */
 extern NSString *const SKYChatTypingIndicatorUserInfoKey;
 
+/**
+ For the SKYChatDidChangeTypingParticipantsNotification and
+ SKYChatDidChangeUnreadCountNotification, this user info key can be used to get the
+ conversation ID.
+ */
+extern NSString *const SKYChatConversationIDUserInfoKey;
+
+/**
+ For the SKYChatDidChangeTypingParticipantsNotification, this user info key
+ can be used to get an array of ID of participants who are typing.
+ */
+extern NSString *const SKYChatTypingParticipantIDsUserInfoKey;
+
+/**
+ For the SKYChatDidChangeUnreadCountNotification, this user info key
+ can be used to get the total unread count.
+ */
+extern NSString *const SKYChatTotalUnreadCountUserInfoKey;
+
 /**
  For the SKYChatDidReceiveRecordChangeNotification, this user info key
  can be used to get an object of SKYChatRecordChange.
@@ -81,6 +112,8 @@ typedef void (^SKYChatFetchParticpantsCompletion)(
     NSDictionary<NSString *, SKYParticipant *> *participantsMap, BOOL isCached,
     NSError *_Nullable error);
 typedef void (^SKYChatMessageCompletion)(SKYMessage *_Nullable message, NSError *_Nullable error);
+typedef void (^SKYChatAddMessagesCompletion)(NSArray<SKYMessage *> *messages,
+                                             NSDictionary<NSNumber *, NSError *> *errorsByIndex);
 typedef void (^SKYChatUnreadCountCompletion)(
     NSDictionary<NSString *, NSNumber *> *_Nullable response, NSError *_Nullable error);
 typedef void (^SKYChatChannelCompletion)(SKYUserChannel *_Nullable userChannel,
@@ -108,6 +141,65 @@ typedef void (^SKYMessageOperationListCompletion)(
  */
 @property (assign, nonatomic) bool automaticallyMarkMessagesAsDelivered;
 
+/**
+ Gets or sets the number of conversations per page when fetching conversations without
+ specifying a page size.
+
+ The default is 50.
+ */
+@property (assign, nonatomic) NSInteger defaultConversationsPageSize;
+
+/**
+ Gets or sets the minimum interval between two typing begin events sent by
+ `-sendTypingIndicator:inConversation:` to the same conversation.
+
+ The default is 3 seconds.
+ */
+@property (assign, nonatomic) NSTimeInterval typingIndicatorBeginInterval;
+
+/**
+ Gets or sets the period of inactivity after which `-sendTypingIndicator:inConversation:`
+ sends a typing pause event automatically.
+
+ The default is 3 seconds.
+ */
+@property (assign, nonatomic) NSTimeInterval typingIndicatorPauseInterval;
+
+/**
+ Gets or sets the period after a typing begin event in which the participant is regarded
+ as typing.
+
+ The default is 5 seconds.
+ */
+@property (assign, nonatomic) NSTimeInterval typingIndicatorExpiryInterval;
+
+/**
+ Gets or sets the interval at which the locally maintained unread count is reconciled
+ with the server while the user channel is subscribed. Set to 0 to disable periodic
+ reconciliation.
+
+ The default is 300 seconds.
+ */
+@property (assign, nonatomic) NSTimeInterval unreadCountReconciliationInterval;
+
+/**
+ Gets or sets the maximum number of attachments uploaded at the same time by
+ `-addMessages:toConversation:completion:`.
+
+ The default is 3.
+ */
+@property (assign, nonatomic) NSInteger maxConcurrentAttachmentUploads;
+
+/**
+ Gets or sets whether the cache of the previous user is deleted when the current user changes.
+
+ Each user has a separate cache. Enable this on devices shared by multiple users, so that
+ messages cached for a user are not kept on the device after the user logs out.
+
+ This is disabled by default.
+ */
+@property (assign, nonatomic) BOOL deletesCacheOfPreviousUser;
+
 /**
  Gets or sets user channel message handler.
 
@@ -300,6 +392,9 @@ typedef void (^SKYMessageOperationListCompletion)(
 /**
  Fetches conversations with paging options and optional last message in conversation.
 
+ The fetched page of conversations will be cached locally, and can be obtained with
+ `-fetchCachedConversationsWithPage:pageSize:completion:`.
+
  @param page page number
  @param pageSize number of conversation per page
  @param fetchLastMessage whether to fetch the last message
@@ -311,6 +406,22 @@ typedef void (^SKYMessageOperationListCompletion)(
                         completion:(SKYChatFetchConversationListCompletion _Nullable)completion
     /* clang-format off */ NS_SWIFT_NAME(fetchConversations(page:pageSize:fetchLastMessage:completion:)); /* clang-format on */
 
+/**
+ Fetches a page of conversations from the local cache.
+
+ Conversations are cached when they are fetched from server with
+ `-fetchConversationsWithPage:pageSize:fetchLastMessage:completion:`. The completion is called
+ synchronously.
+
+ @param page page number
+ @param pageSize number of conversation per page
+ @param completion completion block
+ */
+- (void)fetchCachedConversationsWithPage:(NSInteger)page
+                                pageSize:(NSInteger)pageSize
+                              completion:(SKYChatFetchConversationListCompletion _Nullable)completion
+    /* clang-format off */ NS_SWIFT_NAME(fetchCachedConversations(page:pageSize:completion:)); /* clang-format on */
+
 /**
  Fetches a conversation by conversation ID.
 
@@ -532,6 +643,26 @@ typedef void (^SKYMessageOperationListCompletion)(
         completion:(SKYChatMessageCompletion _Nullable)completion
     /* clang-format off */ NS_SWIFT_NAME(addMessage(_:to:completion:)); /* clang-format on */
 
+/**
+ Adds several messages to a conversation.
+
+ Attachments that are not uploaded yet are uploaded first, at most
+ `maxConcurrentAttachmentUploads` at a time. The messages are then saved to the server in a
+ single request, and their message operations are recorded in the cache together.
+
+ The completion block is called once, with the messages in the order of `messages`, each of
+ which is the saved message or the given message if it failed to be saved, and the errors of
+ the failed messages by their indexes. It is called with no messages if `messages` is empty.
+
+ @param messages messages to add to a conversation
+ @param conversation conversation object
+ @param completion completion block
+ */
+- (void)addMessages:(NSArray<SKYMessage *> *)messages
+     toConversation:(SKYConversation *)conversation
+         completion:(SKYChatAddMessagesCompletion _Nullable)completion
+    /* clang-format off */ NS_SWIFT_NAME(addMessages(_:to:completion:)); /* clang-format on */
+
 /**
  Fetch messages in a conversation.
 
@@ -628,6 +759,99 @@ typedef void (^SKYMessageOperationListCompletion)(
                              completion:(SKYChatFetchMessagesListCompletion _Nullable)completion
     /* clang-format off */ NS_SWIFT_NAME(fetchMessages(conversationID:limit:beforeMessageID:order:completion:)); /* clang-format on */
 
+/**
+ Fetch messages in a conversation by ID that are newer than a message, for paging towards the
+ most recent message.
+
+ Messages are returned in descending order, the same as the other fetch methods, so the first
+ message is the newest one in the page. Cached messages are returned first, which are empty if
+ the specified message is not cached.
+
+ @param conversationId ID of the conversation
+ @param limit the number of messages to fetch
+ @param afterMessageID only messages after this message ID is fetched
+ @param order order of the messages, either 'edited_at' or '_created_at'
+ @param completion completion block
+ */
+- (void)fetchMessagesWithConversationID:(NSString *_Nonnull)conversationId
+                                  limit:(NSInteger)limit
+                         afterMessageID:(NSString *_Nonnull)afterMessageID
+                                  order:(NSString *_Nullable)order
+                             completion:(SKYChatFetchMessagesListCompletion _Nullable)completion
+    /* clang-format off */ NS_SWIFT_NAME(fetchMessages(conversationID:limit:afterMessageID:order:completion:)); /* clang-format on */
+
+/**
+ Fetch a window of messages in a conversation by ID around a message, such as the last read
+ message, including the message itself.
+
+ About half of the messages are newer than the specified message and the rest are older. They
+ are returned in descending order of creation date. Cached messages are returned first using
+ the seq index of the cache, which are empty if the specified message is not cached.
+
+ @param conversationId ID of the conversation
+ @param limit the number of messages to fetch
+ @param aroundMessageID ID of the message at the middle of the window
+ @param order order of the messages, either 'edited_at' or '_created_at'
+ @param completion completion block
+ */
+- (void)fetchMessagesWithConversationID:(NSString *_Nonnull)conversationId
+                                  limit:(NSInteger)limit
+                        aroundMessageID:(NSString *_Nonnull)aroundMessageID
+                                  order:(NSString *_Nullable)order
+                             completion:(SKYChatFetchMessagesListCompletion _Nullable)completion
+    /* clang-format off */ NS_SWIFT_NAME(fetchMessages(conversationID:limit:aroundMessageID:order:completion:)); /* clang-format on */
+
+///----------------------------------
+/// @name Searching cached messages
+///----------------------------------
+
+/**
+ Searches the bodies of messages in the local cache.
+
+ Messages are indexed when they are cached, so only messages that have been fetched or received
+ can be found. A message matches when its body contains every word of the query, ignoring case
+ and diacritics. Chinese, Japanese and Korean text is matched by character pairs, so these
+ queries do not need to be delimited by spaces.
+
+ Results are ranked by relevance, with the more recent message first if equally relevant.
+
+ @param query the text to search for
+ @param conversation the conversation to search in, or nil to search all conversations
+ @param limit the maximum number of messages to return, -1 for no limit
+ @param completion completion block
+ */
+- (void)searchMessagesWithQuery:(NSString *)query
+                 inConversation:(SKYConversation *_Nullable)conversation
+                          limit:(NSInteger)limit
+                     completion:(SKYChatFetchMessagesListCompletion _Nullable)completion
+    /* clang-format off */ NS_SWIFT_NAME(searchMessages(query:in:limit:completion:)); /* clang-format on */
+
+///-------------------------------------
+/// @name Prefetching messages for cache
+///-------------------------------------
+
+/**
+ Prefetches the newest messages and the participants of conversations into the local cache.
+
+ Conversations are prefetched one by one in the order given, so that prefetching does not
+ compete with requests made by the UI. Prefetching stops when the estimated size of the cached
+ messages exceeds the byte budget. Conversations whose last message is already cached are
+ skipped, and so are conversations that fail to be fetched. Prefetched messages are not marked
+ as delivered.
+
+ @param conversations conversations to prefetch, most recently active first
+ @param limit the number of messages to prefetch per conversation
+ @param byteBudget the approximate number of bytes of messages to be cached, 0 for no limit
+ @param completion completion block, called with the number of bytes of messages cached and
+ the last error if any conversation failed to be fetched
+ */
+- (void)prefetchMessagesWithConversations:(NSArray<SKYConversation *> *)conversations
+                                    limit:(NSInteger)limit
+                               byteBudget:(NSUInteger)byteBudget
+                               completion:(void (^_Nullable)(NSUInteger fetchedBytes,
+                                                             NSError *_Nullable error))completion
+    /* clang-format off */ NS_SWIFT_NAME(prefetchMessages(conversations:limit:byteBudget:completion:)); /* clang-format on */
+
 ///----------------------------------------------
 /// @name Send message delivery and read receipts
 ///----------------------------------------------
@@ -764,6 +988,67 @@ typedef void (^SKYMessageOperationListCompletion)(
 - (void)fetchTotalUnreadCount:(SKYChatUnreadCountCompletion _Nullable)completion
     /* clang-format off */ NS_SWIFT_NAME(fetchTotalUnreadCount(completion:)); /* clang-format on */
 
+///--------------------------------------
+/// @name Observing local unread count
+///--------------------------------------
+
+/**
+ Returns the locally maintained total unread count of conversations and messages, or nil if
+ the total unread count has not been fetched from server.
+
+ The count is updated with messages received from the user channel and messages marked as read
+ by -markLastReadMessage:inConversation:completion:, and reconciled with the server
+ periodically.
+ */
+- (NSDictionary<NSString *, NSNumber *> *_Nullable)cachedTotalUnreadCount;
+
+/**
+ Returns the locally maintained unread count of a conversation. If the count is not known
+ locally, the unread count of the conversation object is returned.
+
+ @param conversation the conversation object
+ */
+- (NSInteger)cachedUnreadCountInConversation:(SKYConversation *)conversation
+    /* clang-format off */ NS_SWIFT_NAME(cachedUnreadCount(in:)); /* clang-format on */
+
+/**
+ Fetches the total unread count from server and replaces the locally maintained total
+ unread count.
+
+ This is called when the user channel is subscribed and periodically at
+ unreadCountReconciliationInterval, so apps do not normally need to call this method.
+
+ @param completion completion block
+ */
+- (void)reconcileUnreadCountWithCompletion:(SKYChatUnreadCountCompletion _Nullable)completion
+    /* clang-format off */ NS_SWIFT_NAME(reconcileUnreadCount(completion:)); /* clang-format on */
+
+/**
+ Subscribe to changes of the locally maintained unread count.
+
+ The handler is called with the total unread count, and the ID of the conversation whose unread
+ count has changed, if any.
+
+ The handler is not called until the total unread count is fetched from server, which happens
+ when the user channel is subscribed. Use -cachedTotalUnreadCount to get the current count.
+
+ To unsubscribe, call -unsubscribeToUnreadCountWithObserver: with the returned object.
+
+ @param handler the unread count handler
+ @return NSNotification observer
+ */
+- (id)subscribeToUnreadCountWithHandler:
+    (void (^)(NSDictionary<NSString *, NSNumber *> *totalUnreadCount,
+              NSString *_Nullable conversationID))handler
+    /* clang-format off */ NS_SWIFT_NAME(subscribeToUnreadCount(handler:)); /* clang-format on */
+
+/**
+ Unsubscribe to unread count changes
+
+ @param observer the observer
+ */
+- (void)unsubscribeToUnreadCountWithObserver:(id)observer;
+
 ///-----------------------
 /// @name Typing indicator
 ///-----------------------
@@ -771,8 +1056,12 @@ typedef void (^SKYMessageOperationListCompletion)(
 /**
  Send typing indicator to the specified conversation.
 
- This method calls -sendTypingIndicator:inConversation:date:completion: with the
- current date in the date parameter.
+ This method is safe to be called whenever the user types. Begin events are sent at most once
+ per `typingIndicatorBeginInterval`, a pause event is sent automatically after
+ `typingIndicatorPauseInterval` of inactivity, and events that do not change the typing state
+ of the conversation are not sent. Events are sent with
+ -sendTypingIndicator:inConversation:date:completion: with the current date in the date
+ parameter.
 
  @param typingEvent the event type
  @param conversation the conversation
@@ -784,8 +1073,8 @@ typedef void (^SKYMessageOperationListCompletion)(
 /**
  Send typing indicator to the specified conversation.
 
- Most app developers should call the method -sendTypingIndicator:inConversation:date:completion:
- instead.
+ The typing event is always sent. Most app developers should call the method
+ -sendTypingIndicator:inConversation: instead.
 
  @param typingEvent the event type
  @param conversation the conversation
@@ -798,6 +1087,16 @@ typedef void (^SKYMessageOperationListCompletion)(
                  completion:(void (^_Nullable)(NSError *_Nullable error))completion
     /* clang-format off */ NS_SWIFT_NAME(sendTypingIndicator(_:in:at:completion:)); /* clang-format on */
 
+/**
+ Returns the ID of participants who are typing in the specified conversation.
+
+ Typing events are collected from the user channel, so the user channel must be subscribed.
+
+ @param conversation the conversation
+ */
+- (NSArray<NSString *> *)typingParticipantIDsInConversation:(SKYConversation *)conversation
+    /* clang-format off */ NS_SWIFT_NAME(typingParticipantIDs(in:)); /* clang-format on */
+
 ///-----------------------------------------
 /// @name Subscribing to events using pubsub
 ///-----------------------------------------
@@ -880,6 +1179,24 @@ typedef void (^SKYMessageOperationListCompletion)(
                                        handler:(void (^)(SKYChatTypingIndicator *indicator))handler
     /* clang-format off */ NS_SWIFT_NAME(subscribeToTypingIndicator(in:handler:)); /* clang-format on */
 
+/**
+ Subscribe to changes of participants typing in the specified conversation.
+
+ The handler is called with the ID of participants who are typing when a typing event is
+ received, and when the typing event of a participant expires. The handler is called on the
+ main queue.
+
+ To unsubscribe, call -unsubscribeToTypingIndicatorWithObserver: with the returned object.
+
+ @param conversation the conversation object
+ @param handler the handler to be called with the typing participant IDs
+ @return NSNotification observer
+ */
+- (id)subscribeToTypingParticipantsInConversation:(SKYConversation *)conversation
+                                          handler:
+                                              (void (^)(NSArray<NSString *> *participantIDs))handler
+    /* clang-format off */ NS_SWIFT_NAME(subscribeToTypingParticipants(in:handler:)); /* clang-format on */
+
 /**
  Subscribe to message events in a conversation.
 
@@ -903,6 +1220,50 @@ typedef void (^SKYMessageOperationListCompletion)(
                                                   SKYMessage *record))handler
     /* clang-format off */ NS_SWIFT_NAME(subscribeToMessages(in:handler:)); /* clang-format on */
 
+/**
+ Observes the latest cached messages in a conversation.
+
+ The handler is called on the main thread with the latest cached messages of the conversation
+ up to the limit, in descending order of creation date, and then with the updated messages and
+ the changed indexes whenever the cache changes, including changes from fetches, pubsub events
+ and local message operations. A message leaves the result when it is deleted, or when newer
+ messages push it beyond the limit. Call `-invalidate` on the returned live query to stop
+ observing.
+
+ This method must be called on the main thread.
+
+ @param conversation the conversation object
+ @param limit the maximum number of messages to observe
+ @param handler the handler of cached messages
+ @return the live query
+ */
+- (SKYChatCacheLiveQuery *)observeCachedMessagesInConversation:(SKYConversation *)conversation
+                                                         limit:(NSUInteger)limit
+                                                       handler:
+                                                           (SKYChatMessagesLiveQueryHandler)handler
+    /* clang-format off */ NS_SWIFT_NAME(observeCachedMessages(in:limit:handler:)); /* clang-format on */
+
+/**
+ Observes the cached message operations of the specified type in a conversation, such as
+ messages being sent or failed to send.
+
+ The handler is called on the main thread in the same way as
+ `-observeCachedMessagesInConversation:limit:handler:`, with all message operations in
+ descending order of send date.
+
+ This method must be called on the main thread.
+
+ @param conversation the conversation object
+ @param type the type of message operations
+ @param handler the handler of message operations
+ @return the live query
+ */
+- (SKYChatCacheLiveQuery *)
+observeCachedMessageOperationsInConversation:(SKYConversation *)conversation
+                               operationType:(SKYMessageOperationType)type
+                                     handler:(SKYChatMessageOperationsLiveQueryHandler)handler
+    /* clang-format off */ NS_SWIFT_NAME(observeCachedMessageOperations(in:operationType:handler:)); /* clang-format on */
+
 /**
  Subscribe to conversation events.
 
@@ -19,12 +19,18 @@
 
 #import "SKYChatExtension.h"
 #import "SKYChatExtension_Private.h"
+#import "SKYChatLogger.h"
 
 #import <SKYKit/SKYKit.h>
 
+#import "SKYChatMessagesResponseDecoder.h"
+#import "SKYChatMetrics.h"
 #import "SKYChatReceipt.h"
 #import "SKYChatRecordChange_Private.h"
+#import "SKYChatTypingIndicatorThrottle.h"
+#import "SKYChatTypingStateStore.h"
 #import "SKYChatTypingIndicator_Private.h"
+#import "SKYChatUnreadCountTracker.h"
 #import "SKYConversation.h"
 #import "SKYMessage.h"
 #import "SKYParticipant.h"
@@ -41,15 +47,69 @@ NSString *const SKYChatDidReceiveTypingIndicatorNotification =
     @"SKYChatDidReceiveTypingIndicatorNotification";
 NSString *const SKYChatDidReceiveRecordChangeNotification =
     @"SKYChatDidReceiveRecordChangeNotification";
+NSString *const SKYChatDidChangeTypingParticipantsNotification =
+    @"SKYChatDidChangeTypingParticipantsNotification";
+NSString *const SKYChatDidChangeUnreadCountNotification =
+    @"SKYChatDidChangeUnreadCountNotification";
 
 NSString *const SKYChatTypingIndicatorUserInfoKey = @"typingIndicator";
 NSString *const SKYChatRecordChangeUserInfoKey = @"recordChange";
+NSString *const SKYChatConversationIDUserInfoKey = @"conversationID";
+NSString *const SKYChatTypingParticipantIDsUserInfoKey = @"typingParticipantIDs";
+NSString *const SKYChatTotalUnreadCountUserInfoKey = @"totalUnreadCount";
+
+/**
+ Lambda calls of the chat extension, measured as lambda.<name> spans of the given metrics.
+
+ The metrics keyword is prefixed, so that the selectors cannot collide with those of SKYKit.
+ */
+@interface SKYContainer (SKYChatMetrics)
+
+- (void)callLambda:(NSString *)lambda
+     sky_chat_metrics:(SKYChatMetrics *)metrics
+    completionHandler:(void (^)(NSDictionary *, NSError *))completionHandler;
+
+- (void)callLambda:(NSString *)lambda
+            arguments:(NSArray *)arguments
+     sky_chat_metrics:(SKYChatMetrics *)metrics
+    completionHandler:(void (^)(NSDictionary *, NSError *))completionHandler;
+
+- (void)callLambda:(NSString *)lambda
+    dictionaryArguments:(NSDictionary *)arguments
+       sky_chat_metrics:(SKYChatMetrics *)metrics
+      completionHandler:(void (^)(NSDictionary *, NSError *))completionHandler;
+
+@end
+
+/**
+ Estimates the cached size of a message from its body and attachment metadata, which is cheap
+ enough for prefetching. The fixed part accounts for the IDs, dates and references.
+ */
+static NSUInteger SKYChatEstimatedMessageSize(SKYMessage *message)
+{
+    NSUInteger size = 256;
+    size += [message.body lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+    SKYAsset *attachment = message.attachment;
+    if (attachment) {
+        size += attachment.name.length + attachment.mimeType.length +
+                attachment.url.absoluteString.length;
+    }
+    return size;
+}
 
 @implementation SKYChatExtension {
     id notificationObserver;
     SKYUserChannel *subscribedUserChannel;
     BOOL isFetchingUserChannel;
     NSMutableArray<SKYChatChannelCompletion> *fetchOrCreateUserChannelCompletions;
+    SKYChatTypingIndicatorThrottle *typingIndicatorThrottle;
+    SKYChatTypingStateStore *typingStateStore;
+    SKYChatUnreadCountTracker *unreadCountTracker;
+    dispatch_source_t unreadCountReconciliationTimer;
+    SKYChatMessagesResponseDecoder *messagesResponseDecoder;
+    BOOL usesUserCacheControllers;
+    NSString *cacheUserID;
+    NSURL *cacheEndPoint;
 }
 
 - (instancetype)initWithContainer:(SKYContainer *)container
@@ -63,18 +123,25 @@ NSString *const SKYChatRecordChangeUserInfoKey = @"recordChange";
         }
         _container = container;
         _automaticallyMarkMessagesAsDelivered = YES;
+        _defaultConversationsPageSize = 50;
+        _maxConcurrentAttachmentUploads = 3;
+        _unreadCountReconciliationInterval = 300;
 
         notificationObserver = [[NSNotificationCenter defaultCenter]
             addObserverForName:SKYContainerDidChangeCurrentUserNotification
                         object:container.auth
                          queue:[NSOperationQueue mainQueue]
                     usingBlock:^(NSNotification *note) {
+                        [self switchCacheControllerForCurrentUser];
                         if (container.auth.currentUser != nil) {
                             return;
                         }
                         // Unsubscribe because the current user has changed. We do not
                         // want the UI to keep notified for changes intended for previous user.
                         [self unsubscribeFromUserChannel];
+                        [self->typingIndicatorThrottle reset];
+                        [self->typingStateStore reset];
+                        [self->unreadCountTracker reset];
 
                         // cleanup fetchOrCreateUserChannelCompletions if needed when user logout
                         NSError *error = [NSError
@@ -87,6 +154,57 @@ NSString *const SKYChatRecordChangeUserInfoKey = @"recordChange";
 
         _cacheController = cacheController;
         fetchOrCreateUserChannelCompletions = [NSMutableArray array];
+        messagesResponseDecoder = [[SKYChatMessagesResponseDecoder alloc] init];
+
+        __weak typeof(self) weakSelf = self;
+        typingIndicatorThrottle = [[SKYChatTypingIndicatorThrottle alloc]
+            initWithSendHandler:^(SKYChatTypingEvent event, NSString *conversationID,
+                                  NSDate *date) {
+                [weakSelf sendTypingIndicator:event
+                             inConversationID:conversationID
+                                         date:date
+                                   completion:nil];
+            }];
+        typingStateStore = [[SKYChatTypingStateStore alloc]
+            initWithChangeHandler:^(NSString *conversationID,
+                                    NSArray<NSString *> *typingParticipantIDs) {
+                [[NSNotificationCenter defaultCenter]
+                    postNotificationName:SKYChatDidChangeTypingParticipantsNotification
+                                  object:weakSelf
+                                userInfo:@{
+                                    SKYChatConversationIDUserInfoKey : conversationID,
+                                    SKYChatTypingParticipantIDsUserInfoKey : typingParticipantIDs,
+                                }];
+            }];
+        unreadCountTracker = [[SKYChatUnreadCountTracker alloc]
+            initWithChangeHandler:^(NSDictionary<NSString *, NSNumber *> *totalUnreadCount,
+                                    NSString *conversationID) {
+                NSMutableDictionary *userInfo = [NSMutableDictionary dictionary];
+                userInfo[SKYChatTotalUnreadCountUserInfoKey] = totalUnreadCount;
+                if (conversationID) {
+                    userInfo[SKYChatConversationIDUserInfoKey] = conversationID;
+                }
+                [[NSNotificationCenter defaultCenter]
+                    postNotificationName:SKYChatDidChangeUnreadCountNotification
+                                  object:weakSelf
+                                userInfo:userInfo];
+            }];
+    }
+    return self;
+}
+
+- (instancetype)initWithContainer:(SKYContainer *)container
+{
+    NSString *userID = container.auth.currentUserRecordID;
+    SKYChatCacheController *cacheController =
+        userID ? [SKYChatCacheController cacheControllerWithUserID:userID
+                                                          endPoint:container.endPointAddress]
+               : [SKYChatCacheController defaultController];
+
+    if ((self = [self initWithContainer:container cacheController:cacheController])) {
+        usesUserCacheControllers = YES;
+        cacheUserID = userID;
+        cacheEndPoint = container.endPointAddress;
     }
     return self;
 }
@@ -94,6 +212,31 @@ NSString *const SKYChatRecordChangeUserInfoKey = @"recordChange";
 - (void)dealloc
 {
     [[NSNotificationCenter defaultCenter] removeObserver:notificationObserver];
+    [self stopUnreadCountReconciliationTimer];
+}
+
+- (void)switchCacheControllerForCurrentUser
+{
+    if (!usesUserCacheControllers) {
+        return;
+    }
+
+    NSString *userID = self.container.auth.currentUserRecordID;
+    NSURL *endPoint = self.container.endPointAddress;
+    if ((userID == cacheUserID || [userID isEqualToString:cacheUserID]) &&
+        (endPoint == cacheEndPoint || [endPoint isEqual:cacheEndPoint])) {
+        return;
+    }
+
+    if (cacheUserID && self.deletesCacheOfPreviousUser) {
+        [SKYChatCacheController removeCacheWithUserID:cacheUserID endPoint:cacheEndPoint];
+    }
+
+    cacheUserID = userID;
+    cacheEndPoint = endPoint;
+    _cacheController =
+        userID ? [SKYChatCacheController cacheControllerWithUserID:userID endPoint:endPoint]
+               : [SKYChatCacheController defaultController];
 }
 
 #pragma mark - Conversations
@@ -193,15 +336,17 @@ NSString *const SKYChatRecordChangeUserInfoKey = @"recordChange";
 
     [self.container callLambda:@"chat:create_conversation"
                      arguments:@[ participantIDs, title, metadata, options ]
+              sky_chat_metrics:[SKYChatMetrics sharedMetrics]
              completionHandler:^(NSDictionary *response, NSError *error) {
                  if (error) {
-                     NSLog(@"error calling chat:create_conversation: %@", error);
+                     SKYChatLogError(@"conversation",
+                                     @"error calling chat:create_conversation: %@", error);
                      if (completion) {
                          completion(nil, error);
                      }
                      return;
                  }
-                 NSLog(@"Received response = %@", response);
+                 SKYChatLogDebug(@"conversation", @"Received chat:create_conversation response");
                  SKYRecordDeserializer *deserializer = [SKYRecordDeserializer deserializer];
                  NSObject *obj = [response objectForKey:@"conversation"];
                  SKYRecord *record = [deserializer recordWithDictionary:[obj copy]];
@@ -218,11 +363,13 @@ NSString *const SKYChatRecordChangeUserInfoKey = @"recordChange";
     [self.container
                callLambda:@"chat:delete_conversation"
                 arguments:@[ conversation.recordName ]
+         sky_chat_metrics:[SKYChatMetrics sharedMetrics]
         completionHandler:^(NSDictionary *response, NSError *error) {
             /* FIXME: remove SKYErrorName checking after
              https://github.com/SkygearIO/skygear-SDK-iOS/issues/118 is close */
             if (error && [error.userInfo[@"SKYErrorName"] isEqualToString:@"PermissionDenied"]) {
-                NSLog(@"error calling chat:delete_conversation: %@", error);
+                SKYChatLogError(@"conversation",
+                                @"error calling chat:delete_conversation: %@", error);
                 if (completion) {
                     completion(nil, error);
                 }
@@ -280,14 +427,17 @@ NSString *const SKYChatRecordChangeUserInfoKey = @"recordChange";
 #pragma mark Fetching Conversations
 - (void)fetchConversationsWithCompletion:(SKYChatFetchConversationListCompletion)completion
 {
-    [self fetchConversationsWithPage:1 pageSize:50 fetchLastMessage:TRUE completion:completion];
+    [self fetchConversationsWithPage:1
+                            pageSize:self.defaultConversationsPageSize
+                    fetchLastMessage:TRUE
+                          completion:completion];
 }
 
 - (void)fetchConversationsWithFetchLastMessage:(BOOL)fetchLastMessage
                                     completion:(SKYChatFetchConversationListCompletion)completion
 {
     [self fetchConversationsWithPage:1
-                            pageSize:50
+                            pageSize:self.defaultConversationsPageSize
                     fetchLastMessage:fetchLastMessage
                           completion:completion];
 }
@@ -297,21 +447,24 @@ NSString *const SKYChatRecordChangeUserInfoKey = @"recordChange";
                   fetchLastMessage:(BOOL)fetchLastMessage
                         completion:(SKYChatFetchConversationListCompletion)completion
 {
+    SKYChatCacheController *cacheController = self.cacheController;
     [self.container callLambda:@"chat:get_conversations"
         dictionaryArguments:@{
             @"page" : @(page),
             @"page_size" : @(pageSize),
             @"include_last_message" : [NSNumber numberWithBool:fetchLastMessage]
         }
+         sky_chat_metrics:[SKYChatMetrics sharedMetrics]
         completionHandler:^(NSDictionary *response, NSError *error) {
             if (error) {
-                NSLog(@"error calling chat:get_conversations: %@", error);
+                SKYChatLogError(@"conversation",
+                                @"error calling chat:get_conversations: %@", error);
                 if (completion) {
                     completion(nil, error);
                 }
                 return;
             }
-            NSLog(@"Received response = %@", response);
+            SKYChatLogDebug(@"conversation", @"Received chat:get_conversations response");
             SKYRecordDeserializer *deserializer = [SKYRecordDeserializer deserializer];
             NSMutableArray *result = [response mutableArrayValueForKey:@"conversations"];
             NSMutableArray *conversations = [NSMutableArray array];
@@ -319,33 +472,50 @@ NSString *const SKYChatRecordChangeUserInfoKey = @"recordChange";
                 SKYRecord *record = [deserializer recordWithDictionary:[obj copy]];
                 SKYConversation *conversation = [SKYConversation recordWithRecord:record];
                 [conversations addObject:conversation];
+                [self->unreadCountTracker updateWithUnreadCount:conversation.unreadCount
+                                                 conversationID:conversation.recordName];
             }
 
+            [cacheController didFetchConversations:conversations
+                                              page:page
+                                          pageSize:pageSize];
+
             if (completion) {
                 completion(conversations, error);
             }
         }];
 }
 
+- (void)fetchCachedConversationsWithPage:(NSInteger)page
+                                pageSize:(NSInteger)pageSize
+                              completion:(SKYChatFetchConversationListCompletion)completion
+{
+    [self.cacheController fetchConversationsWithPage:page pageSize:pageSize completion:completion];
+}
+
 - (void)fetchConversationWithConversationID:(NSString *)conversationId
                            fetchLastMessage:(BOOL)fetchLastMessage
                                  completion:(SKYChatConversationCompletion)completion
 {
     [self.container callLambda:@"chat:get_conversation"
                      arguments:@[ conversationId, [NSNumber numberWithBool:fetchLastMessage] ]
+              sky_chat_metrics:[SKYChatMetrics sharedMetrics]
              completionHandler:^(NSDictionary *response, NSError *error) {
                  if (error) {
-                     NSLog(@"error calling chat:get_conversation: %@", error);
+                     SKYChatLogError(@"conversation",
+                                     @"error calling chat:get_conversation: %@", error);
                      if (completion) {
                          completion(nil, error);
                      }
                      return;
                  }
-                 NSLog(@"Received response = %@", response);
+                 SKYChatLogDebug(@"conversation", @"Received chat:get_conversation response");
                  SKYRecordDeserializer *deserializer = [SKYRecordDeserializer deserializer];
                  NSObject *obj = [response objectForKey:@"conversation"];
                  SKYRecord *record = [deserializer recordWithDictionary:[obj copy]];
                  SKYConversation *conversation = [SKYConversation recordWithRecord:record];
+                 [self->unreadCountTracker updateWithUnreadCount:conversation.unreadCount
+                                                  conversationID:conversation.recordName];
                  if (completion) {
                      completion(conversation, error);
                  }
@@ -365,32 +535,31 @@ NSString *const SKYChatRecordChangeUserInfoKey = @"recordChange";
 
     [self.container callLambda:@"chat:get_messages_by_ids"
                      arguments:@[ messageIDs ]
+              sky_chat_metrics:[SKYChatMetrics sharedMetrics]
              completionHandler:^(NSDictionary *response, NSError *error) {
                  if (error) {
-                     NSLog(@"error calling chat:get_messages_by_ids: %@", error);
+                     SKYChatLogError(@"message",
+                                     @"error calling chat:get_messages_by_ids: %@", error);
                      if (completion) {
                          completion(nil, NO, error);
                      }
                      return;
                  }
-                 NSLog(@"Received response = %@", response);
-                 NSArray *resultArray = [response objectForKey:@"results"];
-                 NSMutableArray *returnArray = [[NSMutableArray alloc] init];
-                 NSMutableArray *deletedReturnArray = [[NSMutableArray alloc] init];
-                 for (NSDictionary *obj in resultArray) {
-                     SKYRecordDeserializer *deserializer = [SKYRecordDeserializer deserializer];
-                     SKYRecord *record = [deserializer recordWithDictionary:[obj copy]];
-
-                     SKYMessage *msg = [[SKYMessage alloc] initWithRecordData:record];
-                     if (msg && msg.deleted) {
-                         [deletedReturnArray addObject:msg];
-                     } else if (msg && !msg.deleted) {
-                         [returnArray addObject:msg];
-                     }
-                 }
-                 if (completion) {
-                     completion(returnArray, NO, error);
+                 if (!completion) {
+                     return;
                  }
+                 [self->messagesResponseDecoder
+                     decodeResponse:response
+                         completion:^(NSArray<SKYMessage *> *messages,
+                                      NSArray<SKYMessage *> *deletedMessages) {
+                             NSMutableArray *returnArray = [[NSMutableArray alloc] init];
+                             for (SKYMessage *msg in messages) {
+                                 if (!msg.deleted) {
+                                     [returnArray addObject:msg];
+                                 }
+                             }
+                             completion(returnArray, NO, nil);
+                         }];
              }];
 }
 
@@ -413,6 +582,7 @@ NSString *const SKYChatRecordChangeUserInfoKey = @"recordChange";
                  predicate:[NSPredicate predicateWithFormat:@"_id IN %@", participantIDs]];
     [userQuery setLimit:participantIDs.count];
 
+    SKYChatCacheController *cacheController = self.cacheController;
     [self.container.publicCloudDatabase
              performQuery:userQuery
         completionHandler:^(NSArray *_Nullable results, NSError *_Nullable error) {
@@ -431,7 +601,7 @@ NSString *const SKYChatRecordChangeUserInfoKey = @"recordChange";
                     [participantMap setObject:eachParticipant forKey:eachParticipant.recordName];
                 }];
 
-            [self.cacheController didFetchParticipants:participantMap.allValues];
+            [cacheController didFetchParticipants:participantMap.allValues];
 
             if (completion) {
                 completion(participantMap, NO, nil);
@@ -446,15 +616,16 @@ NSString *const SKYChatRecordChangeUserInfoKey = @"recordChange";
 {
     [self.container callLambda:lambda
                      arguments:@[ conversation.recordID.recordName, participantIDs ]
+              sky_chat_metrics:[SKYChatMetrics sharedMetrics]
              completionHandler:^(NSDictionary *response, NSError *error) {
                  if (error) {
-                     NSLog(@"error calling chat:%@: %@", lambda, error);
+                     SKYChatLogError(@"conversation", @"error calling %@: %@", lambda, error);
                      if (completion) {
                          completion(nil, error);
                      }
                      return;
                  }
-                 NSLog(@"Received response = %@", response);
+                 SKYChatLogDebug(@"conversation", @"Received %@ response", lambda);
                  SKYRecordDeserializer *deserializer = [SKYRecordDeserializer deserializer];
                  NSObject *obj = [response objectForKey:@"conversation"];
                  SKYRecord *record = [deserializer recordWithDictionary:[obj copy]];
@@ -550,6 +721,7 @@ NSString *const SKYChatRecordChangeUserInfoKey = @"recordChange";
 {
     [self.container callLambda:@"chat:leave_conversation"
                      arguments:@[ conversationID ]
+              sky_chat_metrics:[SKYChatMetrics sharedMetrics]
              completionHandler:^(NSDictionary *response, NSError *error) {
                  if (completion) {
                      completion(error);
@@ -596,21 +768,22 @@ NSString *const SKYChatRecordChangeUserInfoKey = @"recordChange";
 {
     SKYMessageOperationType operationType =
         isNewMessage ? SKYMessageOperationTypeAdd : SKYMessageOperationTypeEdit;
+    SKYChatCacheController *cacheController = self.cacheController;
     SKYMessageOperation *operation =
-        [self.cacheController didStartMessage:message
-                               conversationID:message.conversationRef.recordID.recordName
-                                operationType:operationType];
+        [cacheController didStartMessage:message
+                          conversationID:message.conversationRef.recordID.recordName
+                           operationType:operationType];
 
     SKYDatabase *database = self.container.publicCloudDatabase;
     [database saveRecord:message.record
               completion:^(SKYRecord *record, NSError *error) {
                   SKYMessage *msg = nil;
                   if (error) {
-                      [self.cacheController didFailMessageOperation:operation error:error];
+                      [cacheController didFailMessageOperation:operation error:error];
                   } else {
                       msg = [[SKYMessage alloc] initWithRecordData:record];
-                      [self.cacheController didSaveMessage:msg];
-                      [self.cacheController didCompleteMessageOperation:operation];
+                      [cacheController didSaveMessage:msg];
+                      [cacheController didCompleteMessageOperation:operation];
                   }
 
                   if (completion) {
@@ -634,7 +807,7 @@ NSString *const SKYChatRecordChangeUserInfoKey = @"recordChange";
               uploadAsset:message.attachment
         completionHandler:^(SKYAsset *uploadedAsset, NSError *error) {
             if (error) {
-                NSLog(@"error uploading asset: %@", error);
+                SKYChatLogError(@"message", @"error uploading asset: %@", error);
 
                 // NOTE(cheungpat): No idea why we should save message
                 // when upload asset has failed, but this is the existing
@@ -646,6 +819,152 @@ NSString *const SKYChatRecordChangeUserInfoKey = @"recordChange";
         }];
 }
 
+- (void)addMessages:(NSArray<SKYMessage *> *)messages
+     toConversation:(SKYConversation *)conversation
+         completion:(SKYChatAddMessagesCompletion)completion
+{
+    if (!messages.count) {
+        if (completion) {
+            completion(@[], @{});
+        }
+        return;
+    }
+
+    NSDate *sendDate = [NSDate date];
+    for (SKYMessage *message in messages) {
+        message.conversationRef = [SKYReference referenceWithRecord:conversation.record];
+        message.sendDate = sendDate;
+    }
+
+    SKYChatCacheController *cacheController = self.cacheController;
+    NSArray<SKYMessageOperation *> *operations =
+        [cacheController didStartMessages:messages
+                           conversationID:conversation.recordID.recordName
+                            operationType:SKYMessageOperationTypeAdd];
+
+    NSMutableArray<SKYMessage *> *pendingUploads = [NSMutableArray array];
+    for (SKYMessage *message in messages) {
+        if (message.attachment && message.attachment.url.isFileURL) {
+            [pendingUploads addObject:message];
+        }
+    }
+
+    // Each upload starts the next pending one when it finishes, so that at most
+    // maxConcurrentAttachmentUploads are in progress without waiting on a thread.
+    dispatch_group_t group = dispatch_group_create();
+    NSUInteger uploadCount =
+        MIN(pendingUploads.count, (NSUInteger)MAX(1, self.maxConcurrentAttachmentUploads));
+    for (NSUInteger i = 0; i < uploadCount; i++) {
+        [self uploadNextAttachmentOfMessages:pendingUploads group:group];
+    }
+
+    dispatch_group_notify(group, dispatch_get_main_queue(), ^{
+        [self saveMessages:messages
+                operations:operations
+           cacheController:cacheController
+                completion:completion];
+    });
+}
+
+- (void)uploadNextAttachmentOfMessages:(NSMutableArray<SKYMessage *> *)pendingUploads
+                                 group:(dispatch_group_t)group
+{
+    SKYMessage *message = nil;
+    @synchronized(pendingUploads)
+    {
+        message = pendingUploads.firstObject;
+        if (message) {
+            [pendingUploads removeObjectAtIndex:0];
+        }
+    }
+    if (!message) {
+        return;
+    }
+
+    dispatch_group_enter(group);
+    [self.container.publicCloudDatabase
+              uploadAsset:message.attachment
+        completionHandler:^(SKYAsset *uploadedAsset, NSError *error) {
+            if (error) {
+                // The message is saved without the uploaded attachment, as
+                // -addMessage:toConversation:completion: does.
+                SKYChatLogError(@"message", @"error uploading asset: %@", error);
+            } else {
+                message.attachment = uploadedAsset;
+            }
+            [self uploadNextAttachmentOfMessages:pendingUploads group:group];
+            dispatch_group_leave(group);
+        }];
+}
+
+- (void)saveMessages:(NSArray<SKYMessage *> *)messages
+         operations:(NSArray<SKYMessageOperation *> *)operations
+    cacheController:(SKYChatCacheController *)cacheController
+         completion:(SKYChatAddMessagesCompletion)completion
+{
+    NSMutableArray<SKYRecord *> *records = [NSMutableArray arrayWithCapacity:messages.count];
+    for (SKYMessage *message in messages) {
+        [records addObject:message.record];
+    }
+
+    NSMutableDictionary<NSString *, NSError *> *errorsByRecordName =
+        [NSMutableDictionary dictionary];
+    [self.container.publicCloudDatabase
+                  saveRecords:records
+            completionHandler:^(NSArray *savedRecords, NSError *operationError) {
+                NSMutableDictionary<NSString *, SKYRecord *> *savedRecordsByName =
+                    [NSMutableDictionary dictionary];
+                for (SKYRecord *record in savedRecords) {
+                    savedRecordsByName[record.recordID.recordName] = record;
+                }
+
+                NSMutableArray<SKYMessage *> *resultMessages =
+                    [NSMutableArray arrayWithCapacity:messages.count];
+                NSMutableDictionary<NSNumber *, NSError *> *errorsByIndex =
+                    [NSMutableDictionary dictionary];
+                NSMutableArray<SKYMessage *> *savedMessages = [NSMutableArray array];
+                NSMutableArray<SKYMessageOperation *> *completedOperations = [NSMutableArray array];
+                NSMutableArray<SKYMessageOperation *> *failedOperations = [NSMutableArray array];
+                NSMutableArray<NSError *> *errors = [NSMutableArray array];
+                [messages enumerateObjectsUsingBlock:^(SKYMessage *message, NSUInteger idx,
+                                                       BOOL *stop) {
+                    SKYRecord *record = savedRecordsByName[message.recordName];
+                    if (record) {
+                        SKYMessage *savedMessage = [[SKYMessage alloc] initWithRecordData:record];
+                        [savedMessages addObject:savedMessage];
+                        [completedOperations addObject:operations[idx]];
+                        [resultMessages addObject:savedMessage];
+                        return;
+                    }
+
+                    NSError *error = errorsByRecordName[message.recordName] ?: operationError;
+                    if (!error) {
+                        error = [NSError errorWithDomain:SKYOperationErrorDomain
+                                                    code:SKYErrorBadResponse
+                                                userInfo:nil];
+                    }
+                    [failedOperations addObject:operations[idx]];
+                    [errors addObject:error];
+                    [resultMessages addObject:message];
+                    errorsByIndex[@(idx)] = error;
+                }];
+
+                [cacheController didSaveMessages:savedMessages
+                      completedMessageOperations:completedOperations
+                         failedMessageOperations:failedOperations
+                                          errors:errors];
+
+                if (completion) {
+                    completion(resultMessages, errorsByIndex);
+                }
+            }
+        perRecordErrorHandler:^(SKYRecord *record, NSError *error) {
+            if (record && error) {
+                errorsByRecordName[record.recordID.recordName] = error;
+            }
+        }];
+}
+
 - (void)fetchMessagesWithConversation:(SKYConversation *)conversation
                                 limit:(NSInteger)limit
                            beforeTime:(NSDate *)beforeTime
@@ -701,53 +1020,45 @@ NSString *const SKYChatRecordChangeUserInfoKey = @"recordChange";
 - (void)fetchMessagesWithArguments:(NSDictionary *)arguments
                         completion:(SKYChatFetchMessagesListCompletion)completion
 {
+    [self fetchMessagesWithArguments:arguments
+                      marksDelivered:self.automaticallyMarkMessagesAsDelivered
+                          completion:completion];
+}
+
+- (void)fetchMessagesWithArguments:(NSDictionary *)arguments
+                    marksDelivered:(BOOL)marksDelivered
+                        completion:(SKYChatFetchMessagesListCompletion)completion
+{
+    SKYChatCacheController *cacheController = self.cacheController;
     [self.container callLambda:@"chat:get_messages"
            dictionaryArguments:arguments
+              sky_chat_metrics:[SKYChatMetrics sharedMetrics]
              completionHandler:^(NSDictionary *response, NSError *error) {
                  if (error) {
-                     NSLog(@"error calling chat:get_messages: %@", error);
+                     SKYChatLogError(@"message", @"error calling chat:get_messages: %@", error);
                      if (completion) {
                          completion(nil, NO, error);
                      }
                      return;
                  }
-                 NSArray *resultArray = [response objectForKey:@"results"];
-                 NSMutableArray *returnArray = [[NSMutableArray alloc] init];
-                 for (NSDictionary *obj in resultArray) {
-                     SKYRecordDeserializer *deserializer = [SKYRecordDeserializer deserializer];
-                     SKYRecord *record = [deserializer recordWithDictionary:[obj copy]];
-
-                     SKYMessage *msg = [[SKYMessage alloc] initWithRecordData:record];
-                     if (msg) {
-                         [returnArray addObject:msg];
-                     }
-                 }
-
-                 NSArray *deletedArray = [response objectForKey:@"deleted"];
-                 NSMutableArray *returnDeletedArray =
-                     [NSMutableArray arrayWithCapacity:deletedArray.count];
-                 for (NSDictionary *obj in deletedArray) {
-                     SKYRecordDeserializer *deserializer = [SKYRecordDeserializer deserializer];
-                     SKYRecord *record = [deserializer recordWithDictionary:[obj copy]];
-                     SKYMessage *msg = [[SKYMessage alloc] initWithRecordData:record];
-                     if (msg) {
-                         [returnDeletedArray addObject:msg];
-                     }
-                 }
-
-                 [self.cacheController didFetchMessages:returnArray
-                                        deletedMessages:returnDeletedArray];
-
-                 if (completion) {
-                     completion(returnArray, NO, error);
-                 }
-
-                 // The SDK notifies the server that these messages are received
-                 // from the client side. The app developer is not required
-                 // to call this method.
-                 if (returnArray.count && self.automaticallyMarkMessagesAsDelivered) {
-                     [self markDeliveredMessages:returnArray completion:nil];
-                 }
+                 [self->messagesResponseDecoder
+                     decodeResponse:response
+                         completion:^(NSArray<SKYMessage *> *messages,
+                                      NSArray<SKYMessage *> *deletedMessages) {
+                             [cacheController didFetchMessages:messages
+                                               deletedMessages:deletedMessages];
+
+                             if (completion) {
+                                 completion(messages, NO, nil);
+                             }
+
+                             // The SDK notifies the server that these messages are received
+                             // from the client side. The app developer is not required
+                             // to call this method.
+                             if (messages.count && marksDelivered) {
+                                 [self markDeliveredMessages:messages completion:nil];
+                             }
+                         }];
              }];
 }
 
@@ -762,8 +1073,6 @@ NSString *const SKYChatRecordChangeUserInfoKey = @"recordChange";
         dictionaryWithObjectsAndKeys:conversationId, @"conversation_id", @(limit), @"limit", nil];
     if (beforeTime) {
         NSString *dateString = [SKYDataSerialization stringFromDate:beforeTime];
-        NSLog(@"dateString :%@", dateString);
-
         [arguments setObject:dateString forKey:@"before_time"];
     }
 
@@ -816,6 +1125,264 @@ NSString *const SKYChatRecordChangeUserInfoKey = @"recordChange";
     [self fetchMessagesWithArguments:arguments completion:completion];
 }
 
+- (NSMutableDictionary *)messagesArgumentsWithConversationID:(NSString *)conversationId
+                                                       limit:(NSInteger)limit
+                                                       order:(NSString *)order
+{
+    NSMutableDictionary *arguments = [NSMutableDictionary
+        dictionaryWithObjectsAndKeys:conversationId, @"conversation_id", @(limit), @"limit", nil];
+    if (order) {
+        [arguments setObject:order forKey:@"order"];
+    }
+    return arguments;
+}
+
+- (NSMutableDictionary *)messagesArgumentsWithConversationID:(NSString *)conversationId
+                                                       limit:(NSInteger)limit
+                                              afterMessageID:(NSString *)afterMessageID
+                                                       order:(NSString *)order
+{
+    // take the messages nearest to the specified one, as the cache does, which are sorted in
+    // ascending order and reversed once fetched
+    NSMutableDictionary *arguments =
+        [self messagesArgumentsWithConversationID:conversationId
+                                            limit:limit
+                                            order:order ?: @"_created_at"];
+    [arguments setObject:afterMessageID forKey:@"after_message_id"];
+    [arguments setObject:@YES forKey:@"ascending"];
+    return arguments;
+}
+
+- (void)fetchMessagesAfterWithArguments:(NSDictionary *)arguments
+                             completion:(SKYChatFetchMessagesListCompletion)completion
+{
+    [self fetchMessagesWithArguments:arguments
+                          completion:^(NSArray<SKYMessage *> *messageList, BOOL isCached,
+                                       NSError *error) {
+                              if (completion) {
+                                  completion([[messageList reverseObjectEnumerator] allObjects],
+                                             isCached, error);
+                              }
+                          }];
+}
+
+- (void)fetchMessagesWithConversationID:(NSString *)conversationId
+                                  limit:(NSInteger)limit
+                         afterMessageID:(NSString *)afterMessageID
+                                  order:(NSString *)order
+                             completion:(SKYChatFetchMessagesListCompletion)completion
+{
+    NSMutableDictionary *arguments = [self messagesArgumentsWithConversationID:conversationId
+                                                                         limit:limit
+                                                                afterMessageID:afterMessageID
+                                                                         order:order];
+
+    if (completion) {
+        [self.cacheController
+            fetchMessagesWithConversationID:conversationId
+                                      limit:limit
+                             afterMessageID:afterMessageID
+                                      order:order
+                                 completion:^(NSArray<SKYMessage *> *_Nullable messageList,
+                                              BOOL isCached, NSError *_Nullable error) {
+                                     completion(messageList, YES, error);
+                                 }];
+    }
+    [self fetchMessagesAfterWithArguments:arguments completion:completion];
+}
+
+- (void)fetchMessagesWithConversationID:(NSString *)conversationId
+                                  limit:(NSInteger)limit
+                        aroundMessageID:(NSString *)aroundMessageID
+                                  order:(NSString *)order
+                             completion:(SKYChatFetchMessagesListCompletion)completion
+{
+    NSInteger afterLimit = limit / 2;
+    NSInteger beforeLimit = MAX(limit - afterLimit - 1, 0);
+
+    if (completion) {
+        [self.cacheController
+            fetchMessagesWithConversationID:conversationId
+                                      limit:limit
+                            aroundMessageID:aroundMessageID
+                                      order:order
+                                 completion:^(NSArray<SKYMessage *> *_Nullable messageList,
+                                              BOOL isCached, NSError *_Nullable error) {
+                                     completion(messageList, YES, error);
+                                 }];
+    }
+
+    // The window is fetched as the pages before and after the message, together with the
+    // message itself, which are combined once all of them are fetched.
+    dispatch_group_t group = dispatch_group_create();
+    __block NSArray<SKYMessage *> *beforeMessages = @[];
+    __block NSArray<SKYMessage *> *afterMessages = @[];
+    __block NSArray<SKYMessage *> *aroundMessages = @[];
+    __block NSError *lastError = nil;
+
+    NSMutableDictionary *afterArguments =
+        [self messagesArgumentsWithConversationID:conversationId
+                                            limit:afterLimit
+                                   afterMessageID:aroundMessageID
+                                            order:order];
+    dispatch_group_enter(group);
+    [self fetchMessagesAfterWithArguments:afterArguments
+                               completion:^(NSArray<SKYMessage *> *messageList, BOOL isCached,
+                                            NSError *error) {
+                                   afterMessages = messageList ?: @[];
+                                   lastError = error ?: lastError;
+                                   dispatch_group_leave(group);
+                               }];
+
+    dispatch_group_enter(group);
+    [self fetchMessagesWithIDs:@[ aroundMessageID ]
+                    completion:^(NSArray<SKYMessage *> *messageList, BOOL isCached,
+                                 NSError *error) {
+                        if (isCached) {
+                            return;
+                        }
+                        aroundMessages = messageList ?: @[];
+                        lastError = error ?: lastError;
+                        dispatch_group_leave(group);
+                    }];
+
+    if (beforeLimit > 0) {
+        NSMutableDictionary *beforeArguments =
+            [self messagesArgumentsWithConversationID:conversationId
+                                                limit:beforeLimit
+                                                order:order];
+        [beforeArguments setObject:aroundMessageID forKey:@"before_message_id"];
+        dispatch_group_enter(group);
+        [self fetchMessagesWithArguments:beforeArguments
+                              completion:^(NSArray<SKYMessage *> *messageList, BOOL isCached,
+                                           NSError *error) {
+                                  beforeMessages = messageList ?: @[];
+                                  lastError = error ?: lastError;
+                                  dispatch_group_leave(group);
+                              }];
+    }
+
+    dispatch_group_notify(group, dispatch_get_main_queue(), ^{
+        if (!completion) {
+            return;
+        }
+        if (lastError) {
+            completion(nil, NO, lastError);
+            return;
+        }
+
+        NSMutableArray<SKYMessage *> *messages = [NSMutableArray array];
+        NSMutableSet<NSString *> *messageIDs = [NSMutableSet set];
+        for (NSArray<SKYMessage *> *page in @[ afterMessages, aroundMessages, beforeMessages ]) {
+            for (SKYMessage *message in page) {
+                if (![messageIDs containsObject:message.recordName]) {
+                    [messageIDs addObject:message.recordName];
+                    [messages addObject:message];
+                }
+            }
+        }
+        [messages sortUsingComparator:^NSComparisonResult(SKYMessage *obj1, SKYMessage *obj2) {
+            return [obj2.creationDate compare:obj1.creationDate];
+        }];
+        completion(messages, NO, nil);
+    });
+}
+
+#pragma mark Searching
+
+- (void)searchMessagesWithQuery:(NSString *)query
+                 inConversation:(SKYConversation *)conversation
+                          limit:(NSInteger)limit
+                     completion:(SKYChatFetchMessagesListCompletion)completion
+{
+    [self.cacheController searchMessagesWithQuery:query
+                                   conversationID:[conversation recordName]
+                                            limit:limit
+                                       completion:completion];
+}
+
+#pragma mark Prefetching
+
+- (void)prefetchMessagesWithConversations:(NSArray<SKYConversation *> *)conversations
+                                    limit:(NSInteger)limit
+                               byteBudget:(NSUInteger)byteBudget
+                               completion:(void (^)(NSUInteger fetchedBytes,
+                                                    NSError *error))completion
+{
+    [self prefetchMessagesWithConversations:conversations
+                                      index:0
+                                      limit:limit
+                                 byteBudget:byteBudget
+                               fetchedBytes:0
+                                  lastError:nil
+                                 completion:completion];
+}
+
+- (void)prefetchMessagesWithConversations:(NSArray<SKYConversation *> *)conversations
+                                    index:(NSUInteger)index
+                                    limit:(NSInteger)limit
+                               byteBudget:(NSUInteger)byteBudget
+                             fetchedBytes:(NSUInteger)fetchedBytes
+                                lastError:(NSError *)lastError
+                               completion:(void (^)(NSUInteger fetchedBytes,
+                                                    NSError *error))completion
+{
+    BOOL budgetExceeded = byteBudget > 0 && fetchedBytes >= byteBudget;
+    if (index >= conversations.count || budgetExceeded) {
+        if (completion) {
+            completion(fetchedBytes, lastError);
+        }
+        return;
+    }
+
+    SKYConversation *conversation = conversations[index];
+    void (^next)(NSUInteger, NSError *) = ^(NSUInteger bytes, NSError *error) {
+        [self prefetchMessagesWithConversations:conversations
+                                          index:index + 1
+                                          limit:limit
+                                     byteBudget:byteBudget
+                                   fetchedBytes:fetchedBytes + bytes
+                                      lastError:error ?: lastError
+                                     completion:completion];
+    };
+
+    NSString *lastMessageID = conversation.lastMessage.recordID.recordName;
+    if (lastMessageID && [self.cacheController hasMessageWithID:lastMessageID]) {
+        next(0, nil);
+        return;
+    }
+
+    NSDictionary *arguments = @{
+        @"conversation_id" : conversation.recordID.recordName,
+        @"limit" : @(limit),
+    };
+    // Prefetched messages are not marked as delivered, since the user has not opened the
+    // conversation.
+    [self fetchMessagesWithArguments:arguments
+                      marksDelivered:NO
+                          completion:^(NSArray<SKYMessage *> *messageList, BOOL isCached,
+                                       NSError *error) {
+                              if (error) {
+                                  // skip the conversation and continue with the next one
+                                  next(0, error);
+                                  return;
+                              }
+
+                              NSUInteger bytes = 0;
+                              for (SKYMessage *message in messageList) {
+                                  bytes += SKYChatEstimatedMessageSize(message);
+                              }
+
+                              [self fetchParticipants:conversation.participantIds
+                                           completion:^(NSDictionary *participantsMap,
+                                                        BOOL isCached, NSError *error) {
+                                               if (!isCached) {
+                                                   next(bytes, error);
+                                               }
+                                           }];
+                          }];
+}
+
 #pragma mark Delivery and Read Status
 
 - (void)callLambda:(NSString *)lambda
@@ -824,6 +1391,7 @@ NSString *const SKYChatRecordChangeUserInfoKey = @"recordChange";
 {
     [self.container callLambda:lambda
                      arguments:@[ messageIDs ]
+              sky_chat_metrics:[SKYChatMetrics sharedMetrics]
              completionHandler:^(NSDictionary *dict, NSError *error) {
                  if (completion) {
                      completion(error);
@@ -868,6 +1436,7 @@ NSString *const SKYChatRecordChangeUserInfoKey = @"recordChange";
 {
     [self.container callLambda:@"chat:get_receipt"
                      arguments:@[ message.recordID.recordName ]
+              sky_chat_metrics:[SKYChatMetrics sharedMetrics]
              completionHandler:^(NSDictionary *dict, NSError *error) {
                  if (!completion) {
                      return;
@@ -894,7 +1463,7 @@ NSString *const SKYChatRecordChangeUserInfoKey = @"recordChange";
          completion:(SKYChatMessageCompletion _Nullable)completion
 {
 
-    NSLog(@"Edit a message, message ID %@", message.recordID.recordName);
+    SKYChatLogInfo(@"message", @"Edit a message, message ID %@", message.recordID.recordName);
     message.body = body;
     [self saveMessage:message forNewMessage:NO completion:completion];
 }
@@ -905,16 +1474,18 @@ NSString *const SKYChatRecordChangeUserInfoKey = @"recordChange";
        inConversation:(SKYConversation *)conversation
            completion:(SKYChatConversationCompletion _Nullable)completion
 {
+    SKYChatCacheController *cacheController = self.cacheController;
     SKYMessageOperation *operation =
-        [self.cacheController didStartMessage:message
-                               conversationID:conversation.recordName
-                                operationType:SKYMessageOperationTypeDelete];
-    NSLog(@"Delete a message, messageID %@", message.recordID.recordName);
+        [cacheController didStartMessage:message
+                          conversationID:conversation.recordName
+                           operationType:SKYMessageOperationTypeDelete];
+    SKYChatLogInfo(@"message", @"Delete a message, message ID %@", message.recordID.recordName);
     [self.container callLambda:@"chat:delete_message"
                      arguments:@[ message.recordID.recordName ]
+              sky_chat_metrics:[SKYChatMetrics sharedMetrics]
              completionHandler:^(NSDictionary *response, NSError *error) {
                  if (error) {
-                     [self.cacheController didFailMessageOperation:operation error:error];
+                     [cacheController didFailMessageOperation:operation error:error];
                      if (completion) {
                          completion(nil, error);
                      }
@@ -926,8 +1497,8 @@ NSString *const SKYChatRecordChangeUserInfoKey = @"recordChange";
                  SKYRecord *record = [deserializer recordWithDictionary:[response copy]];
                  SKYMessage *msg = [[SKYMessage alloc] initWithRecordData:record];
 
-                 [self.cacheController didDeleteMessage:msg];
-                 [self.cacheController didCompleteMessageOperation:operation];
+                 [cacheController didDeleteMessage:msg];
+                 [cacheController didCompleteMessageOperation:operation];
 
                  if (completion) {
                      completion(conversation, nil);
@@ -941,15 +1512,27 @@ NSString *const SKYChatRecordChangeUserInfoKey = @"recordChange";
              inConversation:(SKYConversation *)conversation
                  completion:(SKYChatConversationCompletion)completion
 {
-    NSLog(@"Mark last read message, messageID %@", message.recordID.recordName);
+    SKYChatLogInfo(@"message", @"Mark last read message, message ID %@",
+                   message.recordID.recordName);
     [self.container callLambda:@"chat:mark_as_read"
                      arguments:@[ message.recordID.recordName ]
+              sky_chat_metrics:[SKYChatMetrics sharedMetrics]
              completionHandler:^(NSDictionary *response, NSError *error) {
+                 if (!error) {
+                     BOOL isCountKnown = [self->unreadCountTracker
+                         didReadConversationWithID:[conversation recordName]];
+                     if (!isCountKnown) {
+                         // The unread count of this conversation was not included in the
+                         // local total, so the total is reconciled with the server instead.
+                         [self reconcileUnreadCountWithCompletion:nil];
+                     }
+                 }
                  if (!completion) {
                      return;
                  }
                  if (error) {
                      completion(nil, error);
+                     return;
                  }
                  completion(conversation, error);
              }];
@@ -979,12 +1562,13 @@ NSString *const SKYChatRecordChangeUserInfoKey = @"recordChange";
 - (void)fetchTotalUnreadCount:(SKYChatUnreadCountCompletion)completion
 {
     [self.container callLambda:@"chat:total_unread"
+              sky_chat_metrics:[SKYChatMetrics sharedMetrics]
              completionHandler:^(NSDictionary *response, NSError *error) {
-                 if (!completion) {
-                     return;
-                 }
                  if (error) {
-                     completion(nil, error);
+                     if (completion) {
+                         completion(nil, error);
+                     }
+                     return;
                  }
 
                  // Ensure the dictionary has correct type of classes
@@ -995,32 +1579,189 @@ NSString *const SKYChatRecordChangeUserInfoKey = @"recordChange";
                      }
                  }];
 
-                 completion(fixedResponse, error);
+                 [self->unreadCountTracker updateWithTotalUnreadCount:fixedResponse];
+
+                 if (completion) {
+                     completion(fixedResponse, error);
+                 }
              }];
 }
 
+#pragma mark Local Unread Count
+
+- (NSDictionary<NSString *, NSNumber *> *)cachedTotalUnreadCount
+{
+    if (!unreadCountTracker.hasTotalUnreadCount) {
+        return nil;
+    }
+    return [unreadCountTracker totalUnreadCount];
+}
+
+- (NSInteger)cachedUnreadCountInConversation:(SKYConversation *)conversation
+{
+    NSInteger count = [unreadCountTracker unreadCountWithConversationID:[conversation recordName]];
+    return count >= 0 ? count : conversation.unreadCount;
+}
+
+- (void)reconcileUnreadCountWithCompletion:(SKYChatUnreadCountCompletion)completion
+{
+    [self fetchTotalUnreadCount:completion];
+}
+
+- (void)setUnreadCountReconciliationInterval:(NSTimeInterval)unreadCountReconciliationInterval
+{
+    _unreadCountReconciliationInterval = unreadCountReconciliationInterval;
+    if (subscribedUserChannel) {
+        [self startUnreadCountReconciliationTimer];
+    }
+}
+
+- (void)startUnreadCountReconciliationTimer
+{
+    [self stopUnreadCountReconciliationTimer];
+    if (self.unreadCountReconciliationInterval <= 0) {
+        return;
+    }
+
+    uint64_t interval = (uint64_t)(self.unreadCountReconciliationInterval * NSEC_PER_SEC);
+    unreadCountReconciliationTimer =
+        dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, dispatch_get_main_queue());
+    dispatch_source_set_timer(unreadCountReconciliationTimer,
+                              dispatch_time(DISPATCH_TIME_NOW, (int64_t)interval), interval,
+                              interval / 10);
+    __weak typeof(self) weakSelf = self;
+    dispatch_source_set_event_handler(unreadCountReconciliationTimer, ^{
+        [weakSelf reconcileUnreadCountWithCompletion:nil];
+    });
+    dispatch_resume(unreadCountReconciliationTimer);
+}
+
+- (void)stopUnreadCountReconciliationTimer
+{
+    if (unreadCountReconciliationTimer) {
+        dispatch_source_cancel(unreadCountReconciliationTimer);
+        unreadCountReconciliationTimer = nil;
+    }
+}
+
+- (void)handleUnreadCountWithRecordChange:(SKYChatRecordChange *)recordChange
+{
+    if (recordChange.event != SKYChatRecordChangeEventCreate ||
+        ![recordChange.recordType isEqualToString:@"message"]) {
+        return;
+    }
+
+    // Messages sent by the current user are never unread.
+    NSString *creatorID = recordChange.record.creatorUserRecordID;
+    if (!creatorID || [creatorID isEqualToString:self.container.auth.currentUserRecordID]) {
+        return;
+    }
+
+    SKYReference *ref = recordChange.record[@"conversation"];
+    if (![ref isKindOfClass:[SKYReference class]]) {
+        return;
+    }
+
+    [unreadCountTracker didReceiveMessageWithID:recordChange.record.recordID.recordName
+                                 conversationID:ref.recordID.recordName];
+}
+
+- (id)subscribeToUnreadCountWithHandler:
+    (void (^)(NSDictionary<NSString *, NSNumber *> *totalUnreadCount,
+              NSString *conversationID))handler
+{
+    if (!handler) {
+        @throw [NSException exceptionWithName:NSInvalidArgumentException
+                                       reason:@"must have handler"
+                                     userInfo:nil];
+    }
+
+    [self subscribeToUserChannelWithCompletion:nil];
+
+    return [[NSNotificationCenter defaultCenter]
+        addObserverForName:SKYChatDidChangeUnreadCountNotification
+                    object:self
+                     queue:[NSOperationQueue mainQueue]
+                usingBlock:^(NSNotification *note) {
+                    handler([note.userInfo objectForKey:SKYChatTotalUnreadCountUserInfoKey],
+                            [note.userInfo objectForKey:SKYChatConversationIDUserInfoKey]);
+                }];
+}
+
+- (void)unsubscribeToUnreadCountWithObserver:(id)observer
+{
+    [[NSNotificationCenter defaultCenter] removeObserver:observer
+                                                    name:SKYChatDidChangeUnreadCountNotification
+                                                  object:self];
+}
+
 #pragma mark Typing Indicator
 
+- (NSTimeInterval)typingIndicatorBeginInterval
+{
+    return typingIndicatorThrottle.beginInterval;
+}
+
+- (void)setTypingIndicatorBeginInterval:(NSTimeInterval)typingIndicatorBeginInterval
+{
+    typingIndicatorThrottle.beginInterval = typingIndicatorBeginInterval;
+}
+
+- (NSTimeInterval)typingIndicatorPauseInterval
+{
+    return typingIndicatorThrottle.pauseInterval;
+}
+
+- (void)setTypingIndicatorPauseInterval:(NSTimeInterval)typingIndicatorPauseInterval
+{
+    typingIndicatorThrottle.pauseInterval = typingIndicatorPauseInterval;
+}
+
+- (NSTimeInterval)typingIndicatorExpiryInterval
+{
+    return typingStateStore.expiryInterval;
+}
+
+- (void)setTypingIndicatorExpiryInterval:(NSTimeInterval)typingIndicatorExpiryInterval
+{
+    typingStateStore.expiryInterval = typingIndicatorExpiryInterval;
+}
+
+- (NSArray<NSString *> *)typingParticipantIDsInConversation:(SKYConversation *)conversation
+{
+    return [typingStateStore typingParticipantIDsWithConversationID:[conversation recordName]];
+}
+
 - (void)sendTypingIndicator:(SKYChatTypingEvent)typingEvent
              inConversation:(SKYConversation *)conversation
 {
-    [self sendTypingIndicator:typingEvent
-               inConversation:conversation
-                         date:[NSDate date]
-                   completion:nil];
+    [typingIndicatorThrottle handleTypingEvent:typingEvent
+                                conversationID:[conversation recordName]];
 }
 
 - (void)sendTypingIndicator:(SKYChatTypingEvent)typingEvent
              inConversation:(SKYConversation *)conversation
                        date:(NSDate *)date
                  completion:(void (^)(NSError *error))completion
+{
+    [self sendTypingIndicator:typingEvent
+             inConversationID:[conversation recordName]
+                         date:date
+                   completion:completion];
+}
+
+- (void)sendTypingIndicator:(SKYChatTypingEvent)typingEvent
+           inConversationID:(NSString *)conversationID
+                       date:(NSDate *)date
+                 completion:(void (^)(NSError *error))completion
 {
     [self.container callLambda:@"chat:typing"
                      arguments:@[
-                         [conversation recordName],
+                         conversationID,
                          SKYChatTypingEventToString(typingEvent),
                          [SKYDataSerialization stringFromDate:date],
                      ]
+              sky_chat_metrics:[SKYChatMetrics sharedMetrics]
              completionHandler:^(NSDictionary *dict, NSError *error) {
                  if (completion) {
                      completion(error);
@@ -1065,8 +1806,10 @@ NSString *const SKYChatRecordChangeUserInfoKey = @"recordChange";
                    completion:(SKYMessageOperationCompletion)completion
 {
     if (operation.status == SKYMessageOperationStatusPending) {
-        NSLog(@"Message operation %@ is still pending. Pending operations cannot be retried.",
-              operation.operationID);
+        SKYChatLogWarning(@"message",
+                          @"Message operation %@ is still pending. Pending operations cannot "
+                          @"be retried.",
+                          operation.operationID);
         return;
     }
 
@@ -1104,8 +1847,10 @@ NSString *const SKYChatRecordChangeUserInfoKey = @"recordChange";
 - (void)cancelMessageOperation:(SKYMessageOperation *)operation
 {
     if (operation.status == SKYMessageOperationStatusPending) {
-        NSLog(@"Message operation %@ is still pending. Pending operations cannot be cancelled.",
-              operation.operationID);
+        SKYChatLogWarning(@"message",
+                          @"Message operation %@ is still pending. Pending operations cannot "
+                          @"be cancelled.",
+                          operation.operationID);
         return;
     }
 
@@ -1246,6 +1991,14 @@ NSString *const SKYChatRecordChangeUserInfoKey = @"recordChange";
 
 - (void)handleUserChannelDictionary:(NSDictionary<NSString *, id> *)dict
 {
+    // Checked first, as in lambda calls, so that unobserved events cost nothing.
+    SKYChatMetrics *metrics = [SKYChatMetrics sharedMetrics];
+    SKYChatMetricsSpan *span = nil;
+    if (metrics.enabled) {
+        span = [metrics beginSpanWithName:@"pubsub.dispatch"];
+        [metrics incrementCounterWithName:@"pubsub.event" by:1];
+    }
+
     NSString *dictionaryEventType = dict[@"event"];
     NSDictionary *data = dict[@"data"];
     if ([SKYChatTypingIndicator isTypingIndicatorEventType:dictionaryEventType]) {
@@ -1257,6 +2010,8 @@ NSString *const SKYChatRecordChangeUserInfoKey = @"recordChange";
             SKYChatTypingIndicator *indicator =
                 [[SKYChatTypingIndicator alloc] initWithDictionary:userDict
                                                     conversationID:conversationID];
+            indicator.expiryInterval = self.typingIndicatorExpiryInterval;
+            [self->typingStateStore mergeTypingIndicator:indicator];
 
             [[NSNotificationCenter defaultCenter]
                 postNotificationName:SKYChatDidReceiveTypingIndicatorNotification
@@ -1273,6 +2028,7 @@ NSString *const SKYChatRecordChangeUserInfoKey = @"recordChange";
         }
 
         [self.cacheController handleRecordChange:recordChange];
+        [self handleUnreadCountWithRecordChange:recordChange];
 
         [[NSNotificationCenter defaultCenter]
             postNotificationName:SKYChatDidReceiveRecordChangeNotification
@@ -1285,6 +2041,8 @@ NSString *const SKYChatRecordChangeUserInfoKey = @"recordChange";
     if (self.userChannelMessageHandler) {
         self.userChannelMessageHandler(dict);
     }
+
+    [span end];
 }
 
 - (void)subscribeToUserChannelWithCompletion:(void (^)(NSError *error))completion
@@ -1316,6 +2074,10 @@ NSString *const SKYChatRecordChangeUserInfoKey = @"recordChange";
                                        [self handleUserChannelDictionary:data];
                                    }];
 
+        // Events may have been missed while the user channel was not subscribed.
+        [self reconcileUnreadCountWithCompletion:nil];
+        [self startUnreadCountReconciliationTimer];
+
         if (completion) {
             completion(nil);
         }
@@ -1328,6 +2090,7 @@ NSString *const SKYChatRecordChangeUserInfoKey = @"recordChange";
         [self.container.pubsub unsubscribe:subscribedUserChannel.name];
         subscribedUserChannel = nil;
     }
+    [self stopUnreadCountReconciliationTimer];
 }
 
 - (id)subscribeToTypingIndicatorInConversation:(SKYConversation *)conversation
@@ -1355,6 +2118,33 @@ NSString *const SKYChatRecordChangeUserInfoKey = @"recordChange";
                 }];
 }
 
+- (id)subscribeToTypingParticipantsInConversation:(SKYConversation *)conversation
+                                          handler:
+                                              (void (^)(NSArray<NSString *> *participantIDs))handler
+{
+    if (!handler) {
+        @throw [NSException exceptionWithName:NSInvalidArgumentException
+                                       reason:@"must have handler"
+                                     userInfo:nil];
+    }
+
+    [self subscribeToUserChannelWithCompletion:nil];
+
+    NSString *conversationID = [conversation recordName];
+    return [[NSNotificationCenter defaultCenter]
+        addObserverForName:SKYChatDidChangeTypingParticipantsNotification
+                    object:self
+                     queue:[NSOperationQueue mainQueue]
+                usingBlock:^(NSNotification *note) {
+                    NSString *noteConversationID =
+                        [note.userInfo objectForKey:SKYChatConversationIDUserInfoKey];
+                    if ([noteConversationID isEqualToString:conversationID]) {
+                        handler([note.userInfo
+                            objectForKey:SKYChatTypingParticipantIDsUserInfoKey]);
+                    }
+                }];
+}
+
 - (id)subscribeToMessagesInConversation:(SKYConversation *)conversation
                                 handler:(void (^)(SKYChatRecordChangeEvent event,
                                                   SKYMessage *record))handler
@@ -1408,7 +2198,9 @@ NSString *const SKYChatRecordChangeUserInfoKey = @"recordChange";
                     if (![recordChange.recordType isEqualToString:@"conversation"]) {
                         return;
                     }
-                    NSLog(@"Got conversation");
+                    SKYChatLogSampled(SKYChatLogLevelDebug, 20, @"pubsub",
+                                      @"Received conversation event %ld",
+                                      (long)recordChange.event);
 
                     handler(recordChange.event,
                             [SKYConversation recordWithRecord:recordChange.record]);
@@ -1422,6 +2214,27 @@ NSString *const SKYChatRecordChangeUserInfoKey = @"recordChange";
                                                   object:self];
 }
 
+- (SKYChatCacheLiveQuery *)observeCachedMessagesInConversation:(SKYConversation *)conversation
+                                                         limit:(NSUInteger)limit
+                                                       handler:
+                                                           (SKYChatMessagesLiveQueryHandler)handler
+{
+    return [self.cacheController liveQueryForMessagesWithConversationID:conversation.recordName
+                                                                  limit:limit
+                                                                handler:handler];
+}
+
+- (SKYChatCacheLiveQuery *)
+observeCachedMessageOperationsInConversation:(SKYConversation *)conversation
+                               operationType:(SKYMessageOperationType)type
+                                     handler:(SKYChatMessageOperationsLiveQueryHandler)handler
+{
+    return [self.cacheController
+        liveQueryForMessageOperationsWithConversationID:conversation.recordName
+                                          operationType:type
+                                                handler:handler];
+}
+
 - (void)unsubscribeToMessagesWithObserver:(id)observer
 {
     [[NSNotificationCenter defaultCenter] removeObserver:observer
@@ -1449,3 +2262,62 @@ NSString *const SKYChatRecordChangeUserInfoKey = @"recordChange";
 }
 
 @end
+
+typedef void (^SKYChatLambdaCompletionHandler)(NSDictionary *response, NSError *error);
+
+static SKYChatLambdaCompletionHandler
+SKYChatInstrumentedLambdaCompletionHandler(NSString *lambda, SKYChatMetrics *metrics,
+                                           SKYChatLambdaCompletionHandler completionHandler)
+{
+    // Checked before the span name is formatted, so that an unobserved call costs nothing.
+    if (!metrics.enabled) {
+        return completionHandler;
+    }
+
+    SKYChatMetricsSpan *span =
+        [metrics beginSpanWithName:[@"lambda." stringByAppendingString:lambda]];
+    return ^(NSDictionary *response, NSError *error) {
+        [span end];
+        if (error) {
+            [metrics incrementCounterWithName:@"lambda.error" by:1];
+        }
+        if (completionHandler) {
+            completionHandler(response, error);
+        }
+    };
+}
+
+@implementation SKYContainer (SKYChatMetrics)
+
+- (void)callLambda:(NSString *)lambda
+     sky_chat_metrics:(SKYChatMetrics *)metrics
+    completionHandler:(void (^)(NSDictionary *, NSError *))completionHandler
+{
+    [self callLambda:lambda
+        completionHandler:SKYChatInstrumentedLambdaCompletionHandler(lambda, metrics,
+                                                                     completionHandler)];
+}
+
+- (void)callLambda:(NSString *)lambda
+            arguments:(NSArray *)arguments
+     sky_chat_metrics:(SKYChatMetrics *)metrics
+    completionHandler:(void (^)(NSDictionary *, NSError *))completionHandler
+{
+    [self callLambda:lambda
+                arguments:arguments
+        completionHandler:SKYChatInstrumentedLambdaCompletionHandler(lambda, metrics,
+                                                                     completionHandler)];
+}
+
+- (void)callLambda:(NSString *)lambda
+    dictionaryArguments:(NSDictionary *)arguments
+       sky_chat_metrics:(SKYChatMetrics *)metrics
+      completionHandler:(void (^)(NSDictionary *, NSError *))completionHandler
+{
+    [self callLambda:lambda
+        dictionaryArguments:arguments
+          completionHandler:SKYChatInstrumentedLambdaCompletionHandler(lambda, metrics,
+                                                                       completionHandler)];
+}
+
+@end
@@ -30,7 +30,7 @@ NS_ASSUME_NONNULL_BEGIN
 @property (assign, nonatomic, readonly)
     SKYContainer *container; // SKYContainer will keep a strong reference of this object.
 
-@property (assign, nonatomic, readonly) SKYChatCacheController *cacheController;
+@property (strong, nonatomic, readonly) SKYChatCacheController *cacheController;
 
 /**
  Creates an instance of SKYChatExtension.
@@ -44,6 +44,15 @@ NS_ASSUME_NONNULL_BEGIN
 - (nullable instancetype)initWithContainer:(SKYContainer *)container
                            cacheController:(SKYChatCacheController *)cacheController;
 
+/**
+ Creates an instance of SKYChatExtension that keeps a separate cache for each user of the
+ container, and switches to the cache of the new user when the current user changes.
+
+ @param container the SKYContainer that contains user credentials and server configuration
+ @return an instance of SKYChatExtension
+ */
+- (nullable instancetype)initWithContainer:(SKYContainer *)container;
+
 @end
 
 NS_ASSUME_NONNULL_END
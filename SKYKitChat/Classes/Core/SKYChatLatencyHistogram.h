@@ -0,0 +1,62 @@
+//
+//  SKYChatLatencyHistogram.h
+//  SKYKitChat
+//
+//  Copyright 2016 Oursky Ltd.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ SKYChatLatencyHistogram records durations into logarithmic buckets, each power of two of
+ microseconds being split into 16 linear buckets. Percentiles are accurate to within about 6%
+ of the recorded value, using a fixed amount of memory regardless of the number of values.
+ */
+@interface SKYChatLatencyHistogram : NSObject <NSCopying>
+
+/**
+ The number of values recorded.
+ */
+@property (nonatomic, readonly) NSUInteger count;
+
+/**
+ The smallest value recorded, in seconds.
+ */
+@property (nonatomic, readonly) NSTimeInterval minValue;
+
+/**
+ The largest value recorded, in seconds.
+ */
+@property (nonatomic, readonly) NSTimeInterval maxValue;
+
+/**
+ The mean of the values recorded, in seconds.
+ */
+@property (nonatomic, readonly) NSTimeInterval meanValue;
+
+- (void)recordValue:(NSTimeInterval)value;
+
+/**
+ Returns the value at a percentile between 0 and 100, in seconds.
+ */
+- (NSTimeInterval)valueAtPercentile:(double)percentile;
+
+- (void)reset;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,140 @@
+//
+//  SKYChatLatencyHistogram.m
+//  SKYKitChat
+//
+//  Copyright 2016 Oursky Ltd.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "SKYChatLatencyHistogram.h"
+
+// Values are recorded in microseconds. Values below 16 have a bucket each,
+// and every power of two above is split into 16 buckets, up to 2^40us.
+enum {
+    SKYChatHistogramSubBucketBits = 4,
+    SKYChatHistogramSubBucketCount = 1 << SKYChatHistogramSubBucketBits,
+    SKYChatHistogramMaxExponent = 40,
+    SKYChatHistogramBucketCount =
+        (SKYChatHistogramMaxExponent - SKYChatHistogramSubBucketBits + 2) *
+        SKYChatHistogramSubBucketCount,
+};
+
+static NSUInteger SKYChatHistogramBucketIndex(uint64_t value)
+{
+    if (value < SKYChatHistogramSubBucketCount) {
+        return (NSUInteger)value;
+    }
+
+    NSUInteger exponent = 63 - __builtin_clzll(value);
+    if (exponent > SKYChatHistogramMaxExponent) {
+        return SKYChatHistogramBucketCount - 1;
+    }
+    NSUInteger shift = exponent - SKYChatHistogramSubBucketBits;
+    NSUInteger subBucket = (NSUInteger)(value >> shift) - SKYChatHistogramSubBucketCount;
+    return (exponent - SKYChatHistogramSubBucketBits + 1) * SKYChatHistogramSubBucketCount +
+           subBucket;
+}
+
+static uint64_t SKYChatHistogramBucketValue(NSUInteger index)
+{
+    if (index < SKYChatHistogramSubBucketCount) {
+        return index;
+    }
+
+    NSUInteger shift = index / SKYChatHistogramSubBucketCount - 1;
+    uint64_t subBucket = index % SKYChatHistogramSubBucketCount + SKYChatHistogramSubBucketCount;
+    // The middle of the bucket.
+    return (subBucket << shift) + ((1ULL << shift) >> 1);
+}
+
+@implementation SKYChatLatencyHistogram {
+    uint64_t buckets[SKYChatHistogramBucketCount];
+    uint64_t totalValue;
+    uint64_t minMicroseconds;
+    uint64_t maxMicroseconds;
+}
+
+- (instancetype)init
+{
+    if ((self = [super init])) {
+        [self reset];
+    }
+    return self;
+}
+
+- (id)copyWithZone:(NSZone *)zone
+{
+    SKYChatLatencyHistogram *histogram = [[SKYChatLatencyHistogram allocWithZone:zone] init];
+    memcpy(histogram->buckets, buckets, sizeof(buckets));
+    histogram->_count = _count;
+    histogram->totalValue = totalValue;
+    histogram->minMicroseconds = minMicroseconds;
+    histogram->maxMicroseconds = maxMicroseconds;
+    return histogram;
+}
+
+- (void)recordValue:(NSTimeInterval)value
+{
+    uint64_t microseconds = value > 0 ? (uint64_t)(value * 1e6) : 0;
+    buckets[SKYChatHistogramBucketIndex(microseconds)] += 1;
+    _count += 1;
+    totalValue += microseconds;
+    minMicroseconds = MIN(minMicroseconds, microseconds);
+    maxMicroseconds = MAX(maxMicroseconds, microseconds);
+}
+
+- (NSTimeInterval)minValue
+{
+    return _count ? minMicroseconds / 1e6 : 0;
+}
+
+- (NSTimeInterval)maxValue
+{
+    return maxMicroseconds / 1e6;
+}
+
+- (NSTimeInterval)meanValue
+{
+    return _count ? (double)totalValue / _count / 1e6 : 0;
+}
+
+- (NSTimeInterval)valueAtPercentile:(double)percentile
+{
+    if (!_count) {
+        return 0;
+    }
+
+    double rank = MIN(MAX(percentile, 0), 100) / 100 * _count;
+    uint64_t target = MAX((uint64_t)ceil(rank), 1);
+    uint64_t accumulated = 0;
+    for (NSUInteger i = 0; i < SKYChatHistogramBucketCount; i++) {
+        accumulated += buckets[i];
+        if (accumulated >= target) {
+            uint64_t value = SKYChatHistogramBucketValue(i);
+            return MIN(MAX(value, minMicroseconds), maxMicroseconds) / 1e6;
+        }
+    }
+    return self.maxValue;
+}
+
+- (void)reset
+{
+    memset(buckets, 0, sizeof(buckets));
+    _count = 0;
+    totalValue = 0;
+    minMicroseconds = UINT64_MAX;
+    maxMicroseconds = 0;
+}
+
+@end
@@ -0,0 +1,116 @@
+//
+//  SKYChatLogger.h
+//  SKYKitChat
+//
+//  Copyright 2016 Oursky Ltd.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+typedef NS_ENUM(NSInteger, SKYChatLogLevel) {
+    SKYChatLogLevelNone = 0,
+    SKYChatLogLevelError,
+    SKYChatLogLevelWarning,
+    SKYChatLogLevelInfo,
+    SKYChatLogLevelDebug,
+};
+
+typedef void (^SKYChatLogHandler)(SKYChatLogLevel level, NSString *category, NSString *message);
+
+/**
+ The most verbose level compiled into the SDK. Log statements above this level are removed at
+ compile time. Define this in the preprocessor macros of the pod target to change it.
+ */
+#ifndef SKYCHAT_LOG_MAX_LEVEL
+#ifdef DEBUG
+#define SKYCHAT_LOG_MAX_LEVEL SKYChatLogLevelDebug
+#else
+#define SKYCHAT_LOG_MAX_LEVEL SKYChatLogLevelInfo
+#endif
+#endif
+
+/**
+ The log level at runtime. Use SKYChatLogger to change it.
+ */
+extern SKYChatLogLevel SKYChatLogCurrentLevel;
+
+/**
+ SKYChatLogger controls the logging of the chat extension.
+
+ Logs are written with NSLog by default. Logs are filtered by level before the message is
+ formatted, so disabled log statements do not evaluate their arguments.
+ */
+@interface SKYChatLogger : NSObject
+
+/**
+ Gets or sets the most verbose level to be logged.
+
+ The default is SKYChatLogLevelWarning.
+ */
+@property (class, nonatomic, assign) SKYChatLogLevel logLevel;
+
+/**
+ Gets or sets the handler of logs. Set to nil to write logs with NSLog.
+
+ The handler can be called on any thread.
+ */
+@property (class, nonatomic, copy, nullable) SKYChatLogHandler logHandler;
+
++ (void)logWithLevel:(SKYChatLogLevel)level
+            category:(NSString *)category
+             message:(NSString *)message
+    /* clang-format off */ NS_SWIFT_NAME(log(level:category:message:)); /* clang-format on */
+
++ (void)logWithLevel:(SKYChatLogLevel)level
+            category:(NSString *)category
+              format:(NSString *)format, ... NS_FORMAT_FUNCTION(3, 4) NS_SWIFT_UNAVAILABLE("");
+
+@end
+
+/**
+ Returns YES for one in every interval calls with the same counter. Used by the sampled log
+ macros.
+ */
+FOUNDATION_EXPORT BOOL SKYChatLogShouldSample(int64_t *counter, int64_t interval);
+
+NS_ASSUME_NONNULL_END
+
+#define SKYChatLogIsEnabled(lvl) (SKYCHAT_LOG_MAX_LEVEL >= (lvl) && SKYChatLogCurrentLevel >= (lvl))
+
+#define SKYChatLog(lvl, cat, fmt, ...)                                                             \
+    do {                                                                                           \
+        if (SKYChatLogIsEnabled(lvl)) {                                                            \
+            [SKYChatLogger logWithLevel:(lvl) category:(cat) format:(fmt), ##__VA_ARGS__];         \
+        }                                                                                          \
+    } while (0)
+
+/**
+ Logs one in every interval calls of this statement, for events of high volume.
+ */
+#define SKYChatLogSampled(lvl, interval, cat, fmt, ...)                                            \
+    do {                                                                                           \
+        static int64_t __skychat_log_sample_counter = 0;                                           \
+        if (SKYChatLogIsEnabled(lvl) &&                                                            \
+            SKYChatLogShouldSample(&__skychat_log_sample_counter, (interval))) {                   \
+            [SKYChatLogger logWithLevel:(lvl) category:(cat) format:(fmt), ##__VA_ARGS__];         \
+        }                                                                                          \
+    } while (0)
+
+#define SKYChatLogError(cat, fmt, ...) SKYChatLog(SKYChatLogLevelError, cat, fmt, ##__VA_ARGS__)
+#define SKYChatLogWarning(cat, fmt, ...) SKYChatLog(SKYChatLogLevelWarning, cat, fmt, ##__VA_ARGS__)
+#define SKYChatLogInfo(cat, fmt, ...) SKYChatLog(SKYChatLogLevelInfo, cat, fmt, ##__VA_ARGS__)
+#define SKYChatLogDebug(cat, fmt, ...) SKYChatLog(SKYChatLogLevelDebug, cat, fmt, ##__VA_ARGS__)
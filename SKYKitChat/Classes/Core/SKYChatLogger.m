@@ -0,0 +1,111 @@
+//
+//  SKYChatLogger.m
+//  SKYKitChat
+//
+//  Copyright 2016 Oursky Ltd.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "SKYChatLogger.h"
+
+SKYChatLogLevel SKYChatLogCurrentLevel = SKYChatLogLevelWarning;
+
+static SKYChatLogHandler SKYChatLoggerHandler = nil;
+
+BOOL SKYChatLogShouldSample(int64_t *counter, int64_t interval)
+{
+    if (interval <= 1) {
+        return YES;
+    }
+    int64_t count = __sync_add_and_fetch(counter, 1);
+    return (count - 1) % interval == 0;
+}
+
+static NSString *SKYChatLogLevelName(SKYChatLogLevel level)
+{
+    switch (level) {
+        case SKYChatLogLevelError:
+            return @"ERROR";
+        case SKYChatLogLevelWarning:
+            return @"WARN";
+        case SKYChatLogLevelInfo:
+            return @"INFO";
+        case SKYChatLogLevelDebug:
+            return @"DEBUG";
+        default:
+            return @"";
+    }
+}
+
+@implementation SKYChatLogger
+
++ (SKYChatLogLevel)logLevel
+{
+    return SKYChatLogCurrentLevel;
+}
+
++ (void)setLogLevel:(SKYChatLogLevel)logLevel
+{
+    SKYChatLogCurrentLevel = logLevel;
+}
+
++ (SKYChatLogHandler)logHandler
+{
+    @synchronized(self)
+    {
+        return SKYChatLoggerHandler;
+    }
+}
+
++ (void)setLogHandler:(SKYChatLogHandler)logHandler
+{
+    @synchronized(self)
+    {
+        SKYChatLoggerHandler = [logHandler copy];
+    }
+}
+
++ (void)logWithLevel:(SKYChatLogLevel)level
+            category:(NSString *)category
+             message:(NSString *)message
+{
+    if (!SKYChatLogIsEnabled(level)) {
+        return;
+    }
+
+    SKYChatLogHandler handler = [self logHandler];
+    if (handler) {
+        handler(level, category, message);
+    } else {
+        NSLog(@"[SKYKitChat] %@ [%@] %@", SKYChatLogLevelName(level), category, message);
+    }
+}
+
++ (void)logWithLevel:(SKYChatLogLevel)level
+            category:(NSString *)category
+              format:(NSString *)format, ...
+{
+    if (!SKYChatLogIsEnabled(level)) {
+        return;
+    }
+
+    va_list args;
+    va_start(args, format);
+    NSString *message = [[NSString alloc] initWithFormat:format arguments:args];
+    va_end(args);
+
+    [self logWithLevel:level category:category message:message];
+}
+
+@end
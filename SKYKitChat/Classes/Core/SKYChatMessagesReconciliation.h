@@ -0,0 +1,69 @@
+//
+//  SKYChatMessagesReconciliation.h
+//  SKYKitChat
+//
+//
+//  Copyright 2016 Oursky Ltd.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+//
+
+#import <Foundation/Foundation.h>
+
+#import "SKYMessage.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ SKYChatMessagesReconciliation compares a page of cached messages with the same page fetched
+ from the server.
+
+ Messages are matched by ID. A message in both pages is regarded as updated only when its
+ revision differs, so a UI can apply the changed messages alone, and skip relayout when the
+ server page is identical to the cached page.
+ */
+@interface SKYChatMessagesReconciliation : NSObject
+
+/**
+ Messages in the server page that are not in the cached page.
+ */
+@property (nonatomic, readonly) NSArray<SKYMessage *> *insertedMessages;
+
+/**
+ Messages in both pages with a different revision, as returned by the server.
+ */
+@property (nonatomic, readonly) NSArray<SKYMessage *> *updatedMessages;
+
+/**
+ Messages in the cached page that are not in the server page.
+ */
+@property (nonatomic, readonly) NSArray<SKYMessage *> *removedMessages;
+
+/**
+ Whether the server page differs from the cached page.
+ */
+@property (nonatomic, readonly) BOOL hasChanges;
+
+- (instancetype)initWithCachedMessages:(NSArray<SKYMessage *> *)cachedMessages
+                        serverMessages:(NSArray<SKYMessage *> *)serverMessages;
+
+/**
+ Returns whether two versions of a message have the same revision, which is determined by the
+ modification date, deleted flag and message status.
+ */
++ (BOOL)isMessage:(SKYMessage *)message sameRevisionAsMessage:(SKYMessage *)otherMessage;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,86 @@
+//
+//  SKYChatMessagesReconciliation.m
+//  SKYKitChat
+//
+//
+//  Copyright 2016 Oursky Ltd.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+//
+
+#import "SKYChatMessagesReconciliation.h"
+
+static BOOL SKYChatObjectsEqual(id object, id otherObject)
+{
+    return object == otherObject || [object isEqual:otherObject];
+}
+
+@implementation SKYChatMessagesReconciliation
+
+- (instancetype)initWithCachedMessages:(NSArray<SKYMessage *> *)cachedMessages
+                        serverMessages:(NSArray<SKYMessage *> *)serverMessages
+{
+    if ((self = [super init])) {
+        NSMutableDictionary<NSString *, SKYMessage *> *cachedMessagesByID =
+            [NSMutableDictionary dictionaryWithCapacity:cachedMessages.count];
+        for (SKYMessage *message in cachedMessages) {
+            cachedMessagesByID[message.recordName] = message;
+        }
+
+        NSMutableArray<SKYMessage *> *insertedMessages = [NSMutableArray array];
+        NSMutableArray<SKYMessage *> *updatedMessages = [NSMutableArray array];
+        for (SKYMessage *message in serverMessages) {
+            SKYMessage *cachedMessage = cachedMessagesByID[message.recordName];
+            if (!cachedMessage) {
+                [insertedMessages addObject:message];
+            } else if (![SKYChatMessagesReconciliation isMessage:cachedMessage
+                                           sameRevisionAsMessage:message]) {
+                [updatedMessages addObject:message];
+            }
+            [cachedMessagesByID removeObjectForKey:message.recordName];
+        }
+
+        NSMutableArray<SKYMessage *> *removedMessages = [NSMutableArray array];
+        for (SKYMessage *message in cachedMessages) {
+            if (cachedMessagesByID[message.recordName]) {
+                [removedMessages addObject:message];
+            }
+        }
+
+        _insertedMessages = [insertedMessages copy];
+        _updatedMessages = [updatedMessages copy];
+        _removedMessages = [removedMessages copy];
+    }
+    return self;
+}
+
+- (BOOL)hasChanges
+{
+    return self.insertedMessages.count || self.updatedMessages.count ||
+           self.removedMessages.count;
+}
+
++ (BOOL)isMessage:(SKYMessage *)message sameRevisionAsMessage:(SKYMessage *)otherMessage
+{
+    // Edits and deletions update the modification date of the message record. The status and
+    // the deleted flag are compared as well, so that a change is not missed when the server
+    // updates them without the modification date.
+    SKYRecord *record = message.record;
+    SKYRecord *otherRecord = otherMessage.record;
+    return SKYChatObjectsEqual(record.modificationDate, otherRecord.modificationDate) &&
+           SKYChatObjectsEqual(record[SKYMessageStatusKey], otherRecord[SKYMessageStatusKey]) &&
+           SKYChatObjectsEqual(record[SKYMessageDeletedKey], otherRecord[SKYMessageDeletedKey]);
+}
+
+@end
@@ -0,0 +1,52 @@
+//
+//  SKYChatMessagesResponseDecoder.h
+//  SKYKitChat
+//
+//  Copyright 2016 Oursky Ltd.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "SKYMessage.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+typedef void (^SKYChatMessagesResponseCompletion)(NSArray<SKYMessage *> *messages,
+                                                  NSArray<SKYMessage *> *deletedMessages);
+
+/**
+ SKYChatMessagesResponseDecoder decodes messages from the response of chat:get_messages.
+
+ Decoding is done on a serial background queue with a single record deserializer. The
+ completion is called on the main queue.
+
+ App developer should not use this class directly.
+ */
+@interface SKYChatMessagesResponseDecoder : NSObject
+
+/**
+ Decodes the messages and deleted messages of a response.
+ */
+- (void)decodeResponse:(NSDictionary *)response
+            completion:(SKYChatMessagesResponseCompletion)completion;
+
+/**
+ Decodes messages from record dictionaries synchronously on the calling thread.
+ */
+- (NSArray<SKYMessage *> *)messagesWithDictionaries:(NSArray<NSDictionary *> *)dictionaries;
+
+@end
+
+NS_ASSUME_NONNULL_END
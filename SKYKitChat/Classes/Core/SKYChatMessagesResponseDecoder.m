@@ -0,0 +1,85 @@
+//
+//  SKYChatMessagesResponseDecoder.m
+//  SKYKitChat
+//
+//  Copyright 2016 Oursky Ltd.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "SKYChatMessagesResponseDecoder.h"
+
+#import <SKYKit/SKYKit.h>
+
+@implementation SKYChatMessagesResponseDecoder {
+    dispatch_queue_t decodeQueue;
+    SKYRecordDeserializer *deserializer;
+}
+
+- (instancetype)init
+{
+    if ((self = [super init])) {
+        decodeQueue =
+            dispatch_queue_create("io.skygear.chat.messages-decoder", DISPATCH_QUEUE_SERIAL);
+        deserializer = [SKYRecordDeserializer deserializer];
+    }
+    return self;
+}
+
+- (void)decodeResponse:(NSDictionary *)response
+            completion:(SKYChatMessagesResponseCompletion)completion
+{
+    NSArray *results = response[@"results"];
+    NSArray *deleted = response[@"deleted"];
+
+    dispatch_async(decodeQueue, ^{
+        NSArray<SKYMessage *> *messages =
+            [self decodeDictionaries:results withDeserializer:self->deserializer];
+        NSArray<SKYMessage *> *deletedMessages =
+            [self decodeDictionaries:deleted withDeserializer:self->deserializer];
+
+        dispatch_async(dispatch_get_main_queue(), ^{
+            completion(messages, deletedMessages);
+        });
+    });
+}
+
+- (NSArray<SKYMessage *> *)messagesWithDictionaries:(NSArray<NSDictionary *> *)dictionaries
+{
+    // Decoded on the caller's thread with its own deserializer, since the shared one is only
+    // used on the decode queue.
+    return [self decodeDictionaries:dictionaries
+                   withDeserializer:[SKYRecordDeserializer deserializer]];
+}
+
+- (NSArray<SKYMessage *> *)decodeDictionaries:(NSArray<NSDictionary *> *)dictionaries
+                             withDeserializer:(SKYRecordDeserializer *)recordDeserializer
+{
+    NSMutableArray<SKYMessage *> *messages = [NSMutableArray arrayWithCapacity:dictionaries.count];
+    for (NSDictionary *dict in dictionaries) {
+        if (![dict isKindOfClass:[NSDictionary class]]) {
+            continue;
+        }
+
+        // The deserializer does not mutate the dictionary, so it is passed
+        // without copying.
+        SKYRecord *record = [recordDeserializer recordWithDictionary:dict];
+        SKYMessage *message = [[SKYMessage alloc] initWithRecordData:record];
+        if (message) {
+            [messages addObject:message];
+        }
+    }
+    return messages;
+}
+
+@end
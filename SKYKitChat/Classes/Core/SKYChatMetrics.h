@@ -0,0 +1,135 @@
+//
+//  SKYChatMetrics.h
+//  SKYKitChat
+//
+//  Copyright 2016 Oursky Ltd.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "SKYChatLatencyHistogram.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class SKYChatMetrics;
+
+/**
+ Implement SKYChatMetricsDelegate to export the metrics of the chat extension to your own
+ telemetry. Delegate methods are called on the thread where the metric is recorded.
+ */
+@protocol SKYChatMetricsDelegate <NSObject>
+
+@optional
+
+- (void)chatMetrics:(SKYChatMetrics *)metrics
+    didEndSpanWithName:(NSString *)name
+              duration:(NSTimeInterval)duration
+    /* clang-format off */ NS_SWIFT_NAME(chatMetrics(_:didEndSpan:duration:)); /* clang-format on */
+
+- (void)chatMetrics:(SKYChatMetrics *)metrics
+    didIncrementCounterWithName:(NSString *)name
+                             by:(NSInteger)value
+    /* clang-format off */ NS_SWIFT_NAME(chatMetrics(_:didIncrementCounter:by:)); /* clang-format on */
+
+@end
+
+/**
+ SKYChatMetricsSpan measures the duration of an operation. Call -end when the operation
+ finishes.
+ */
+@interface SKYChatMetricsSpan : NSObject
+
+@property (nonatomic, readonly, copy) NSString *name;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/**
+ Ends the span and records its duration. Calling this more than once has no effect.
+ */
+- (void)end;
+
+@end
+
+/**
+ SKYChatMetrics collects spans and counters at the hot paths of the chat extension, such as
+ lambda calls, cache queries and pubsub events.
+
+ Metrics are only collected when a delegate is set, histograms are recorded, or signposts are
+ emitted. Otherwise -beginSpanWithName: returns nil and nothing is recorded.
+ */
+@interface SKYChatMetrics : NSObject
+
+@property (class, nonatomic, readonly, strong) SKYChatMetrics *sharedMetrics;
+
+/**
+ Gets or sets the delegate receiving the metrics.
+ */
+@property (nonatomic, weak, nullable) id<SKYChatMetricsDelegate> delegate;
+
+/**
+ Gets or sets whether span durations are recorded into histograms by span name.
+
+ The default is NO.
+ */
+@property (nonatomic, assign) BOOL recordsHistograms;
+
+/**
+ Gets or sets whether spans are emitted as signposts to be viewed in Instruments. Signposts
+ are only available on iOS 12 or later.
+
+ The default is NO.
+ */
+@property (nonatomic, assign) BOOL emitsSignposts;
+
+/**
+ Whether metrics are being collected.
+ */
+@property (nonatomic, readonly, getter=isEnabled) BOOL enabled;
+
+/**
+ Begins a span, or returns nil if metrics are not being collected.
+ */
+- (SKYChatMetricsSpan *_Nullable)beginSpanWithName:(NSString *)name
+    /* clang-format off */ NS_SWIFT_NAME(beginSpan(name:)); /* clang-format on */
+
+/**
+ Records the duration of an operation measured elsewhere.
+ */
+- (void)recordDuration:(NSTimeInterval)duration withName:(NSString *)name
+    /* clang-format off */ NS_SWIFT_NAME(recordDuration(_:name:)); /* clang-format on */
+
+- (void)incrementCounterWithName:(NSString *)name by:(NSInteger)value
+    /* clang-format off */ NS_SWIFT_NAME(incrementCounter(name:by:)); /* clang-format on */
+
+/**
+ Returns the value of a counter.
+ */
+- (NSInteger)counterValueWithName:(NSString *)name
+    /* clang-format off */ NS_SWIFT_NAME(counterValue(name:)); /* clang-format on */
+
+/**
+ Returns a copy of the histogram of a span, or nil if no duration is recorded.
+ */
+- (SKYChatLatencyHistogram *_Nullable)histogramWithName:(NSString *)name
+    /* clang-format off */ NS_SWIFT_NAME(histogram(name:)); /* clang-format on */
+
+/**
+ Clears the counters and histograms.
+ */
+- (void)reset;
+
+@end
+
+NS_ASSUME_NONNULL_END
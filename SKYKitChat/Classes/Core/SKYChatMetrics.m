@@ -0,0 +1,218 @@
+//
+//  SKYChatMetrics.m
+//  SKYKitChat
+//
+//  Copyright 2016 Oursky Ltd.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "SKYChatMetrics.h"
+
+#if __has_include(<os/signpost.h>)
+#import <os/signpost.h>
+#define SKYCHAT_SIGNPOST_AVAILABLE 1
+#endif
+
+@interface SKYChatMetricsSpan ()
+
+- (instancetype)initWithName:(NSString *)name metrics:(SKYChatMetrics *)metrics;
+
+@end
+
+@interface SKYChatMetrics ()
+
+- (void)didEndSpan:(SKYChatMetricsSpan *)span duration:(NSTimeInterval)duration;
+
+#ifdef SKYCHAT_SIGNPOST_AVAILABLE
+- (os_log_t)signpostLog API_AVAILABLE(ios(12.0));
+#endif
+
+@end
+
+@implementation SKYChatMetricsSpan {
+    __weak SKYChatMetrics *metrics;
+    NSTimeInterval startTime;
+    BOOL hasEnded;
+#ifdef SKYCHAT_SIGNPOST_AVAILABLE
+    uint64_t signpostID;
+#endif
+}
+
+- (instancetype)initWithName:(NSString *)name metrics:(SKYChatMetrics *)aMetrics
+{
+    if ((self = [super init])) {
+        _name = [name copy];
+        metrics = aMetrics;
+        startTime = [NSProcessInfo processInfo].systemUptime;
+
+#ifdef SKYCHAT_SIGNPOST_AVAILABLE
+        if (@available(iOS 12.0, *)) {
+            if (aMetrics.emitsSignposts) {
+                os_log_t log = [aMetrics signpostLog];
+                signpostID = os_signpost_id_generate(log);
+                os_signpost_interval_begin(log, signpostID, "Span", "%{public}s", name.UTF8String);
+            }
+        }
+#endif
+    }
+    return self;
+}
+
+- (void)end
+{
+    @synchronized(self)
+    {
+        if (hasEnded) {
+            return;
+        }
+        hasEnded = YES;
+    }
+
+    NSTimeInterval duration = [NSProcessInfo processInfo].systemUptime - startTime;
+
+#ifdef SKYCHAT_SIGNPOST_AVAILABLE
+    if (@available(iOS 12.0, *)) {
+        if (signpostID) {
+            os_signpost_interval_end([metrics signpostLog], signpostID, "Span", "%{public}s",
+                                     _name.UTF8String);
+        }
+    }
+#endif
+
+    [metrics didEndSpan:self duration:duration];
+}
+
+@end
+
+@implementation SKYChatMetrics {
+    NSMutableDictionary<NSString *, NSNumber *> *counters;
+    NSMutableDictionary<NSString *, SKYChatLatencyHistogram *> *histograms;
+#ifdef SKYCHAT_SIGNPOST_AVAILABLE
+    id signpostLog;
+#endif
+}
+
++ (SKYChatMetrics *)sharedMetrics
+{
+    static dispatch_once_t onceToken;
+    static SKYChatMetrics *metrics;
+    dispatch_once(&onceToken, ^{
+        metrics = [[SKYChatMetrics alloc] init];
+    });
+    return metrics;
+}
+
+- (instancetype)init
+{
+    if ((self = [super init])) {
+        counters = [NSMutableDictionary dictionary];
+        histograms = [NSMutableDictionary dictionary];
+    }
+    return self;
+}
+
+#ifdef SKYCHAT_SIGNPOST_AVAILABLE
+- (os_log_t)signpostLog
+{
+    @synchronized(self)
+    {
+        if (!signpostLog) {
+            signpostLog = os_log_create("io.skygear.chat", "Metrics");
+        }
+        return signpostLog;
+    }
+}
+#endif
+
+- (BOOL)isEnabled
+{
+    return self.delegate != nil || self.recordsHistograms || self.emitsSignposts;
+}
+
+- (SKYChatMetricsSpan *)beginSpanWithName:(NSString *)name
+{
+    if (!self.enabled) {
+        return nil;
+    }
+    return [[SKYChatMetricsSpan alloc] initWithName:name metrics:self];
+}
+
+- (void)didEndSpan:(SKYChatMetricsSpan *)span duration:(NSTimeInterval)duration
+{
+    [self recordDuration:duration withName:span.name];
+}
+
+- (void)recordDuration:(NSTimeInterval)duration withName:(NSString *)name
+{
+    if (self.recordsHistograms) {
+        @synchronized(self)
+        {
+            SKYChatLatencyHistogram *histogram = histograms[name];
+            if (!histogram) {
+                histogram = [[SKYChatLatencyHistogram alloc] init];
+                histograms[name] = histogram;
+            }
+            [histogram recordValue:duration];
+        }
+    }
+
+    id<SKYChatMetricsDelegate> delegate = self.delegate;
+    if ([delegate respondsToSelector:@selector(chatMetrics:didEndSpanWithName:duration:)]) {
+        [delegate chatMetrics:self didEndSpanWithName:name duration:duration];
+    }
+}
+
+- (void)incrementCounterWithName:(NSString *)name by:(NSInteger)value
+{
+    if (!self.enabled) {
+        return;
+    }
+
+    @synchronized(self)
+    {
+        counters[name] = @(counters[name].integerValue + value);
+    }
+
+    id<SKYChatMetricsDelegate> delegate = self.delegate;
+    if ([delegate respondsToSelector:@selector(chatMetrics:didIncrementCounterWithName:by:)]) {
+        [delegate chatMetrics:self didIncrementCounterWithName:name by:value];
+    }
+}
+
+- (NSInteger)counterValueWithName:(NSString *)name
+{
+    @synchronized(self)
+    {
+        return counters[name].integerValue;
+    }
+}
+
+- (SKYChatLatencyHistogram *)histogramWithName:(NSString *)name
+{
+    @synchronized(self)
+    {
+        return [histograms[name] copy];
+    }
+}
+
+- (void)reset
+{
+    @synchronized(self)
+    {
+        [counters removeAllObjects];
+        [histograms removeAllObjects];
+    }
+}
+
+@end
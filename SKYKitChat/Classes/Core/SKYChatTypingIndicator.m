@@ -18,6 +18,7 @@
 //
 
 #import "SKYChatTypingIndicator.h"
+#import "SKYChatTypingIndicator_Private.h"
 #import <SKYKit/SKYKit.h>
 
 NSString *SKYChatTypingEventToString(SKYChatTypingEvent event)
@@ -43,10 +44,29 @@ SKYChatTypingEvent SKYChatTypingEventFromString(NSString *eventString)
     }
 }
 
-@implementation SKYChatTypingIndicator {
-    NSDictionary *userTypingInfos;
+static NSTimeInterval const SKYChatTypingIndicatorDefaultExpiryInterval = 5.0;
+
+@implementation SKYChatParticipantTypingInfo
+
+- (instancetype)initWithEvent:(SKYChatTypingEvent)event date:(NSDate *)date
+{
+    if ((self = [super init])) {
+        _event = event;
+        _date = date;
+    }
+    return self;
 }
 
+- (BOOL)isTypingAtDate:(NSDate *)date expiryInterval:(NSTimeInterval)expiryInterval
+{
+    return _event == SKYChatTypingEventBegin && _date &&
+           [date timeIntervalSinceDate:_date] < expiryInterval;
+}
+
+@end
+
+@implementation SKYChatTypingIndicator
+
 + (BOOL)isTypingIndicatorEventType:(NSString *)typingIndicator
 {
     return [typingIndicator isEqualToString:@"typing"];
@@ -68,53 +88,71 @@ SKYChatTypingEvent SKYChatTypingEventFromString(NSString *eventString)
  */
 - (instancetype)initWithDictionary:(NSDictionary<NSString *, id> *)dict
                     conversationID:(NSString *)conversationID
+{
+    // Decode the payload once, so that the event dates are not parsed
+    // again every time the typing participants are checked.
+    NSMutableDictionary<NSString *, SKYChatParticipantTypingInfo *> *participantInfos =
+        [NSMutableDictionary dictionaryWithCapacity:dict.count];
+    [dict enumerateKeysAndObjectsUsingBlock:^(NSString *participantID, NSDictionary *userInfo,
+                                              BOOL *stop) {
+        if (![userInfo isKindOfClass:[NSDictionary class]]) {
+            return;
+        }
+
+        NSString *eventDate = userInfo[@"at"];
+        NSDate *date = nil;
+        if ([eventDate isKindOfClass:[NSString class]]) {
+            date = [SKYDataSerialization dateFromString:eventDate];
+        }
+
+        participantInfos[participantID] = [[SKYChatParticipantTypingInfo alloc]
+            initWithEvent:SKYChatTypingEventFromString(userInfo[@"event"])
+                     date:date];
+    }];
+
+    return [self initWithParticipantInfos:participantInfos conversationID:conversationID];
+}
+
+- (instancetype)initWithParticipantInfos:
+                    (NSDictionary<NSString *, SKYChatParticipantTypingInfo *> *)participantInfos
+                          conversationID:(NSString *)conversationID
 {
     if ((self = [super init])) {
         _conversationID = [conversationID copy];
-        userTypingInfos = [dict copy];
+        _participantInfos = [participantInfos copy];
+        _expiryInterval = SKYChatTypingIndicatorDefaultExpiryInterval;
     }
     return self;
 }
 
 - (NSArray *)participantIDs
 {
-    return [userTypingInfos allKeys];
+    return [_participantInfos allKeys];
 }
 
 - (NSArray *)typingParticipantIDs
 {
+    NSDate *now = [NSDate date];
     NSMutableArray *typingParticipantIDs = [NSMutableArray array];
-    [self.participantIDs
-        enumerateObjectsUsingBlock:^(NSString *eachID, NSUInteger idx, BOOL *stop) {
-            SKYChatTypingEvent event = [self lastEventWithParticipantID:eachID];
-            NSDate *date = [self lastEventDateWithParticipantID:eachID];
-
-            if (event == SKYChatTypingEventBegin && [date timeIntervalSinceNow] > -5.0) {
-                // Last event is typing and the event is less than 5 seconds ago.
-                [typingParticipantIDs addObject:eachID];
-            }
-        }];
+    [_participantInfos enumerateKeysAndObjectsUsingBlock:^(
+                           NSString *eachID, SKYChatParticipantTypingInfo *info, BOOL *stop) {
+        // Last event is typing and the event has not expired.
+        if ([info isTypingAtDate:now expiryInterval:self.expiryInterval]) {
+            [typingParticipantIDs addObject:eachID];
+        }
+    }];
     return typingParticipantIDs;
 }
 
-- (NSDictionary *)userInfoWithParticipantID:(NSString *)participantID
-{
-    return [userTypingInfos objectForKey:participantID];
-}
-
 - (SKYChatTypingEvent)lastEventWithParticipantID:(NSString *)participantID
 {
-    NSString *eventType = [[self userInfoWithParticipantID:participantID] objectForKey:@"event"];
-    return SKYChatTypingEventFromString(eventType);
+    SKYChatParticipantTypingInfo *info = _participantInfos[participantID];
+    return info ? info.event : SKYChatTypingEventFinished;
 }
 
 - (NSDate *)lastEventDateWithParticipantID:(NSString *)participantID
 {
-    NSString *eventDate = [[self userInfoWithParticipantID:participantID] objectForKey:@"at"];
-    if (![eventDate isKindOfClass:[NSString class]]) {
-        return nil;
-    }
-    return [SKYDataSerialization dateFromString:eventDate];
+    return _participantInfos[participantID].date;
 }
 
 - (SKYChatTypingIndicator *)typingIndicatorWithUpdatesFromTypingIndicator:
@@ -122,9 +160,13 @@ SKYChatTypingEvent SKYChatTypingEventFromString(NSString *eventString)
 {
     NSString *conversationID =
         [indicator.conversationID isEqualToString:_conversationID] ? indicator.conversationID : nil;
-    NSMutableDictionary *infos = [userTypingInfos mutableCopy];
-    [infos addEntriesFromDictionary:indicator->userTypingInfos];
-    return [[SKYChatTypingIndicator alloc] initWithDictionary:infos conversationID:conversationID];
+    NSMutableDictionary *infos = [_participantInfos mutableCopy];
+    [infos addEntriesFromDictionary:indicator.participantInfos];
+    SKYChatTypingIndicator *merged =
+        [[SKYChatTypingIndicator alloc] initWithParticipantInfos:infos
+                                                  conversationID:conversationID];
+    merged.expiryInterval = _expiryInterval;
+    return merged;
 }
 
 @end
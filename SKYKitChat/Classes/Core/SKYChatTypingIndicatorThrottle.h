@@ -0,0 +1,67 @@
+//
+//  SKYChatTypingIndicatorThrottle.h
+//  SKYKitChat
+//
+//  Copyright 2016 Oursky Ltd.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "SKYChatTypingIndicator.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+typedef void (^SKYChatTypingIndicatorSendHandler)(SKYChatTypingEvent event,
+                                                  NSString *conversationID, NSDate *date);
+
+/**
+ SKYChatTypingIndicatorThrottle reduces the typing events sent to the server.
+
+ For each conversation, a begin event is sent at most once per begin interval, a pause event is
+ sent automatically when no begin event is received within the pause interval, and events that
+ do not change the typing state of the conversation are suppressed.
+
+ App developer should not use this class directly.
+ */
+@interface SKYChatTypingIndicatorThrottle : NSObject
+
+/**
+ Minimum interval between two begin events sent to the same conversation.
+
+ The interval should be shorter than the period a typing event is shown to other participants.
+ */
+@property (assign, nonatomic) NSTimeInterval beginInterval;
+
+/**
+ Period of inactivity after which a pause event is sent automatically.
+ */
+@property (assign, nonatomic) NSTimeInterval pauseInterval;
+
+- (instancetype)initWithSendHandler:(SKYChatTypingIndicatorSendHandler)sendHandler;
+
+/**
+ Handles a typing event of the current user, the event is passed to the send handler
+ only if it needs to be sent.
+ */
+- (void)handleTypingEvent:(SKYChatTypingEvent)event conversationID:(NSString *)conversationID;
+
+/**
+ Discards the typing state of all conversations without sending any events.
+ */
+- (void)reset;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,164 @@
+//
+//  SKYChatTypingIndicatorThrottle.m
+//  SKYKitChat
+//
+//  Copyright 2016 Oursky Ltd.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "SKYChatTypingIndicatorThrottle.h"
+
+@interface SKYChatTypingState : NSObject
+
+@property (assign, nonatomic) BOOL hasSentEvent;
+@property (assign, nonatomic) SKYChatTypingEvent lastSentEvent;
+@property (strong, nonatomic, nullable) NSDate *lastBeginDate;
+@property (strong, nonatomic, nullable) NSDate *lastActivityDate;
+@property (assign, nonatomic) BOOL isPauseScheduled;
+
+@end
+
+@implementation SKYChatTypingState
+@end
+
+@implementation SKYChatTypingIndicatorThrottle {
+    SKYChatTypingIndicatorSendHandler _sendHandler;
+    NSMutableDictionary<NSString *, SKYChatTypingState *> *_states;
+}
+
+- (instancetype)initWithSendHandler:(SKYChatTypingIndicatorSendHandler)sendHandler
+{
+    if ((self = [super init])) {
+        _sendHandler = [sendHandler copy];
+        _states = [NSMutableDictionary dictionary];
+        _beginInterval = 3;
+        _pauseInterval = 3;
+    }
+    return self;
+}
+
+- (void)handleTypingEvent:(SKYChatTypingEvent)event conversationID:(NSString *)conversationID
+{
+    NSDate *now = [NSDate date];
+    BOOL shouldSend = NO;
+    SKYChatTypingState *pauseState = nil;
+
+    @synchronized(self)
+    {
+        SKYChatTypingState *state = _states[conversationID];
+        if (!state) {
+            state = [[SKYChatTypingState alloc] init];
+            _states[conversationID] = state;
+        }
+
+        switch (event) {
+            case SKYChatTypingEventBegin:
+                state.lastActivityDate = now;
+                if (!state.isPauseScheduled) {
+                    pauseState = state;
+                }
+                state.isPauseScheduled = YES;
+                shouldSend = !state.hasSentEvent ||
+                             state.lastSentEvent != SKYChatTypingEventBegin ||
+                             [now timeIntervalSinceDate:state.lastBeginDate] >= self.beginInterval;
+                if (shouldSend) {
+                    state.lastBeginDate = now;
+                }
+                break;
+            case SKYChatTypingEventPause:
+                shouldSend = state.hasSentEvent && state.lastSentEvent == SKYChatTypingEventBegin;
+                break;
+            case SKYChatTypingEventFinished:
+                shouldSend = state.hasSentEvent && state.lastSentEvent != SKYChatTypingEventFinished;
+                break;
+        }
+
+        if (shouldSend) {
+            state.hasSentEvent = YES;
+            state.lastSentEvent = event;
+        }
+
+        if (event == SKYChatTypingEventFinished) {
+            [_states removeObjectForKey:conversationID];
+        }
+    }
+
+    if (shouldSend) {
+        _sendHandler(event, conversationID, now);
+    }
+
+    if (pauseState) {
+        [self schedulePauseWithConversationID:conversationID
+                                        state:pauseState
+                                        after:self.pauseInterval];
+    }
+}
+
+- (void)schedulePauseWithConversationID:(NSString *)conversationID
+                                  state:(SKYChatTypingState *)state
+                                  after:(NSTimeInterval)delay
+{
+    __weak typeof(self) weakSelf = self;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC)),
+                   dispatch_get_main_queue(), ^{
+                       [weakSelf sendPauseIfInactiveWithConversationID:conversationID state:state];
+                   });
+}
+
+- (void)sendPauseIfInactiveWithConversationID:(NSString *)conversationID
+                                        state:(SKYChatTypingState *)scheduledState
+{
+    NSDate *now = [NSDate date];
+    BOOL shouldSend = NO;
+    NSTimeInterval remaining = 0;
+
+    @synchronized(self)
+    {
+        SKYChatTypingState *state = _states[conversationID];
+        if (state != scheduledState || !state.isPauseScheduled) {
+            // The state is finished or reset, a new begin event after that
+            // schedules its own check for the new state.
+            return;
+        }
+
+        // Only one check is scheduled for each conversation, check again
+        // later if there is activity after this check was scheduled.
+        remaining = self.pauseInterval - [now timeIntervalSinceDate:state.lastActivityDate];
+        if (remaining > 0) {
+            shouldSend = NO;
+        } else {
+            state.isPauseScheduled = NO;
+            shouldSend = state.hasSentEvent && state.lastSentEvent == SKYChatTypingEventBegin;
+            if (shouldSend) {
+                state.lastSentEvent = SKYChatTypingEventPause;
+            }
+        }
+    }
+
+    if (remaining > 0) {
+        [self schedulePauseWithConversationID:conversationID state:scheduledState after:remaining];
+    } else if (shouldSend) {
+        _sendHandler(SKYChatTypingEventPause, conversationID, now);
+    }
+}
+
+- (void)reset
+{
+    @synchronized(self)
+    {
+        [_states removeAllObjects];
+    }
+}
+
+@end
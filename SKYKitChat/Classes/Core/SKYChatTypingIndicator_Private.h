@@ -21,8 +21,44 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+/**
+ SKYChatParticipantTypingInfo contains the last typing event of a participant, decoded from
+ the typing indicator payload.
+ */
+@interface SKYChatParticipantTypingInfo : NSObject
+
+@property (nonatomic, readonly) SKYChatTypingEvent event;
+@property (nonatomic, readonly, nullable) NSDate *date;
+
+- (instancetype)initWithEvent:(SKYChatTypingEvent)event date:(NSDate *_Nullable)date;
+
+/**
+ Returns whether the participant is typing at the specified date.
+ */
+- (BOOL)isTypingAtDate:(NSDate *)date expiryInterval:(NSTimeInterval)expiryInterval;
+
+@end
+
 @interface SKYChatTypingIndicator ()
 
+/**
+ Typing info of each participant, keyed by participant ID.
+ */
+@property (nonatomic, readonly)
+    NSDictionary<NSString *, SKYChatParticipantTypingInfo *> *participantInfos;
+
+/**
+ The period after a typing begin event in which the participant is regarded as typing by
+ `typingParticipantIDs`.
+
+ The default is 5 seconds.
+ */
+@property (nonatomic, assign) NSTimeInterval expiryInterval;
+
+- (instancetype)initWithParticipantInfos:
+                    (NSDictionary<NSString *, SKYChatParticipantTypingInfo *> *)participantInfos
+                          conversationID:(NSString *_Nullable)conversationID;
+
 /**
  Returns whether the specified string is the name of the event type for typing indicator.
 
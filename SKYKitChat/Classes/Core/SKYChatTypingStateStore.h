@@ -0,0 +1,60 @@
+//
+//  SKYChatTypingStateStore.h
+//  SKYKitChat
+//
+//  Copyright 2016 Oursky Ltd.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "SKYChatTypingIndicator.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+typedef void (^SKYChatTypingStateChangeHandler)(NSString *conversationID,
+                                                NSArray<NSString *> *typingParticipantIDs);
+
+/**
+ SKYChatTypingStateStore keeps the latest typing event of each participant in each
+ conversation.
+
+ Typing indicators received are merged into the store in place. A single timer is scheduled at
+ the moment the typing event of the next participant expires, so that the change handler is
+ called when a participant stops typing even if no more typing indicators are received.
+
+ App developer should not use this class directly.
+ */
+@interface SKYChatTypingStateStore : NSObject
+
+/**
+ Period after a begin event in which the participant is regarded as typing.
+ */
+@property (assign, nonatomic) NSTimeInterval expiryInterval;
+
+/**
+ Instantiates a store. The change handler is called on the main queue when the typing
+ participants of a conversation changes.
+ */
+- (instancetype)initWithChangeHandler:(SKYChatTypingStateChangeHandler)changeHandler;
+
+- (void)mergeTypingIndicator:(SKYChatTypingIndicator *)indicator;
+
+- (NSArray<NSString *> *)typingParticipantIDsWithConversationID:(NSString *)conversationID;
+
+- (void)reset;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,228 @@
+//
+//  SKYChatTypingStateStore.m
+//  SKYKitChat
+//
+//  Copyright 2016 Oursky Ltd.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "SKYChatTypingStateStore.h"
+#import "SKYChatTypingIndicator_Private.h"
+
+@implementation SKYChatTypingStateStore {
+    SKYChatTypingStateChangeHandler _changeHandler;
+    NSMutableDictionary<NSString *,
+                        NSMutableDictionary<NSString *, SKYChatParticipantTypingInfo *> *>
+        *_conversationStates;
+    dispatch_source_t _expiryTimer;
+}
+
+- (instancetype)initWithChangeHandler:(SKYChatTypingStateChangeHandler)changeHandler
+{
+    if ((self = [super init])) {
+        _changeHandler = [changeHandler copy];
+        _conversationStates = [NSMutableDictionary dictionary];
+        _expiryInterval = 5.0;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    if (_expiryTimer) {
+        dispatch_source_cancel(_expiryTimer);
+    }
+}
+
+- (void)mergeTypingIndicator:(SKYChatTypingIndicator *)indicator
+{
+    NSString *conversationID = indicator.conversationID;
+    if (!conversationID) {
+        return;
+    }
+
+    NSArray<NSString *> *typingParticipantIDs;
+    @synchronized(self)
+    {
+        NSMutableDictionary<NSString *, SKYChatParticipantTypingInfo *> *state =
+            _conversationStates[conversationID];
+        if (!state) {
+            state = [NSMutableDictionary dictionary];
+            _conversationStates[conversationID] = state;
+        }
+
+        [indicator.participantInfos
+            enumerateKeysAndObjectsUsingBlock:^(NSString *participantID,
+                                                SKYChatParticipantTypingInfo *info, BOOL *stop) {
+                SKYChatParticipantTypingInfo *existingInfo = state[participantID];
+                if (existingInfo.date && info.date &&
+                    [existingInfo.date compare:info.date] == NSOrderedDescending) {
+                    // ignore event arriving out of order
+                    return;
+                }
+                state[participantID] = info;
+            }];
+
+        typingParticipantIDs = [self typingParticipantIDsInState:state atDate:[NSDate date]];
+        [self scheduleExpiryTimer];
+    }
+
+    [self notifyChangeWithConversationID:conversationID typingParticipantIDs:typingParticipantIDs];
+}
+
+- (NSArray<NSString *> *)typingParticipantIDsWithConversationID:(NSString *)conversationID
+{
+    @synchronized(self)
+    {
+        return [self typingParticipantIDsInState:_conversationStates[conversationID]
+                                          atDate:[NSDate date]];
+    }
+}
+
+- (void)reset
+{
+    @synchronized(self)
+    {
+        [_conversationStates removeAllObjects];
+        [self scheduleExpiryTimer];
+    }
+}
+
+#pragma mark - Private
+
+- (NSArray<NSString *> *)typingParticipantIDsInState:
+                             (NSDictionary<NSString *, SKYChatParticipantTypingInfo *> *)state
+                                              atDate:(NSDate *)date
+{
+    NSMutableArray<NSString *> *participantIDs = [NSMutableArray array];
+    [state enumerateKeysAndObjectsUsingBlock:^(NSString *participantID,
+                                               SKYChatParticipantTypingInfo *info, BOOL *stop) {
+        if ([info isTypingAtDate:date expiryInterval:self.expiryInterval]) {
+            [participantIDs addObject:participantID];
+        }
+    }];
+    return participantIDs;
+}
+
+- (void)notifyChangeWithConversationID:(NSString *)conversationID
+                  typingParticipantIDs:(NSArray<NSString *> *)typingParticipantIDs
+{
+    if ([NSThread isMainThread]) {
+        _changeHandler(conversationID, typingParticipantIDs);
+    } else {
+        dispatch_async(dispatch_get_main_queue(), ^{
+            self->_changeHandler(conversationID, typingParticipantIDs);
+        });
+    }
+}
+
+/**
+ Schedules the timer to fire when the earliest typing event expires. Must be called
+ while synchronized.
+ */
+- (void)scheduleExpiryTimer
+{
+    __block NSDate *nextExpiryDate = nil;
+    NSDate *now = [NSDate date];
+    [_conversationStates enumerateKeysAndObjectsUsingBlock:^(
+                             NSString *conversationID,
+                             NSDictionary<NSString *, SKYChatParticipantTypingInfo *> *state,
+                             BOOL *stop) {
+        for (SKYChatParticipantTypingInfo *info in state.allValues) {
+            if (![info isTypingAtDate:now expiryInterval:self.expiryInterval]) {
+                continue;
+            }
+
+            NSDate *expiryDate = [info.date dateByAddingTimeInterval:self.expiryInterval];
+            if (!nextExpiryDate || [expiryDate compare:nextExpiryDate] == NSOrderedAscending) {
+                nextExpiryDate = expiryDate;
+            }
+        }
+    }];
+
+    if (!nextExpiryDate) {
+        if (_expiryTimer) {
+            dispatch_source_cancel(_expiryTimer);
+            _expiryTimer = nil;
+        }
+        return;
+    }
+
+    if (!_expiryTimer) {
+        __weak typeof(self) weakSelf = self;
+        _expiryTimer =
+            dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, dispatch_get_main_queue());
+        dispatch_source_set_event_handler(_expiryTimer, ^{
+            [weakSelf handleExpiryTimer];
+        });
+        dispatch_resume(_expiryTimer);
+    }
+
+    NSTimeInterval delay = MAX([nextExpiryDate timeIntervalSinceDate:now], 0);
+    dispatch_source_set_timer(_expiryTimer,
+                              dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC)),
+                              DISPATCH_TIME_FOREVER, (uint64_t)(0.05 * NSEC_PER_SEC));
+}
+
+- (void)handleExpiryTimer
+{
+    NSMutableDictionary<NSString *, NSArray<NSString *> *> *changes =
+        [NSMutableDictionary dictionary];
+
+    @synchronized(self)
+    {
+        NSDate *now = [NSDate date];
+        for (NSString *conversationID in _conversationStates.allKeys) {
+            NSMutableDictionary<NSString *, SKYChatParticipantTypingInfo *> *state =
+                _conversationStates[conversationID];
+
+            // remove the expired begin events, other events are removed
+            // as well because they no longer affect the typing state
+            NSArray<NSString *> *expiredIDs = [state
+                keysOfEntriesPassingTest:^BOOL(NSString *participantID,
+                                               SKYChatParticipantTypingInfo *info, BOOL *stop) {
+                    return ![info isTypingAtDate:now expiryInterval:self.expiryInterval];
+                }]
+                                                  .allObjects;
+            if (expiredIDs.count == 0) {
+                continue;
+            }
+
+            BOOL hadTypingParticipant = NO;
+            for (NSString *participantID in expiredIDs) {
+                hadTypingParticipant =
+                    hadTypingParticipant || state[participantID].event == SKYChatTypingEventBegin;
+            }
+            [state removeObjectsForKeys:expiredIDs];
+
+            if (hadTypingParticipant) {
+                changes[conversationID] = [self typingParticipantIDsInState:state atDate:now];
+            }
+            if (state.count == 0) {
+                [_conversationStates removeObjectForKey:conversationID];
+            }
+        }
+
+        [self scheduleExpiryTimer];
+    }
+
+    [changes enumerateKeysAndObjectsUsingBlock:^(NSString *conversationID,
+                                                 NSArray<NSString *> *typingParticipantIDs,
+                                                 BOOL *stop) {
+        [self notifyChangeWithConversationID:conversationID
+                        typingParticipantIDs:typingParticipantIDs];
+    }];
+}
+
+@end
@@ -0,0 +1,88 @@
+//
+//  SKYChatUnreadCountTracker.h
+//  SKYKitChat
+//
+//  Copyright 2016 Oursky Ltd.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+typedef void (^SKYChatUnreadCountChangeHandler)(
+    NSDictionary<NSString *, NSNumber *> *totalUnreadCount, NSString *_Nullable conversationID);
+
+/**
+ SKYChatUnreadCountTracker maintains the unread counts of conversations and the total unread
+ count locally.
+
+ The counts are seeded with the counts from server, then updated with new messages received and
+ messages marked as read, so that the server is only consulted to reconcile the counts.
+
+ App developer should not use this class directly.
+ */
+@interface SKYChatUnreadCountTracker : NSObject
+
+/**
+ Whether the total unread count is known, i.e. it has been updated from server.
+ */
+@property (nonatomic, readonly) BOOL hasTotalUnreadCount;
+
+/**
+ Instantiates a tracker. The change handler is called on the calling thread of the method
+ that changes the counts.
+ */
+- (instancetype)initWithChangeHandler:(SKYChatUnreadCountChangeHandler)changeHandler;
+
+/**
+ Returns the total unread count, with the keys SKYChatMessageUnreadCountKey and
+ SKYChatConversationUnreadCountKey.
+ */
+- (NSDictionary<NSString *, NSNumber *> *)totalUnreadCount;
+
+/**
+ Returns the unread count of a conversation, or -1 if it is not known.
+ */
+- (NSInteger)unreadCountWithConversationID:(NSString *)conversationID;
+
+/**
+ Replaces the total unread count with the count from server. The unread counts of
+ conversations are forgotten until they are updated from server again.
+ */
+- (void)updateWithTotalUnreadCount:(NSDictionary<NSString *, NSNumber *> *)totalUnreadCount;
+
+/**
+ Replaces the unread count of a conversation with the count from server.
+ */
+- (void)updateWithUnreadCount:(NSInteger)unreadCount conversationID:(NSString *)conversationID;
+
+/**
+ Counts a new message received in a conversation.
+ */
+- (void)didReceiveMessageWithID:(NSString *)messageID conversationID:(NSString *)conversationID;
+
+/**
+ Clears the unread count of a conversation after the conversation is read.
+
+ Returns NO if the unread count of the conversation is not known, in which case the
+ total unread count may be inaccurate until it is updated from server.
+ */
+- (BOOL)didReadConversationWithID:(NSString *)conversationID;
+
+- (void)reset;
+
+@end
+
+NS_ASSUME_NONNULL_END
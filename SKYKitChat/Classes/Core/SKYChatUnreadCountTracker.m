@@ -0,0 +1,180 @@
+//
+//  SKYChatUnreadCountTracker.m
+//  SKYKitChat
+//
+//  Copyright 2016 Oursky Ltd.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#import "SKYChatUnreadCountTracker.h"
+
+#import "SKYChatExtension.h"
+
+// Number of received message IDs remembered to ignore duplicated events.
+static NSUInteger SKYChatUnreadCountTrackerMaxMessageIDs = 200;
+
+@implementation SKYChatUnreadCountTracker {
+    SKYChatUnreadCountChangeHandler _changeHandler;
+    NSMutableDictionary<NSString *, NSNumber *> *_conversationUnreadCounts;
+    NSMutableOrderedSet<NSString *> *_receivedMessageIDs;
+    NSInteger _messageUnreadCount;
+    NSInteger _conversationUnreadCount;
+}
+
+- (instancetype)initWithChangeHandler:(SKYChatUnreadCountChangeHandler)changeHandler
+{
+    if ((self = [super init])) {
+        _changeHandler = [changeHandler copy];
+        _conversationUnreadCounts = [NSMutableDictionary dictionary];
+        _receivedMessageIDs = [NSMutableOrderedSet orderedSet];
+    }
+    return self;
+}
+
+- (NSDictionary<NSString *, NSNumber *> *)totalUnreadCount
+{
+    @synchronized(self)
+    {
+        return @{
+            SKYChatMessageUnreadCountKey : @(MAX(_messageUnreadCount, 0)),
+            SKYChatConversationUnreadCountKey : @(MAX(_conversationUnreadCount, 0)),
+        };
+    }
+}
+
+- (NSInteger)unreadCountWithConversationID:(NSString *)conversationID
+{
+    @synchronized(self)
+    {
+        NSNumber *count = _conversationUnreadCounts[conversationID];
+        return count ? count.integerValue : -1;
+    }
+}
+
+- (void)updateWithTotalUnreadCount:(NSDictionary<NSString *, NSNumber *> *)totalUnreadCount
+{
+    @synchronized(self)
+    {
+        _messageUnreadCount = [totalUnreadCount[SKYChatMessageUnreadCountKey] integerValue];
+        _conversationUnreadCount =
+            [totalUnreadCount[SKYChatConversationUnreadCountKey] integerValue];
+        _hasTotalUnreadCount = YES;
+
+        // The counts of conversations may be out of date with the new total, so they are
+        // forgotten until they are updated from server again. Otherwise later changes
+        // would be applied to the total against the stale counts.
+        [_conversationUnreadCounts removeAllObjects];
+    }
+
+    [self notifyChangeWithConversationID:nil];
+}
+
+- (void)updateWithUnreadCount:(NSInteger)unreadCount conversationID:(NSString *)conversationID
+{
+    @synchronized(self)
+    {
+        NSNumber *previousCount = _conversationUnreadCounts[conversationID];
+        if (previousCount && previousCount.integerValue == unreadCount) {
+            return;
+        }
+
+        // When the previous count is not known, the total from server is
+        // assumed to include the count already.
+        if (previousCount) {
+            [self adjustTotalWithPreviousCount:previousCount.integerValue newCount:unreadCount];
+        }
+        _conversationUnreadCounts[conversationID] = @(unreadCount);
+    }
+
+    [self notifyChangeWithConversationID:conversationID];
+}
+
+- (void)didReceiveMessageWithID:(NSString *)messageID conversationID:(NSString *)conversationID
+{
+    @synchronized(self)
+    {
+        if ([_receivedMessageIDs containsObject:messageID]) {
+            return;
+        }
+        [_receivedMessageIDs addObject:messageID];
+        if (_receivedMessageIDs.count > SKYChatUnreadCountTrackerMaxMessageIDs) {
+            [_receivedMessageIDs removeObjectAtIndex:0];
+        }
+
+        NSNumber *previousCount = _conversationUnreadCounts[conversationID];
+        if (previousCount) {
+            NSInteger count = previousCount.integerValue + 1;
+            [self adjustTotalWithPreviousCount:previousCount.integerValue newCount:count];
+            _conversationUnreadCounts[conversationID] = @(count);
+        } else {
+            // The conversation may or may not have unread messages already,
+            // so only the message count is certain.
+            _messageUnreadCount += 1;
+        }
+    }
+
+    [self notifyChangeWithConversationID:conversationID];
+}
+
+- (BOOL)didReadConversationWithID:(NSString *)conversationID
+{
+    BOOL isKnown;
+    @synchronized(self)
+    {
+        NSNumber *previousCount = _conversationUnreadCounts[conversationID];
+        isKnown = previousCount != nil;
+        if (isKnown) {
+            [self adjustTotalWithPreviousCount:previousCount.integerValue newCount:0];
+        }
+        _conversationUnreadCounts[conversationID] = @0;
+    }
+
+    [self notifyChangeWithConversationID:conversationID];
+    return isKnown;
+}
+
+- (void)reset
+{
+    @synchronized(self)
+    {
+        [_conversationUnreadCounts removeAllObjects];
+        [_receivedMessageIDs removeAllObjects];
+        _messageUnreadCount = 0;
+        _conversationUnreadCount = 0;
+        _hasTotalUnreadCount = NO;
+    }
+}
+
+#pragma mark - Private
+
+/**
+ Adjusts the total for a change of conversation unread count. Must be called while
+ synchronized.
+ */
+- (void)adjustTotalWithPreviousCount:(NSInteger)previousCount newCount:(NSInteger)newCount
+{
+    _messageUnreadCount += newCount - previousCount;
+    if (previousCount == 0 && newCount > 0) {
+        _conversationUnreadCount += 1;
+    } else if (previousCount > 0 && newCount == 0) {
+        _conversationUnreadCount -= 1;
+    }
+}
+
+- (void)notifyChangeWithConversationID:(NSString *)conversationID
+{
+    _changeHandler([self totalUnreadCount], conversationID);
+}
+
+@end
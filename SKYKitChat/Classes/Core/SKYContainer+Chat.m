@@ -29,9 +29,7 @@
 {
     SKYChatExtension *extension = objc_getAssociatedObject(self, @selector(chatExtension));
     if (!extension) {
-        extension =
-            [[SKYChatExtension alloc] initWithContainer:self
-                                        cacheController:[SKYChatCacheController defaultController]];
+        extension = [[SKYChatExtension alloc] initWithContainer:self];
         objc_setAssociatedObject(self, @selector(chatExtension), extension,
                                  OBJC_ASSOCIATION_RETAIN_NONATOMIC);
     }
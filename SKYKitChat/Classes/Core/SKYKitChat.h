@@ -17,7 +17,14 @@
 //  limitations under the License.
 //
 
+#import "SKYChatCacheController.h"
+#import "SKYChatCacheEncryptionKeyProvider.h"
+#import "SKYChatCacheLiveQuery.h"
 #import "SKYChatExtension.h"
+#import "SKYChatLatencyHistogram.h"
+#import "SKYChatLogger.h"
+#import "SKYChatMessagesReconciliation.h"
+#import "SKYChatMetrics.h"
 #import "SKYChatReceipt.h"
 #import "SKYChatRecord.h"
 #import "SKYChatRecordChange.h"
@@ -46,10 +46,40 @@ open class SKYChatConversationListViewController: UIViewController {
 
     @IBOutlet public var tableView: UITableView!
 
+    /*
+      Number of conversations fetched per page. Further pages are fetched
+      when the user scrolls near the end of the list.
+     */
+    public var conversationsPageSize: Int = 20
+
+    /*
+      Number of the most recently active conversations to prefetch messages
+      for after the conversation list is loaded, so that opening them is
+      served from cache. Prefetching is disabled when it is 0.
+     */
+    public var prefetchConversationCount: Int = 0
+
+    /*
+      Number of messages to prefetch for each conversation.
+     */
+    public var prefetchMessagesLimit: Int = 50
+
+    /*
+      Approximate number of bytes of messages to prefetch each time.
+     */
+    public var prefetchByteBudget: UInt = 2 * 1024 * 1024
+
     var refreshControl: UIRefreshControl!
     var conversations: [SKYConversation] = []
     var participantMap: [String: SKYParticipant] = [:]
+    let rowViewModelCache = SKYChatConversationRowViewModelCache()
+    var requestedParticipantIDs: Set<String> = []
+    var pendingParticipantIDs: Set<String> = []
     var conversationChangeObserver: Any?
+    var isPrefetchingConversations: Bool = false
+    var nextPage: Int = 2
+    var hasMoreConversations: Bool = true
+    var isFetchingNextPage: Bool = false
 }
 
 // MARK: - Initializing
@@ -82,6 +112,7 @@ extension SKYChatConversationListViewController {
         self.refreshControl.attributedTitle = NSAttributedString(string: "Pull to refresh")
         self.refreshControl?.addTarget(self, action: #selector(handleRefresh), for: UIControlEvents.valueChanged)
         self.tableView.addSubview(refreshControl)
+        self.loadCachedConversations()
         self.refreshControl.beginRefreshing()
         self.handleRefresh(refreshControl: self.refreshControl)
     }
@@ -120,6 +151,10 @@ extension SKYChatConversationListViewController {
         }
     }
 
+    /*
+      Pull to refresh only fetches the first page of conversations, pages
+      loaded afterwards are kept.
+     */
     @objc public func handleRefresh(refreshControl: UIRefreshControl) {
         self.performQuery(callback: {
             refreshControl.endRefreshing()
@@ -140,22 +175,17 @@ extension SKYChatConversationListViewController: UITableViewDelegate, UITableVie
         if let cell = tableView.dequeueReusableCell(withIdentifier: "ConversationCell")
             as? SKYChatConversationTableViewCell {
 
+            let viewModel = self.rowViewModelCache.viewModel(for: conversation) { conversation in
+                return SKYChatConversationRowViewModel(
+                    conversation: conversation,
+                    participants: self.displayedParticipants(ofConversation: conversation))
+            }
+
             cell.conversation = conversation
+            cell.viewModel = viewModel
             cell.conversationMessage = conversation.lastMessage?.body
             cell.unreadMessageCount = conversation.unreadCount
-            cell.participants = []
-
-            // add all participant records for display
-            conversation.participantIds.forEach({ (eachParticipantID) in
-                guard eachParticipantID != self.skygear.auth.currentUserRecordID! else {
-                    // no need to show current user's name
-                    return
-                }
-
-                if let eachParticipant = self.participantMap[eachParticipantID] {
-                    cell.participants.append(eachParticipant)
-                }
-            })
+            cell.participants = viewModel.participants
 
             if let ds = self.dataSource {
                 cell.avatarImage = ds.listViewController?(self,
@@ -185,6 +215,21 @@ extension SKYChatConversationListViewController: UITableViewDelegate, UITableVie
         return CGFloat(75)
     }
 
+    open func tableView(_ tableView: UITableView,
+                        willDisplay cell: UITableViewCell,
+                        forRowAt indexPath: IndexPath) {
+        guard indexPath.row < self.conversations.count else {
+            return
+        }
+
+        self.enqueueParticipantQuery(forConversation: self.conversations[indexPath.row])
+
+        // start fetching the next page when the last few rows are displayed
+        if indexPath.row >= self.conversations.count - max(self.conversationsPageSize / 4, 1) {
+            self.performNextPageQuery()
+        }
+    }
+
     public func tableView(_ tableView: UITableView, didSelectRowAt indexPath: IndexPath) {
         if let d = self.delegate {
             let conv = self.conversations[indexPath.row]
@@ -203,23 +248,75 @@ extension SKYChatConversationListViewController {
         return self.conversations
     }
 
+    /*
+      Show the conversations cached locally before the first page is
+      fetched from server.
+     */
+    open func loadCachedConversations() {
+        self.skygear.chatExtension?.fetchCachedConversations(
+            page: 1,
+            pageSize: self.conversationsPageSize,
+            completion: { (conversations, _) in
+                if let conversations = conversations, conversations.count > 0 {
+                    self.conversations = conversations
+                    self.tableView.reloadData()
+                }
+        })
+    }
+
+    /*
+      Fetch the first page of conversations.
+     */
     open func performQuery(callback: (() -> Void)?) {
-        self.skygear.chatExtension?.fetchConversations(fetchLastMessage: true, completion: {
-            (conversations, error) in
-            callback?()
-            if let err = error {
-                self.handleQueryError(error: err)
-                return
-            }
+        self.performQuery(page: 1, callback: callback)
+    }
 
-            if let conversations = conversations {
-                self.handleQueryResult(result: conversations)
-            } else {
-                let err = SKYErrorCreator()
-                    .error(with: SKYErrorBadResponse,
-                           message: "Query does not response Conversation")
-                self.handleQueryError(error: err)
-            }
+    /*
+      Fetch the next page of conversations, if there are more conversations
+      to be loaded and no page is being fetched.
+     */
+    open func performNextPageQuery() {
+        guard self.hasMoreConversations, !self.isFetchingNextPage else {
+            return
+        }
+
+        self.isFetchingNextPage = true
+        self.performQuery(page: self.nextPage, callback: { [weak self] in
+            self?.isFetchingNextPage = false
+        })
+    }
+
+    func performQuery(page: Int, callback: (() -> Void)?) {
+        let pageSize = self.conversationsPageSize
+        self.skygear.chatExtension?.fetchConversations(
+            page: page,
+            pageSize: pageSize,
+            fetchLastMessage: true,
+            completion: { (conversations, error) in
+                callback?()
+                if let err = error {
+                    self.handleQueryError(error: err)
+                    return
+                }
+
+                if let conversations = conversations {
+                    if page > 1 {
+                        self.nextPage = page + 1
+                        self.hasMoreConversations = conversations.count >= pageSize
+                    } else if conversations.count < pageSize {
+                        // all conversations fit in the first page
+                        self.nextPage = 2
+                        self.hasMoreConversations = false
+                    } else if self.nextPage == 2 {
+                        self.hasMoreConversations = true
+                    }
+                    self.handleQueryResult(result: conversations, page: page)
+                } else {
+                    let err = SKYErrorCreator()
+                        .error(with: SKYErrorBadResponse,
+                               message: "Query does not response Conversation")
+                    self.handleQueryError(error: err)
+                }
         })
     }
 
@@ -230,6 +327,8 @@ extension SKYChatConversationListViewController {
                 participantIDs: Array(participantIDs),
                 completion: {[weak self] (result, isCached, error) in
                     guard error == nil else {
+                        // allow the participants to be requested again
+                        self?.requestedParticipantIDs.subtract(participantIDs)
                         self?.handleParticipantQueryError(error: error!)
                         return
                     }
@@ -238,14 +337,137 @@ extension SKYChatConversationListViewController {
             })
     }
 
+    /*
+      Replace the conversations at the top of the list with the first page.
+      Participants are fetched lazily for the conversations being displayed,
+      see `enqueueParticipantQuery(forConversation:)`.
+     */
     open func handleQueryResult(result: [SKYConversation]) {
-        self.conversations = result
+        // keep the conversations loaded with later pages, including those
+        // pushed out of the first page, unless all conversations fit in the
+        // first page
+        let pageSize = self.conversationsPageSize
+        var remaining: [SKYConversation] = []
+        if result.count >= pageSize && self.nextPage > 2 {
+            let resultIDs = Set(result.map { $0.record.recordID.recordName })
+            remaining = self.conversations.filter {
+                !resultIDs.contains($0.record.recordID.recordName)
+            }
+        }
+        self.conversations = result + remaining
+        if !remaining.isEmpty {
+            // conversations may have moved between pages, continue after
+            // the ones already loaded
+            self.nextPage = max(2, self.conversations.count / pageSize + 1)
+        }
         self.tableView.reloadData()
 
-        let participantIDs = result
-            .reduce(Set([])) { return $0.union(Set($1.participantIds))}
+        self.prefetchConversations()
+    }
+
+    /*
+      Merge a page of conversations into the list. The first page is handled
+      by `handleQueryResult(result:)`, and other pages are appended.
+     */
+    open func handleQueryResult(result: [SKYConversation], page: Int) {
+        if page == 1 {
+            self.handleQueryResult(result: result)
+            return
+        }
+
+        let startIndex = self.conversations.count
+        let existingIDs = Set(self.conversations.map { $0.record.recordID.recordName })
+        self.conversations.append(contentsOf: result.filter {
+            !existingIDs.contains($0.record.recordID.recordName)
+        })
+        guard self.conversations.count > startIndex else {
+            return
+        }
 
-        self.performParticipantQuery(byIDs: Array(participantIDs))
+        let indexPaths = (startIndex..<self.conversations.count).map { IndexPath(row: $0, section: 0) }
+        self.tableView.insertRows(at: indexPaths, with: .none)
+    }
+
+    /*
+      Prefetch messages of the most recently active conversations in the
+      background, see `prefetchConversationCount`.
+     */
+    open func prefetchConversations() {
+        guard self.prefetchConversationCount > 0, !self.isPrefetchingConversations else {
+            return
+        }
+
+        let conversations = self.conversations.enumerated()
+            .sorted(by: { (lhs, rhs) in
+                let lhsDate = lhs.element.lastMessage?.creationDate ?? Date.distantPast
+                let rhsDate = rhs.element.lastMessage?.creationDate ?? Date.distantPast
+                if lhsDate != rhsDate {
+                    return lhsDate > rhsDate
+                }
+                return lhs.offset < rhs.offset
+            })
+            .prefix(self.prefetchConversationCount)
+            .map { $0.element }
+
+        self.isPrefetchingConversations = true
+        self.skygear.chatExtension?.prefetchMessages(
+            conversations: conversations,
+            limit: self.prefetchMessagesLimit,
+            byteBudget: self.prefetchByteBudget,
+            completion: { [weak self] (_, error) in
+                self?.isPrefetchingConversations = false
+                if let err = error {
+                    print("Failed to prefetch messages: \(err.localizedDescription)")
+                }
+        })
+    }
+
+    /*
+      Queue the participants of a conversation for fetching. Participants
+      queued in the same run loop iteration are fetched in one request, and
+      participants fetched or being fetched are skipped.
+     */
+    open func enqueueParticipantQuery(forConversation conversation: SKYConversation) {
+        let missingIDs = conversation.participantIds.filter {
+            self.participantMap[$0] == nil && !self.requestedParticipantIDs.contains($0)
+        }
+        guard missingIDs.count > 0 else {
+            return
+        }
+
+        let shouldSchedule = self.pendingParticipantIDs.isEmpty
+        self.requestedParticipantIDs.formUnion(missingIDs)
+        self.pendingParticipantIDs.formUnion(missingIDs)
+
+        if shouldSchedule {
+            DispatchQueue.main.async { [weak self] in
+                guard let strongSelf = self else {
+                    return
+                }
+
+                let participantIDs = Array(strongSelf.pendingParticipantIDs)
+                strongSelf.pendingParticipantIDs.removeAll()
+                strongSelf.performParticipantQuery(byIDs: participantIDs)
+            }
+        }
+    }
+
+    /*
+      Participants of a conversation displayed in its row, which exclude the
+      current user and participants not fetched yet.
+     */
+    open func displayedParticipants(
+        ofConversation conversation: SKYConversation
+    ) -> [SKYParticipant] {
+        let currentUserID = self.skygear.auth.currentUserRecordID
+        return conversation.participantIds.flatMap { (eachParticipantID) -> SKYParticipant? in
+            guard eachParticipantID != currentUserID else {
+                // no need to show current user's name
+                return nil
+            }
+
+            return self.participantMap[eachParticipantID]
+        }
     }
 
     open func handleQueryError(error: Error) {
@@ -256,8 +478,12 @@ extension SKYChatConversationListViewController {
         result.forEach({ (eachParticipantID, eachParticipant) in
             self.participantMap[eachParticipantID] = eachParticipant
         })
+        self.rowViewModelCache.invalidate(participantIDs: Array(result.keys))
 
-        self.tableView.reloadData()
+        // only the visible rows can be showing the newly fetched participants
+        if let visibleIndexPaths = self.tableView.indexPathsForVisibleRows, visibleIndexPaths.count > 0 {
+            self.tableView.reloadRows(at: visibleIndexPaths, with: .none)
+        }
     }
 
     open func handleParticipantQueryError(error: Error) {
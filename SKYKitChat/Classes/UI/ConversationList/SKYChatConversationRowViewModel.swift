@@ -0,0 +1,166 @@
+//
+//  SKYChatConversationRowViewModel.swift
+//  SKYKitChat
+//
+//  Copyright 2016 Oursky Ltd.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+import UIKit
+
+/**
+ SKYChatConversationRowViewModel holds the texts displayed by a conversation list cell, so that
+ they are computed once rather than on every layout pass.
+ */
+@objcMembers
+open class SKYChatConversationRowViewModel: NSObject {
+    public let conversation: SKYConversation
+
+    /**
+     The revision of the conversation the texts are computed from.
+     */
+    public let revision: String
+
+    /**
+     Participants displayed in the row, which exclude the current user.
+     */
+    public let participants: [SKYParticipant]
+
+    /**
+     The conversation title, or the names of the participants if the conversation has no title.
+     Nil if neither is available.
+     */
+    public let title: String?
+    public let previewText: String
+    public let participantCountText: String
+
+    /**
+     Nil if there is no unread message.
+     */
+    public let unreadCountText: String?
+
+    public init(conversation: SKYConversation, participants: [SKYParticipant]) {
+        self.conversation = conversation
+        self.revision = SKYChatConversationRowViewModel.revision(of: conversation)
+        self.participants = participants
+        self.title = conversation.title ?? conversation.nameList(fromParticipants: participants)
+        self.previewText = conversation.lastMessage?.body ?? ""
+
+        let participantCount = conversation.participantIds.count
+        if participantCount == 1 {
+            self.participantCountText = NSLocalizedString("1 participant", comment: "")
+        } else {
+            self.participantCountText =
+                String.localizedStringWithFormat("%d participants", participantCount)
+        }
+
+        let unreadCount = conversation.unreadCount
+        self.unreadCountText = unreadCount > 0 ? String(unreadCount) : nil
+    }
+
+    /**
+     Identifies a revision of the conversation by its modification date, last message, unread
+     count and participant count.
+     */
+    public static func revision(of conversation: SKYConversation) -> String {
+        let updatedAt = conversation.record.modificationDate?.timeIntervalSince1970 ?? 0
+        let lastMessageUpdatedAt =
+            conversation.lastMessage?.record.modificationDate?.timeIntervalSince1970 ?? 0
+        return "\(updatedAt)|\(conversation.lastMessageId ?? "")|\(lastMessageUpdatedAt)|" +
+            "\(conversation.unreadCount)|\(conversation.participantIds.count)"
+    }
+
+    /**
+     Returns whether the view model is computed from the same revision of the conversation.
+     The conversation list fetches new instances of conversations, so instances are not
+     compared.
+     */
+    open func isViewModel(of conversation: SKYConversation) -> Bool {
+        return self.conversation.recordName == conversation.recordName &&
+            self.revision == SKYChatConversationRowViewModel.revision(of: conversation)
+    }
+}
+
+/**
+ SKYChatConversationRowViewModelCache keeps the row view model of each conversation in the list.
+
+ A cached view model is reused only for the same revision of the conversation, which is
+ identified by its modification date, last message and unread count. View models showing a
+ participant are rebuilt after the participant is invalidated.
+ */
+@objcMembers
+open class SKYChatConversationRowViewModelCache: NSObject {
+
+    // MARK: - Entry
+
+    class Entry: NSObject {
+        let revision: String
+        let viewModel: SKYChatConversationRowViewModel
+
+        init(revision: String, viewModel: SKYChatConversationRowViewModel) {
+            self.revision = revision
+            self.viewModel = viewModel
+        }
+    }
+
+    // Not bounded, since there is at most one entry for each conversation in the list.
+    var store: [String: Entry] = [:]
+
+    // MARK: - Lookup
+
+    open func revision(of conversation: SKYConversation) -> String {
+        return SKYChatConversationRowViewModel.revision(of: conversation)
+    }
+
+    /**
+     Returns the cached view model of the conversation, calling the builder to build one if the
+     conversation is not cached or its revision has changed.
+     */
+    open func viewModel(
+        for conversation: SKYConversation,
+        builder: (SKYConversation) -> SKYChatConversationRowViewModel
+    ) -> SKYChatConversationRowViewModel {
+        let conversationID = conversation.recordName
+        let revision = self.revision(of: conversation)
+        if let entry = self.store[conversationID], entry.revision == revision {
+            return entry.viewModel
+        }
+
+        let viewModel = builder(conversation)
+        self.store[conversationID] = Entry(revision: revision, viewModel: viewModel)
+        return viewModel
+    }
+
+    // MARK: - Invalidation
+
+    open func invalidate(conversationID: String) {
+        self.store.removeValue(forKey: conversationID)
+    }
+
+    /**
+     Invalidates the view models of conversations having any of the participants.
+     */
+    open func invalidate(participantIDs: [String]) {
+        let participantIDSet = Set(participantIDs)
+        self.store = self.store.filter { (_, entry) in
+            !entry.viewModel.conversation.participantIds.contains(where: {
+                participantIDSet.contains($0)
+            })
+        }
+    }
+
+    open func invalidateAll() {
+        self.store.removeAll()
+    }
+}
@@ -28,6 +28,12 @@ open class SKYChatConversationTableViewCell: UITableViewCell {
     public var unreadMessageCount: Int?
     public var avatarImage: UIImage?
 
+    /**
+     Precomputed texts of the row. When set, the title, message, information and unread count
+     are taken from the view model instead of being computed on every layout pass.
+     */
+    public var viewModel: SKYChatConversationRowViewModel?
+
     @IBOutlet public weak var avatarImageView: UIImageView!
     @IBOutlet public weak var conversationTitleLabel: UILabel!
     @IBOutlet public weak var conversationMessageLabel: UILabel!
@@ -75,6 +81,11 @@ open class SKYChatConversationTableViewCell: UITableViewCell {
      * to implement a custom layout.
      **/
     open func layoutSubviews(conversation: SKYConversation) {
+        if let viewModel = self.viewModel, viewModel.isViewModel(of: conversation) {
+            self.layoutSubviews(viewModel: viewModel)
+            return
+        }
+
         // title
         self.conversationTitleLabel?.textColor = self.conversationTitleLabel?.tintColor
         if let title = conversation.title {
@@ -115,4 +126,32 @@ open class SKYChatConversationTableViewCell: UITableViewCell {
             self.unreadCountView?.removeFromSuperview()
         }
     }
+
+    /**
+     * Layout subviews according to the precomputed view model of the conversation.
+     **/
+    open func layoutSubviews(viewModel: SKYChatConversationRowViewModel) {
+        // title
+        if let title = viewModel.title {
+            self.conversationTitleLabel?.text = title
+            self.conversationTitleLabel?.textColor = self.conversationTitleLabel?.tintColor
+        } else {
+            self.conversationTitleLabel?.text = untitledConversation
+            self.conversationTitleLabel?.textColor = UIColor.lightGray
+        }
+
+        // message
+        self.conversationMessageLabel.text = self.conversationMessage ?? viewModel.previewText
+
+        // extra info
+        self.conversationInformationLabel?.text =
+            self.conversationInformation ?? viewModel.participantCountText
+
+        // unread count
+        if let unreadCountText = viewModel.unreadCountText {
+            self.unreadCountLabel?.text = unreadCountText
+        } else {
+            self.unreadCountView?.removeFromSuperview()
+        }
+    }
 }
@@ -0,0 +1,252 @@
+//
+//  SKYChatAudioStreamLoader.swift
+//  SKYKitChat
+//
+//  Copyright 2016 Oursky Ltd.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+import AVFoundation
+import MobileCoreServices
+
+// AVFoundation only asks the resource loader delegate for URLs it cannot load by itself.
+private let streamingURLScheme = "skychat-stream"
+
+// Upper bound of bytes handed to a loading request at a time.
+private let maxResponseLength: Int64 = 256 * 1024
+
+/**
+ SKYChatAudioStreamLoader downloads an audio asset progressively and serves the bytes to
+ AVFoundation as they arrive, so that playback can start before the download finishes.
+
+ Downloaded bytes are written to a partial file of the disk cache, which is moved into the
+ cache once the download completes.
+ */
+class SKYChatAudioStreamLoader: NSObject, AVAssetResourceLoaderDelegate, URLSessionDataDelegate {
+    let asset: SKYAsset
+    let diskCache: SKYAssetDiskCache
+
+    /**
+     Called on main thread when the download ends, with the URL of the cached file, or nil
+     if the download failed.
+     */
+    var completion: ((URL?) -> Void)?
+
+    // Resource loader callbacks, session callbacks and all state below are serialized on it.
+    private let queue = DispatchQueue(label: "io.skygear.chat.audio-stream")
+
+    private var session: URLSession?
+    private var writeHandle: FileHandle?
+    private var readHandle: FileHandle?
+    private var contentType: String?
+    private var contentLength: Int64 = -1
+    private var downloadedLength: Int64 = 0
+    private var responseReceived = false
+    private var finished = false
+    private var responseError: Error?
+    private var pendingRequests = [AVAssetResourceLoadingRequest]()
+
+    init(asset: SKYAsset, diskCache: SKYAssetDiskCache) {
+        self.asset = asset
+        self.diskCache = diskCache
+        super.init()
+    }
+
+    lazy var urlAsset: AVURLAsset = {
+        var components = URLComponents(url: self.asset.url, resolvingAgainstBaseURL: false)
+        components?.scheme = streamingURLScheme
+        let urlAsset = AVURLAsset(url: components?.url ?? self.asset.url)
+        urlAsset.resourceLoader.setDelegate(self, queue: self.queue)
+        return urlAsset
+    }()
+
+    func start() {
+        self.queue.async {
+            guard self.session == nil else {
+                return
+            }
+
+            let partialURL = self.diskCache.partialFileURL(for: self.asset)
+            FileManager.default.createFile(atPath: partialURL.path, contents: nil, attributes: nil)
+            self.writeHandle = try? FileHandle(forWritingTo: partialURL)
+            self.readHandle = try? FileHandle(forReadingFrom: partialURL)
+
+            let delegateQueue = OperationQueue()
+            delegateQueue.maxConcurrentOperationCount = 1
+            delegateQueue.underlyingQueue = self.queue
+            let session = URLSession(configuration: .default,
+                                     delegate: self,
+                                     delegateQueue: delegateQueue)
+            self.session = session
+            session.dataTask(with: self.asset.url).resume()
+        }
+    }
+
+    func cancel() {
+        self.queue.async {
+            self.completion = nil
+            self.session?.invalidateAndCancel()
+        }
+    }
+
+    // MARK: - AVAssetResourceLoaderDelegate
+
+    func resourceLoader(_ resourceLoader: AVAssetResourceLoader,
+                        shouldWaitForLoadingOfRequestedResource
+                        loadingRequest: AVAssetResourceLoadingRequest) -> Bool {
+        self.pendingRequests.append(loadingRequest)
+        self.processPendingRequests()
+        return true
+    }
+
+    func resourceLoader(_ resourceLoader: AVAssetResourceLoader,
+                        didCancel loadingRequest: AVAssetResourceLoadingRequest) {
+        self.pendingRequests = self.pendingRequests.filter { $0 !== loadingRequest }
+    }
+
+    // MARK: - URLSessionDataDelegate
+
+    func urlSession(_ session: URLSession,
+                    dataTask: URLSessionDataTask,
+                    didReceive response: URLResponse,
+                    completionHandler: @escaping (URLSession.ResponseDisposition) -> Void) {
+        // an error body, such as of an expired asset URL, must not be played or cached
+        if let httpResponse = response as? HTTPURLResponse,
+            !(200..<300).contains(httpResponse.statusCode) {
+            let description = HTTPURLResponse.localizedString(
+                forStatusCode: httpResponse.statusCode)
+            self.responseError = NSError(domain: NSURLErrorDomain,
+                                         code: NSURLErrorBadServerResponse,
+                                         userInfo: [NSLocalizedDescriptionKey: description])
+            completionHandler(.cancel)
+            return
+        }
+
+        self.responseReceived = true
+        self.contentLength = response.expectedContentLength
+        self.contentType = SKYChatAudioStreamLoader.uniformTypeIdentifier(
+            forMimeType: response.mimeType ?? self.asset.mimeType)
+        completionHandler(.allow)
+        self.processPendingRequests()
+    }
+
+    func urlSession(_ session: URLSession, dataTask: URLSessionDataTask, didReceive data: Data) {
+        self.writeHandle?.write(data)
+        self.downloadedLength += Int64(data.count)
+        self.processPendingRequests()
+    }
+
+    func urlSession(_ session: URLSession,
+                    task: URLSessionTask,
+                    didCompleteWithError error: Error?) {
+        self.finished = true
+        self.writeHandle?.closeFile()
+        self.writeHandle = nil
+        session.finishTasksAndInvalidate()
+
+        let partialURL = self.diskCache.partialFileURL(for: self.asset)
+        let completion = self.completion
+        self.completion = nil
+
+        if let error = self.responseError ?? error {
+            self.pendingRequests.forEach { $0.finishLoading(with: error) }
+            self.pendingRequests.removeAll()
+            try? FileManager.default.removeItem(at: partialURL)
+            DispatchQueue.main.async {
+                completion?(nil)
+            }
+            return
+        }
+
+        self.contentLength = self.downloadedLength
+        self.processPendingRequests()
+
+        // The read handle stays valid after the move, so later loading requests are still
+        // served from the same file.
+        self.diskCache.set(fileAt: partialURL, for: self.asset)
+        let fileURL = self.diskCache.fileURL(for: self.asset)
+        DispatchQueue.main.async {
+            completion?(fileURL)
+        }
+    }
+
+    // MARK: - Serving Data
+
+    private func processPendingRequests() {
+        guard self.responseReceived else {
+            return
+        }
+
+        self.pendingRequests = self.pendingRequests.filter { loadingRequest in
+            if let informationRequest = loadingRequest.contentInformationRequest {
+                informationRequest.contentType = self.contentType
+                informationRequest.contentLength = max(self.contentLength, 0)
+                informationRequest.isByteRangeAccessSupported = true
+            }
+
+            guard let dataRequest = loadingRequest.dataRequest else {
+                loadingRequest.finishLoading()
+                return false
+            }
+
+            if self.respond(to: dataRequest) {
+                loadingRequest.finishLoading()
+                return false
+            }
+            return true
+        }
+    }
+
+    /**
+     Responds with the bytes available for the data request, returning true when the
+     request has been fully served.
+     */
+    private func respond(to dataRequest: AVAssetResourceLoadingDataRequest) -> Bool {
+        var requestedEnd = dataRequest.requestedOffset + Int64(dataRequest.requestedLength)
+        if dataRequest.requestsAllDataToEndOfResource {
+            requestedEnd = self.contentLength >= 0 ? self.contentLength : Int64.max
+        }
+
+        var offset = dataRequest.currentOffset
+        while offset < min(requestedEnd, self.downloadedLength) {
+            let length = min(requestedEnd, self.downloadedLength, offset + maxResponseLength)
+                - offset
+            guard let handle = self.readHandle else {
+                break
+            }
+
+            handle.seek(toFileOffset: UInt64(offset))
+            let data = handle.readData(ofLength: Int(length))
+            if data.isEmpty {
+                break
+            }
+            dataRequest.respond(with: data)
+            offset += Int64(data.count)
+        }
+
+        return offset >= requestedEnd || (self.finished && offset >= self.downloadedLength)
+    }
+
+    static func uniformTypeIdentifier(forMimeType mimeType: String) -> String {
+        // m4a voice notes are recorded with a mime type that has no registered UTI
+        if mimeType == "audio/m4a" {
+            return kUTTypeMPEG4Audio as String
+        }
+
+        let identifier = UTTypeCreatePreferredIdentifierForTag(kUTTagClassMIMEType,
+                                                               mimeType as CFString,
+                                                               nil)?.takeRetainedValue()
+        return (identifier as String?) ?? (kUTTypeAudio as String)
+    }
+}
@@ -27,8 +27,20 @@ class SKYChatConversationAudioItem: JSQAudioMediaItem {
     var childView: UIView?
 
     var assetCache: SKYAssetCache?
+    var diskCache: SKYAssetDiskCache = SKYAssetDiskCache.shared()
     var asset: SKYAsset?
 
+    // Used until the download completes, after which the item switches to the audio player
+    // of JSQAudioMediaItem.
+    var streamLoader: SKYChatAudioStreamLoader?
+    var streamPlayer: AVPlayer?
+    var streamingView: UIView?
+    var streamingPlayButton: UIButton?
+
+    // Drawn over the audio player from the waveform in the message metadata, so that the
+    // recording does not need to be read to show it.
+    var waveformView: SKYChatVoiceWaveformView?
+
     convenience init(withMessage message: SKYMessage, maskAsOutgoing isOutGoing: Bool) {
         self.init(withMessage: message, assetCache: nil, maskAsOutgoing: isOutGoing)
     }
@@ -54,34 +66,34 @@ class SKYChatConversationAudioItem: JSQAudioMediaItem {
         self.assetCache = assetCache
         self.asset = asset
 
-        if let data = self.assetCache?.get(asset: asset) {
+        if let waveform = SKYChatVoiceMessage.waveform(for: message) {
+            self.waveformView = self.makeWaveformView(levels: waveform)
+        }
+
+        if let data = self.assetCache?.get(asset: asset) ?? self.cachedData(for: asset) {
             self.audioData = data
         } else {
-            DispatchQueue.global().async { [weak self] in
-                guard let myself = self else {
-                    return
-                }
-
-                guard let data = try? Data(contentsOf: asset.url) else {
-                    return
-                }
-
-                myself.audioData = data
-                myself.assetCache?.set(data: data, for: asset)
-
-                DispatchQueue.main.sync {  [weak self] in
-                    guard let myself = self else {
-                        return
-                    }
+            let loader = SKYChatAudioStreamLoader(asset: asset, diskCache: self.diskCache)
+            loader.completion = { [weak self] fileURL in
+                self?.streamDidFinish(fileURL: fileURL)
+            }
+            loader.start()
+            self.streamLoader = loader
+        }
+    }
 
-                    if myself.audioData != nil {
-                        myself.childView?.removeFromSuperview()
-                        myself.childView = myself.mediaView()
-                    }
-                }
+    deinit {
+        self.streamLoader?.cancel()
+        NotificationCenter.default.removeObserver(self)
+    }
 
-            }
+    func cachedData(for asset: SKYAsset) -> Data? {
+        // assets of messages being sent point to local files
+        if asset.url.isFileURL {
+            return try? Data(contentsOf: asset.url, options: .alwaysMapped)
         }
+
+        return self.diskCache.get(asset: asset)
     }
 
     override func audioPlayerDidFinishPlaying(_ player: AVAudioPlayer, successfully flag: Bool) {
@@ -93,13 +105,25 @@ class SKYChatConversationAudioItem: JSQAudioMediaItem {
         if view != nil {
             self.childView = view
             self.view?.addSubview(view!)
+        } else if self.streamLoader != nil {
+            if self.streamingView == nil {
+                self.streamingView = self.makeStreamingView()
+                self.view?.addSubview(self.streamingView!)
+            }
         } else {
             self.view?.addSubview(self.mediaPlaceholderView())
         }
+
+        if let waveformView = self.waveformView {
+            // adding the view again brings it above the player view
+            self.view?.addSubview(waveformView)
+        }
         return self.view
     }
 
     open func stop() {
+        self.streamPlayer?.pause()
+        self.streamingPlayButton?.isSelected = false
         self.clearCachedMediaViews()
     }
 
@@ -107,3 +131,136 @@ class SKYChatConversationAudioItem: JSQAudioMediaItem {
         fatalError("init(coder:) has not been implemented")
     }
 }
+
+// MARK: - Waveform
+
+extension SKYChatConversationAudioItem {
+
+    func makeWaveformView(levels: [UInt8]) -> SKYChatVoiceWaveformView {
+        let attributes = self.audioViewAttributes
+        let size = self.mediaViewDisplaySize()
+        let insets = attributes.controlInsets
+
+        // JSQAudioMediaItem lays out the play button, the progress bar in the middle and the
+        // duration label, so the waveform stands on the progress bar between the button and
+        // the label.
+        let labelWidth = ("00:00" as NSString)
+            .size(withAttributes: [NSAttributedStringKey.font: attributes.labelFont])
+            .width
+        let x = insets.left + attributes.playButtonImage.size.width + attributes.controlPadding
+        let width = size.width - x - labelWidth - attributes.controlPadding - insets.right
+        let height = (size.height - insets.top - insets.bottom) / 2 - 2
+
+        let view = SKYChatVoiceWaveformView(frame: CGRect(x: x,
+                                                          y: insets.top,
+                                                          width: max(0, width),
+                                                          height: max(0, height)))
+        view.levels = levels
+        view.barColor = attributes.tintColor.withAlphaComponent(0.6)
+        return view
+    }
+}
+
+// MARK: - Streaming
+
+extension SKYChatConversationAudioItem {
+
+    func makeStreamingView() -> UIView {
+        let attributes = self.audioViewAttributes
+        let size = self.mediaViewDisplaySize()
+        let insets = attributes.controlInsets
+        let buttonImage = attributes.playButtonImage
+
+        let view = UIView(frame: CGRect(origin: CGPoint.zero, size: size))
+        view.backgroundColor = attributes.backgroundColor
+        view.isUserInteractionEnabled = true
+
+        let button = UIButton(type: .custom)
+        button.setImage(attributes.playButtonImage, for: .normal)
+        button.setImage(attributes.pauseButtonImage, for: .selected)
+        button.tintColor = attributes.tintColor
+        button.frame = CGRect(x: insets.left,
+                              y: insets.top,
+                              width: buttonImage.size.width,
+                              height: size.height - insets.top - insets.bottom)
+        button.addTarget(self,
+                         action: #selector(streamingPlayButtonDidTap(_:)),
+                         for: .touchUpInside)
+        view.addSubview(button)
+        self.streamingPlayButton = button
+
+        JSQMessagesMediaViewBubbleImageMasker.applyBubbleImageMask(
+            toMediaView: view,
+            isOutgoing: self.appliesMediaViewMaskAsOutgoing)
+        return view
+    }
+
+    @objc func streamingPlayButtonDidTap(_ sender: UIButton) {
+        if let player = self.streamPlayer, player.rate > 0 {
+            player.pause()
+            sender.isSelected = false
+            return
+        }
+
+        if self.streamPlayer == nil {
+            guard let loader = self.streamLoader else {
+                return
+            }
+
+            let attributes = self.audioViewAttributes
+            try? AVAudioSession.sharedInstance().setCategory(attributes.audioCategory,
+                                                             with: attributes.audioCategoryOptions)
+
+            let playerItem = AVPlayerItem(asset: loader.urlAsset)
+            NotificationCenter.default.addObserver(self,
+                                                   selector: #selector(streamDidPlayToEnd),
+                                                   name: .AVPlayerItemDidPlayToEndTime,
+                                                   object: playerItem)
+            self.streamPlayer = AVPlayer(playerItem: playerItem)
+        }
+
+        self.streamPlayer?.play()
+        sender.isSelected = true
+    }
+
+    @objc func streamDidPlayToEnd() {
+        self.streamPlayer?.seek(to: kCMTimeZero)
+        self.streamingPlayButton?.isSelected = false
+
+        if self.audioData != nil {
+            self.switchToAudioPlayer()
+        }
+    }
+
+    func streamDidFinish(fileURL: URL?) {
+        guard let url = fileURL,
+            let data = try? Data(contentsOf: url, options: .alwaysMapped) else {
+            return
+        }
+
+        self.audioData = data
+
+        // keep the streaming player until the current playback ends
+        if let player = self.streamPlayer, player.rate > 0 {
+            return
+        }
+        self.switchToAudioPlayer()
+    }
+
+    func switchToAudioPlayer() {
+        if let playerItem = self.streamPlayer?.currentItem {
+            NotificationCenter.default.removeObserver(self,
+                                                      name: .AVPlayerItemDidPlayToEndTime,
+                                                      object: playerItem)
+        }
+
+        self.streamPlayer = nil
+        self.streamLoader = nil
+        self.streamingPlayButton = nil
+        self.streamingView?.removeFromSuperview()
+        self.streamingView = nil
+
+        self.childView?.removeFromSuperview()
+        self.childView = self.mediaView()
+    }
+}
@@ -35,10 +35,11 @@ class SKYChatConversationImageItem: JSQMediaItem {
     var tap: UITapGestureRecognizer?
     weak var delegate: SKYChatConversationImageItemDelegate?
     var assetUrl: URL?
-
-    var getImage: (() -> UIImage?)?
+    var asset: SKYAsset?
+    var message: SKYMessage?
 
     var assetCache: SKYAssetCache?
+    var thumbnailCache: SKYChatThumbnailCache = SKYChatThumbnailCache.shared()
 
     override func mediaView() -> UIView? {
         if self.image != nil {
@@ -46,15 +47,30 @@ class SKYChatConversationImageItem: JSQMediaItem {
         }
 
         let imageView = UIImageView(image: self.thumbnailImage)
-        DispatchQueue.global().async {
-            let image = self.getImage!()
-            DispatchQueue.main.sync {
-                if image != nil {
-                    imageView.image = image
+        if self.thumbnailImage == nil, let message = self.message {
+            self.thumbnailCache.thumbnail(for: message, size: self.displaySize) {
+                [weak self, weak imageView] thumbnail in
+                self?.thumbnailImage = thumbnail
+                if imageView?.image == nil {
+                    imageView?.image = thumbnail
                 }
             }
         }
 
+        let asset = self.asset
+        let displaySize = self.displaySize
+        DispatchQueue.global(qos: .userInitiated).async { [weak self] in
+            guard let image = self?.getImage(fromAsset: asset) else {
+                return
+            }
+
+            let rendered = SKYChatThumbnailCache.preRender(image: image, size: displaySize)
+            DispatchQueue.main.async {
+                self?.image = rendered
+                imageView.image = rendered
+            }
+        }
+
         let rect = CGRect.init(origin: CGPoint.zero, size: self.displaySize)
         imageView.frame = rect
 
@@ -98,16 +114,10 @@ extension SKYChatConversationImageItem {
 
         let asset = message.attachment
         self.assetUrl = asset?.url
+        self.asset = asset
+        self.message = message
         let metadata = message.metadata ?? [String: Any]()
 
-        var thumbnailImage: UIImage? = nil
-        if let thumbnailImageString = metadata["thumbnail"] as? String {
-            let thumbnailImageData =
-                Data(base64Encoded: thumbnailImageString, options: .ignoreUnknownCharacters)
-            thumbnailImage = UIImage(data: thumbnailImageData!)
-        }
-        self.thumbnailImage = thumbnailImage
-
         self.imageName = asset!.name
         if let width = metadata["width"] as? CGFloat, let height = metadata["height"] as? CGFloat {
             let imageSize = CGSize.init(width: width, height: height)
@@ -116,9 +126,9 @@ extension SKYChatConversationImageItem {
             self.displaySize = SKYChatConversationImageItem.getDefaultDisplaySize()
         }
 
-        self.getImage = {
-            return self.getImage(fromAsset: asset)
-        }
+        // Thumbnails are decoded in background when the media view is requested, so only
+        // previously decoded ones are picked up here.
+        self.thumbnailImage = self.thumbnailCache.cachedThumbnail(forMessageID: message.recordName)
     }
 
     @objc func imageDidTap() {
@@ -138,8 +148,7 @@ extension SKYChatConversationImageItem {
             }
         }
 
-        let assetUrl = (asset?.url)!
-        guard let data = try? Data(contentsOf: assetUrl) else {
+        guard let assetUrl = asset?.url, let data = try? Data(contentsOf: assetUrl) else {
             return nil
         }
 
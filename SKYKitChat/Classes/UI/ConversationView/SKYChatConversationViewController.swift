@@ -288,12 +288,31 @@ open class SKYChatConversationViewController: JSQMessagesViewController, AVAudio
     public var participants: [String: SKYParticipant] = [:]
     public var messageList: MessageList = MessageList()
     public var messageErrorByIDs: [String: Error] = [:]
+    @available(*, deprecated, message: "Use SKYChatExtension.typingIndicatorExpiryInterval instead")
     public var typingIndicatorShowDuration: TimeInterval = TimeInterval(5)
+    public var voiceMessageFormat: SKYChatVoiceMessageFormat = .aac
+
+    /**
+     The maximum number of picked photos scaled and encoded at the same time when sending them
+     together.
+     */
+    public var maxConcurrentImageProcessing: Int = 2
     public var offsetYToLoadMore: CGFloat = CGFloat(400)
 
     fileprivate var hasMoreMessageToFetch: Bool = false
     fileprivate var isFetchingMessage: Bool = false
 
+    /**
+     Opens the conversation at the last read message instead of the most recent message, and
+     fetches newer messages while scrolling down.
+     */
+    public var opensAtLastReadMessage: Bool = false
+
+    // The newest message of the pages fetched around the last read message, and whether there
+    // are newer messages on the server that are not fetched yet.
+    fileprivate var newerMessagesCursor: SKYMessage?
+    fileprivate var hasNewerMessageToFetch: Bool = false
+
     fileprivate var conversationBackgroundView: UIImageView?
 
     public var messagesFetchLimit: UInt {
@@ -309,6 +328,10 @@ open class SKYChatConversationViewController: JSQMessagesViewController, AVAudio
 
     public var messageChangeObserver: Any?
     public var typingIndicatorChangeObserver: Any?
+    public var cachedMessagesQuery: SKYChatCacheLiveQuery?
+    public var unsentMessagesQuery: SKYChatCacheLiveQuery?
+    fileprivate var cachedMessages: [SKYMessage] = []
+    @available(*, deprecated, message: "Typing indicator expiry is scheduled by SKYChatExtension")
     public var typingIndicatorPromptTimer: Timer?
 
     public let bubbleFactory = JSQMessagesBubbleImageFactory()
@@ -322,9 +345,42 @@ open class SKYChatConversationViewController: JSQMessagesViewController, AVAudio
     public private(set) var outgoingAudioMessageButtonColor: UIColor?
 
     let downloadDispatcher = SimpleDownloadDispatcher.default()
+    let avatarImageCache = SKYChatAvatarImageCache.shared()
     let dataCache: DataCache = MemoryDataCache.shared()
     let assetCache: SKYAssetCache = SKYAssetMemoryCache.shared()
     lazy var messageMediaDataFactory = JSQMessageMediaDataFactory(with: self.assetCache)
+    public let messageViewModelCache = SKYChatMessageViewModelCache()
+
+    /**
+     Fetches older pages ahead of scrolling according to the scrolling velocity. When disabled,
+     an older page is fetched only when the top is within `offsetYToLoadMore`.
+     */
+    public var usesLookaheadPrefetching: Bool = true
+
+    public lazy var olderMessagesPrefetcher: SKYChatMessagePagePrefetcher = {
+        let prefetcher = SKYChatMessagePagePrefetcher(
+            pageSize: Int(self.messagesFetchLimit),
+            fetcher: { [weak self] (before, limit, completion) in
+                guard let strongSelf = self, let conversation = strongSelf.conversation else {
+                    completion(nil, false, nil)
+                    return
+                }
+
+                strongSelf.skygear.chatExtension?.fetchMessages(conversation: conversation,
+                                                                limit: limit,
+                                                                beforeMessage: before,
+                                                                order: nil,
+                                                                completion: completion)
+        })
+        prefetcher.minimumLookaheadDistance = self.offsetYToLoadMore
+        prefetcher.pageDidBecomeReady = { [weak self] page in
+            self?.prefetchedPageDidBecomeReady(page)
+        }
+        prefetcher.serverPageDidArriveAfterInsertion = { [weak self] page in
+            self?.reconcileInsertedPage(page)
+        }
+        return prefetcher
+    }()
 
     public var conversationViewBackgroundColor: UIColor {
         if let color = self.delegate?.backgroundColorForConversationViewController?(self) {
@@ -614,13 +670,20 @@ extension SKYChatConversationViewController {
         }
 
         if self.messageList.count == 0 {
-            self.fetchUnsentMessages()
-            self.fetchMessages(before: nil)
+            if self.opensAtLastReadMessage,
+                let lastReadMessageID = self.conversation?.lastReadMessageId,
+                lastReadMessageID != self.conversation?.lastMessageId {
+                self.fetchMessages(around: lastReadMessageID)
+            } else {
+                self.fetchMessages(before: nil)
+            }
         }
 
         self.subscribeToPubsubConnectivity()
         self.subscribeMessageChanges()
         self.subscribeTypingIndicatorChanges()
+        self.observeCachedMessages()
+        self.observeUnsentMessages()
     }
 
     override open func viewDidDisappear(_ animated: Bool) {
@@ -629,6 +692,8 @@ extension SKYChatConversationViewController {
         self.unsubscribeFromPubsubConnectivity()
         self.unsubscribeMessageChanges()
         self.unsubscribeTypingIndicatorChanges()
+        self.stopObservingCachedMessages()
+        self.stopObservingUnsentMessages()
         self.skygear.chatExtension?.unsubscribeFromUserChannel()
         for (_, audioItem) in self.audioDict {
             audioItem.stop()
@@ -916,6 +981,16 @@ extension SKYChatConversationViewController {
     open override func collectionView(_ collectionView: JSQMessagesCollectionView!,
                                       messageDataForItemAt indexPath: IndexPath!) -> JSQMessageData! {
         let msg = self.messageList.messageAt(indexPath.row)
+        return self.messageViewModelCache.messageData(for: msg) { (msg) in
+            return self.buildMessageData(for: msg)
+        }
+    }
+
+    /**
+     Builds the message data of a message for display. The result is cached in
+     `messageViewModelCache` until the message is updated.
+     */
+    open func buildMessageData(for msg: SKYMessage) -> JSQMessage {
         let msgSenderName = self.getSenderName(forMessage: msg) ?? ""
 
         let isOutgoingMessage = msg.creatorUserRecordID == self.senderId
@@ -1163,61 +1238,39 @@ extension SKYChatConversationViewController {
             // get from avatar field
             let avatarField = SKYChatUIModelCustomization.default().userAvatarField
             let senderAvatar = sender?.record.object(forKey: avatarField)
-            let getAvatarPlaceholderImage: () -> UIImage? = { [weak self] in
-                // from cache
-                let avatarPlaceholderCacheKey = "avatar-placeholder"
-                if let cachedData = self?.dataCache.getData(forKey: avatarPlaceholderCacheKey) {
-                    return UIImage(data: cachedData)
-                }
-
-                // draw the image
-                if let placeholderImage = UIImage.avatarPlaceholderImage() {
-                    if let data = UIImagePNGRepresentation(placeholderImage) {
-                        self?.dataCache.set(data: data, forKey: avatarPlaceholderCacheKey)
-                    }
-                    return placeholderImage
-                }
-
-                return nil
+            let getAvatarPlaceholderImage: () -> UIImage? = {
+                // cached by the renderer, without encoding it
+                return UIImage.avatarPlaceholderImage()
+            }
+            // decoded at the avatar size and cached per sender, reloading the sender's
+            // avatars once loaded
+            let senderID = msg.creatorUserRecordID
+            let reloadAvatars: (String) -> Void = { [weak self] userID in
+                self?.reloadAvatars(forSenderID: userID)
             }
             switch senderAvatar {
             case let senderAvatarUrl as String:
-                if let data = self.dataCache.getData(forKey: senderAvatarUrl) {
-                    return JSQMessagesAvatarImage.avatar(with: UIImage(data: data))
+                if let url = URL(string: senderAvatarUrl),
+                    let image = self.avatarImageCache.avatar(forUserID: senderID,
+                                                             url: url,
+                                                             diameter: self.avatarDiameter,
+                                                             dataCache: self.dataCache,
+                                                             completion: reloadAvatars) {
+                    return JSQMessagesAvatarImage.avatar(with: image)
                 }
 
-                // download from url
-                _ = self.downloadDispatcher.download(senderAvatarUrl, compltion: { data in
-                    guard let downloadedData = data else {
-                        return
-                    }
-
-                    // notify to update the avatar when download is done
-                    self.dataCache.set(data: downloadedData, forKey: senderAvatarUrl)
-                    self.conversationView?.reloadItems(at: [indexPath])
-                })
-
                 if let placeholderImage = getAvatarPlaceholderImage() {
                     return JSQMessagesAvatarImage.avatar(with: placeholderImage)
                 }
             case let senderAvatarAsset as SKYAsset:
-                if let data = self.assetCache.get(asset: senderAvatarAsset) {
-                    return JSQMessagesAvatarImage.avatar(with: UIImage(data: data))
+                if let image = self.avatarImageCache.avatar(forUserID: senderID,
+                                                            asset: senderAvatarAsset,
+                                                            diameter: self.avatarDiameter,
+                                                            assetCache: self.assetCache,
+                                                            completion: reloadAvatars) {
+                    return JSQMessagesAvatarImage.avatar(with: image)
                 }
 
-                // download asset
-                _ = self.downloadDispatcher.download(
-                    senderAvatarAsset.url.absoluteString,
-                    compltion: { data in
-                        guard let downloadedData = data else {
-                            return
-                        }
-
-                        // notify to update the avatar when download is done
-                        self.assetCache.set(data: downloadedData, for: senderAvatarAsset)
-                        self.conversationView?.reloadItems(at: [indexPath])
-                })
-
                 if let placeholderImage = getAvatarPlaceholderImage() {
                     return JSQMessagesAvatarImage.avatar(with: placeholderImage)
                 }
@@ -1225,19 +1278,69 @@ extension SKYChatConversationViewController {
             }
         }
 
-        // fallback: generate from user name
+        // fallback: generate from user name, rendered in background if not yet cached
         let senderName = self.getSenderName(forMessage: msg) ?? ""
-        if let avatarImage = UIImage.avatarImage(forInitialsOfName: senderName,
-                                                 backgroundColor: SKYChatConversationView.UICustomization().avatarBackgroundColor,
-                                                 textColor: SKYChatConversationView.UICustomization().avatarTextColor),
-            let roundedImage = UIImage.circleImage(fromImage: avatarImage) {
+        let customization = SKYChatConversationView.UICustomization()
+        var gradientColors = UIImage.getAvatarDefaultGradientColors()
+        if let backgroundColor = customization.avatarBackgroundColor {
+            gradientColors = [backgroundColor, backgroundColor]
+        }
+
+        let renderer = SKYChatAvatarRenderer.shared()
+        if let roundedImage = renderer.cachedAvatarImage(
+            forInitialsOfName: senderName,
+            gradientColors: gradientColors,
+            textColor: customization.avatarTextColor ?? UIImage.getAvatarDefaultTextColor(),
+            size: UIImage.getAvatarDefaultSize(),
+            circular: true,
+            completion: { [weak self] image in
+                guard image != nil else {
+                    print("Error: Cannot generate avatar image")
+                    return
+                }
+
+                self?.reloadAvatars(forSenderID: msg.creatorUserRecordID)
+        }) {
             return JSQMessagesAvatarImage.avatar(with: roundedImage)
         }
 
-        print("Error: Cannot generate avatar image")
+        if let placeholderImage = renderer.placeholderImage(size: UIImage.getAvatarDefaultSize(),
+                                                            circular: true) {
+            return JSQMessagesAvatarImage.avatar(with: placeholderImage)
+        }
+
         return nil
     }
 
+    var avatarDiameter: CGFloat {
+        let layout = self.conversationView?.collectionViewLayout
+        let diameter = max(layout?.incomingAvatarViewSize.width ?? 0,
+                           layout?.outgoingAvatarViewSize.width ?? 0)
+        return diameter > 0 ? diameter : kJSQMessagesCollectionViewAvatarSizeDefault
+    }
+
+    /**
+     Reloads the visible messages of the sender in one batch, after the avatar of the sender
+     becomes available.
+     */
+    open func reloadAvatars(forSenderID senderID: String) {
+        guard let collectionView = self.conversationView else {
+            return
+        }
+
+        let indexPaths = collectionView.indexPathsForVisibleItems.filter { indexPath in
+            guard indexPath.row < self.messageList.count else {
+                return false
+            }
+
+            return self.messageList.messageAt(indexPath.row).creatorUserRecordID == senderID
+        }
+
+        if !indexPaths.isEmpty {
+            collectionView.reloadItems(at: indexPaths)
+        }
+    }
+
     // Subclasses can override this method to render a custom typing indicator
     open func displayTypingIndicator() {
         guard self.showTypingIndicator == false else {
@@ -1334,8 +1437,12 @@ extension SKYChatConversationViewController {
 extension SKYChatConversationViewController {
 
     func beforeSending(message msg: SKYMessage) {
-        // push the "sending" message to message list
-        self.messageList.append([msg])
+        self.beforeSending(messages: [msg])
+    }
+
+    func beforeSending(messages: [SKYMessage]) {
+        // push the "sending" messages to message list
+        self.messageList.append(messages)
         self.collectionView?.reloadData()
 
         if self.shouldShowVoiceMessageButton {
@@ -1348,7 +1455,9 @@ extension SKYChatConversationViewController {
         }
 
         self.skygear.chatExtension?.sendTypingIndicator(.finished, in: self.conversation!)
-        self.delegate?.conversationViewController?(self, readyToSendMessage: msg)
+        for msg in messages {
+            self.delegate?.conversationViewController?(self, readyToSendMessage: msg)
+        }
     }
 
     func send(message msg: SKYMessage, done: ((_ sentMsg: SKYMessage) -> Void)? = nil) {
@@ -1379,6 +1488,7 @@ extension SKYChatConversationViewController {
                     return
                 }
 
+                SKYChatVoiceMessage.didSendRecording(of: msg, sentMessage: sentMsg)
                 self.successfullySending(message: sentMsg)
                 done?(sentMsg)
         })
@@ -1471,7 +1581,9 @@ extension SKYChatConversationViewController {
     }
 
     open override func scrollViewDidScrollToTop(_ scrollView: UIScrollView) {
-        if self.shouldLoadMoreMessage() {
+        if self.usesLookaheadPrefetching {
+            self.prefetchOlderMessagesIfNeeded()
+        } else if self.shouldLoadMoreMessage() {
             self.loadMoreMessage()
         }
     }
@@ -1486,10 +1598,18 @@ extension SKYChatConversationViewController {
             }
         }
 
-        if self.shouldLoadMoreMessage() {
+        if self.usesLookaheadPrefetching {
+            self.olderMessagesPrefetcher.scrollViewDidScroll(offsetY: scrollView.contentOffset.y,
+                                                             timestamp: CACurrentMediaTime())
+            self.prefetchOlderMessagesIfNeeded()
+        } else if self.shouldLoadMoreMessage() {
             self.loadMoreMessage()
         }
 
+        if self.shouldLoadNewerMessage() {
+            self.loadNewerMessage()
+        }
+
         // should automaticallyScrollsToMostRecentMessage when reach bottom
         let scrollViewHeight = scrollView.frame.size.height
         let scrollContentSizeHeight = scrollView.contentSize.height
@@ -1515,9 +1635,114 @@ extension SKYChatConversationViewController {
     }
 
     open func loadMoreMessage() {
+        if self.usesLookaheadPrefetching {
+            self.prefetchOlderMessagesIfNeeded()
+            return
+        }
+
         self.fetchMessages(before: self.firstSuccessMessage())
     }
 
+    // MARK: Lookahead Prefetching
+
+    /**
+     Requests older pages ahead of scrolling, and inserts a buffered page when the top of the
+     list is close enough.
+     */
+    open func prefetchOlderMessagesIfNeeded() {
+        guard !self.isFetchingMessage && self.hasMoreMessageToFetch,
+            let collectionView = self.collectionView else {
+            return
+        }
+
+        let prefetcher = self.olderMessagesPrefetcher
+        let distanceToTop = collectionView.contentOffset.y + collectionView.contentInset.top
+        prefetcher.prefetchIfNeeded(distanceToTop: distanceToTop,
+                                    oldestMessage: self.firstSuccessMessage())
+        if let page = prefetcher.dequeuePage(distanceToTop: distanceToTop) {
+            self.insertOlderMessages(page)
+        }
+
+        self.hasMoreMessageToFetch = prefetcher.hasMorePages || prefetcher.bufferedPageCount > 0
+    }
+
+    func prefetchedPageDidBecomeReady(_ page: SKYChatPrefetchedMessagePage) {
+        // build the view models now, so that inserting the page only lays it out
+        for message in page.messages {
+            _ = self.messageViewModelCache.messageData(for: message) { (msg) in
+                return self.buildMessageData(for: msg)
+            }
+        }
+
+        self.prefetchOlderMessagesIfNeeded()
+    }
+
+    /**
+     Inserts an older page above the messages being displayed, keeping them at the same
+     position on screen.
+     */
+    func insertOlderMessages(_ page: SKYChatPrefetchedMessagePage) {
+        let oldContentHeight = self.collectionView.contentSize.height
+        // the page has not been merged before, so all of its messages are merged
+        let hasChanges = self.applyFetchedMessages(page.messages,
+                                                   isCached: true,
+                                                   cachedMessages: [])
+
+        self.delegate?.conversationViewController?(
+            self,
+            didFetchMessages: page.messages,
+            isCached: !page.isFromServer
+        )
+
+        guard hasChanges else {
+            return
+        }
+
+        let offset = self.collectionView.contentOffset
+        self.reloadMessagesKeepingOffset()
+        let insertedHeight = self.collectionView.contentSize.height - oldContentHeight
+        self.olderMessagesPrefetcher.contentOffsetDidShift(by: insertedHeight)
+        self.collectionView.contentOffset = CGPoint(x: offset.x, y: offset.y + insertedHeight)
+    }
+
+    func reconcileInsertedPage(_ page: SKYChatPrefetchedMessagePage) {
+        let oldContentHeight = self.collectionView.contentSize.height
+        let hasChanges = self.applyFetchedMessages(page.messages,
+                                                   isCached: false,
+                                                   cachedMessages: page.cachedMessages)
+
+        self.delegate?.conversationViewController?(
+            self,
+            didFetchMessages: page.messages,
+            isCached: false
+        )
+
+        if hasChanges {
+            let offset = self.collectionView.contentOffset
+            self.reloadMessagesKeepingOffset()
+            let insertedHeight = self.collectionView.contentSize.height - oldContentHeight
+            self.olderMessagesPrefetcher.contentOffsetDidShift(by: insertedHeight)
+            self.collectionView.contentOffset = CGPoint(x: offset.x, y: offset.y + insertedHeight)
+        }
+    }
+
+    func shouldLoadNewerMessage() -> Bool {
+        guard !self.isFetchingMessage && self.hasNewerMessageToFetch else {
+            return false
+        }
+
+        let scrollView = self.collectionView!
+        let distanceToBottom = scrollView.contentSize.height
+            - scrollView.contentOffset.y - scrollView.frame.size.height
+        return distanceToBottom < self.offsetYToLoadMore
+    }
+
+    open func loadNewerMessage() {
+        if let cursor = self.newerMessagesCursor {
+            self.fetchMessages(after: cursor)
+        }
+    }
+
     open override func collectionView(_ collectionView: UICollectionView, canPerformAction action: Selector, forItemAt indexPath: IndexPath, withSender sender: Any?) -> Bool {
         let message = self.messageList.messageAt(indexPath.row)
         if self.messageError(message) == nil {
@@ -1543,6 +1768,7 @@ extension SKYChatConversationViewController {
     }
 
     @objc func resendFailedMessage(_ message: SKYMessage) {
+        self.messageViewModelCache.invalidate(messageID: message.recordName)
         self.messageList.remove([message])
         self.removeMessageError(message)
         self.beforeSending(message: message)
@@ -1562,6 +1788,7 @@ extension SKYChatConversationViewController {
                 }
 
                 let sentMsg = retriedMessage ?? message
+                SKYChatVoiceMessage.didSendRecording(of: message, sentMessage: retriedMessage)
                 self?.successfullySending(message: sentMsg)
             }
 
@@ -1581,6 +1808,7 @@ extension SKYChatConversationViewController {
     }
 
     @objc func deleteFailedMessage(_ message: SKYMessage) {
+        self.messageViewModelCache.invalidate(messageID: message.recordName)
         self.messageList.remove([message])
         self.collectionView.reloadData()
 
@@ -1595,6 +1823,7 @@ extension SKYChatConversationViewController {
 
                                                 self.removeMessageError(message)
                                                 ext?.cancel(messageOperation: operation)
+                                                SKYChatVoiceMessage.removeRecording(of: message)
         })
     }
 
@@ -1625,14 +1854,14 @@ extension SKYChatConversationViewController {
 
 extension SKYChatConversationViewController: CTAssetsPickerControllerDelegate {
     public func assetsPickerController(_ picker: CTAssetsPickerController!, didFinishPickingAssets assets: [Any]!) {
-        for asset in assets {
-            switch asset {
-            case let a as PHAsset:
-                self.send(asset: a)
-            default:
+        let photos = assets.flatMap { (asset) -> PHAsset? in
+            guard let photo = asset as? PHAsset else {
                 NSLog("Unknown asset type")
+                return nil
             }
+            return photo
         }
+        self.send(assets: photos)
         picker.dismiss(animated: true, completion: nil)
     }
 }
@@ -1678,6 +1907,111 @@ extension SKYChatConversationViewController {
         self.beforeSending(message: msg)
         self.send(message: msg)
     }
+
+    /**
+     Sends the photos together, in order. The photos are scaled and encoded at most
+     `maxConcurrentImageProcessing` at a time, and the messages are then sent in a batch.
+     Photos that cannot be loaded are reported as failed to send.
+     */
+    open func send(assets: [PHAsset]) {
+        guard assets.count > 1 else {
+            assets.first.map { self.send(asset: $0) }
+            return
+        }
+
+        guard self.conversation != nil else {
+            self.failedToSend(message: nil,
+                              errorCode: SKYErrorInvalidArgument,
+                              errorMessage: "Cannot send message to nil conversation")
+            return
+        }
+
+        let option = PHImageRequestOptions()
+        option.resizeMode = .fast
+        option.deliveryMode = .fastFormat
+        option.isSynchronous = true
+
+        let processingQueue = OperationQueue()
+        processingQueue.name = "io.skygear.chat.image-processing"
+        processingQueue.maxConcurrentOperationCount = max(1, self.maxConcurrentImageProcessing)
+
+        let lock = NSLock()
+        var messages = [SKYMessage?](repeating: nil, count: assets.count)
+        var failedCount = 0
+
+        // sends the messages on main queue once all photos are processed
+        let sendOperation = BlockOperation {
+            for _ in 0..<failedCount {
+                self.failedToSend(message: nil,
+                                  errorCode: SKYErrorResourceNotFound,
+                                  errorMessage: "Cannot load the photo")
+            }
+            self.send(messages: messages.flatMap { $0 })
+        }
+
+        for (index, asset) in assets.enumerated() {
+            let operation = BlockOperation {
+                var image: UIImage?
+                PHImageManager.default().requestImage(
+                    for: asset,
+                    targetSize: PHImageManagerMaximumSize,
+                    contentMode: .default,
+                    options: option,
+                    resultHandler: { (result, _) in
+                        image = result
+                })
+
+                guard let picked = image else {
+                    lock.lock()
+                    failedCount += 1
+                    lock.unlock()
+                    return
+                }
+
+                let msg = SKYMessage(withImage: picked)
+                lock.lock()
+                messages[index] = msg
+                lock.unlock()
+            }
+            sendOperation.addDependency(operation)
+            processingQueue.addOperation(operation)
+        }
+
+        OperationQueue.main.addOperation(sendOperation)
+    }
+
+    /**
+     Sends the messages in a batch, in order.
+     */
+    open func send(messages: [SKYMessage]) {
+        guard let conv = self.conversation, !messages.isEmpty else {
+            return
+        }
+
+        let date = Date()
+        for (index, msg) in messages.enumerated() {
+            msg.creatorUserRecordID = self.senderId
+            // keep the messages in the order they are sent
+            msg.creationDate = date.addingTimeInterval(TimeInterval(index) * 0.001)
+        }
+        self.beforeSending(messages: messages)
+
+        self.skygear.chatExtension?.addMessages(
+            messages,
+            to: conv,
+            completion: { (results, errorsByIndex) in
+                for (index, msg) in messages.enumerated() {
+                    if let error = errorsByIndex[NSNumber(value: index)] {
+                        print("Failed to send message: \(error.localizedDescription)")
+                        self.failedToSend(message: msg,
+                                          errorCode: SKYErrorBadResponse,
+                                          errorMessage: error.localizedDescription)
+                    } else if index < results.count {
+                        self.successfullySending(message: results[index])
+                    }
+                }
+        })
+    }
 }
 
 // MARK: - Audio
@@ -1685,22 +2019,16 @@ extension SKYChatConversationViewController {
 extension SKYChatConversationViewController {
     func startRecord() {
         print("Voice Recording: Start Recording")
-        let url = URL(fileURLWithPath: NSTemporaryDirectory()).appendingPathComponent("recording.m4a")
-        let settings = [
-            AVFormatIDKey: Int(kAudioFormatMPEG4AAC),
-            AVSampleRateKey: 44100,
-            AVNumberOfChannelsKey: 2,
-            AVEncoderAudioQualityKey: AVAudioQuality.high.rawValue
-        ]
+        let format = self.voiceMessageFormat
+        let url = SKYChatVoiceMessage.newRecordingURL(for: format)
+        let settings = SKYChatVoiceMessage.recordingSettings(for: format)
 
         DispatchQueue.global().async {
             do {
-                if (self.audioRecorder == nil) {
-                    self.audioRecorder = try AVAudioRecorder(url: url, settings: settings)
-                    self.audioRecorder?.delegate = self
-                    self.audioRecorder?.prepareToRecord()
-                }
-
+                // each recording goes to a new file, which is uploaded directly when sent
+                self.audioRecorder = try AVAudioRecorder(url: url, settings: settings)
+                self.audioRecorder?.delegate = self
+                self.audioRecorder?.prepareToRecord()
                 self.audioRecorder?.record()
             } catch {
                 // TODO: show dialog
@@ -1764,36 +2092,52 @@ extension SKYChatConversationViewController {
             if self.shouldShowVoiceMessageButton {
                 self.inputToolbarSendButtonState = .record
             }
+            try? FileManager.default.removeItem(at: recorder.url)
             return
         }
 
-        let asset: SKYAsset
-        do {
-            asset = SKYAsset(data: try Data(contentsOf: recorder.url))
-        } catch {
-            let alert = UIAlertController(
-                title: "Unable to send voice messaage",
-                message: "Failed to construct voice data",
-                preferredStyle: .alert)
-            alert.addAction(UIAlertAction(title: "OK",
-                                          style: .default,
-                                          handler: nil))
-            self.present(alert, animated: true, completion: nil)
+        let url = recorder.url
+        let length = Int((self.audioTime ?? recorder.currentTime) * 1000)
+        let mimeType = SKYChatVoiceMessage.mimeType(for: self.voiceMessageFormat)
 
-            return
-        }
+        // The recording is uploaded from its file, so only the waveform is read here.
+        DispatchQueue.global(qos: .userInitiated).async {
+            let waveform = SKYChatVoiceMessage.waveform(ofFileAt: url)
 
-        asset.mimeType = "audio/m4a"
+            DispatchQueue.main.async {
+                guard FileManager.default.fileExists(atPath: url.path) else {
+                    let alert = UIAlertController(
+                        title: "Unable to send voice messaage",
+                        message: "Failed to construct voice data",
+                        preferredStyle: .alert)
+                    alert.addAction(UIAlertAction(title: "OK",
+                                                  style: .default,
+                                                  handler: nil))
+                    self.present(alert, animated: true, completion: nil)
 
-        let msg = SKYMessage()
-        msg.body = ""
-        msg.metadata = ["length": Int(self.audioTime! * 1000)]
-        msg.attachment = asset
-        msg.creatorUserRecordID = self.senderId
-        msg.creationDate = Date()
+                    return
+                }
 
-        self.beforeSending(message: msg)
-        self.send(message: msg)
+                let asset = SKYAsset(fileURL: url)
+                asset.mimeType = mimeType
+
+                var metadata: [String: Any] = ["length": length]
+                if let waveform = waveform {
+                    metadata[SKYMessageMetadataWaveformAttributeName] =
+                        SKYChatVoiceMessage.metadataValue(for: waveform)
+                }
+
+                let msg = SKYMessage()
+                msg.body = ""
+                msg.metadata = metadata
+                msg.attachment = asset
+                msg.creatorUserRecordID = self.senderId
+                msg.creationDate = Date()
+
+                self.beforeSending(message: msg)
+                self.send(message: msg)
+            }
+        }
     }
 
     func didStopRecord(button: UIButton, cancelled: Bool = false) {
@@ -1851,31 +2195,29 @@ extension SKYChatConversationViewController {
             let msgID = msg.recordName
             let foundMessage = self.messageList.contains(msgID)
 
+            // the latest messages are added and updated by the cached messages query
+            let isCachedMessage = self.isUpdatedByCachedMessagesQuery(msgID)
+
             switch event {
             case .create:
                 self.delegate?.conversationViewController?(self, didReceiveMessage: msg)
 
-                if foundMessage {
-                    self.messageList.update([msg])
-                } else {
-                    self.messageList.append([msg])
-                }
-
                 self.skygear.chatExtension?.markReadMessages([msg], completion: nil)
                 self.skygear.chatExtension?.markLastReadMessage(msg,
                                                                 in: self.conversation!,
                                                                 completion: nil)
-                self.finishReceivingMessage()
             case .update:
                 self.delegate?.conversationViewController?(self, didUpdateMessage: msg)
-                if foundMessage {
+                if foundMessage && !isCachedMessage {
+                    self.messageViewModelCache.invalidate(messageID: msg.recordName)
                     self.messageList.update([msg])
                     self.collectionView.reloadData()
                     self.collectionView.layoutIfNeeded()
                 }
             case .delete:
                 self.delegate?.conversationViewController?(self, didDeleteMessage: msg)
-                if foundMessage {
+                if foundMessage && !isCachedMessage {
+                    self.messageViewModelCache.invalidate(messageID: msg.recordName)
                     self.messageList.remove([msg])
                     self.collectionView.reloadData()
                     self.collectionView.layoutIfNeeded()
@@ -1895,39 +2237,145 @@ extension SKYChatConversationViewController {
         }
     }
 
+    /**
+     Observes the latest cached messages, which keeps the latest messages in the list up to date
+     with the cache, including the messages fetched, received from pubsub and being sent.
+     */
+    open func observeCachedMessages() {
+        self.stopObservingCachedMessages()
+
+        guard let conversation = self.conversation else {
+            return
+        }
+
+        self.cachedMessagesQuery = self.skygear.chatExtension?.observeCachedMessages(
+            in: conversation,
+            limit: self.messagesFetchLimit,
+            handler: { [weak self] (messages, change) in
+                self?.applyCachedMessages(messages, change: change)
+        })
+    }
+
+    open func stopObservingCachedMessages() {
+        self.cachedMessagesQuery?.invalidate()
+        self.cachedMessagesQuery = nil
+        self.cachedMessages = []
+    }
+
+    /**
+     Observes the failed message operations, so that the messages failed to send, including those
+     of previous sessions, are shown with their errors.
+     */
+    open func observeUnsentMessages() {
+        self.stopObservingUnsentMessages()
+
+        guard let conversation = self.conversation else {
+            return
+        }
+
+        self.unsentMessagesQuery = self.skygear.chatExtension?.observeCachedMessageOperations(
+            in: conversation,
+            operationType: .add,
+            handler: { [weak self] (operations, _) in
+                self?.applyUnsentMessageOperations(operations)
+        })
+    }
+
+    open func stopObservingUnsentMessages() {
+        self.unsentMessagesQuery?.invalidate()
+        self.unsentMessagesQuery = nil
+    }
+
+    func isUpdatedByCachedMessagesQuery(_ messageID: String) -> Bool {
+        return !self.hasNewerMessageToFetch &&
+            self.cachedMessages.contains(where: { $0.recordName == messageID })
+    }
+
+    /**
+     Applies a delivery of the cached messages query to the message list.
+     */
+    func applyCachedMessages(_ messages: [SKYMessage], change: SKYChatCacheChange?) {
+        let previousMessages = self.cachedMessages
+        self.cachedMessages = messages
+
+        // The list does not reach the latest messages when the conversation is opened in the
+        // middle of its history, in which case they are fetched when scrolling down.
+        guard !self.hasNewerMessageToFetch else {
+            return
+        }
+
+        var changedMessages = messages
+        if let change = change {
+            changedMessages = change.insertions.union(change.modifications).map { messages[$0] }
+        }
+
+        // A message leaving a full result is either deleted, or pushed beyond the limit by newer
+        // messages, in which case it is older than the messages in the result and is kept.
+        let isFull = messages.count >= Int(self.messagesFetchLimit)
+        let oldestDate = messages.last?.creationDate
+        let messageIDs = Set(messages.map { $0.recordName })
+        let removedMessages = previousMessages.filter { (message) -> Bool in
+            guard !messageIDs.contains(message.recordName) else {
+                return false
+            }
+            guard isFull, let date = oldestDate else {
+                return true
+            }
+            return message.creationDate >= date
+        }
+
+        guard !changedMessages.isEmpty || !removedMessages.isEmpty else {
+            return
+        }
+
+        let messageList = self.messageList
+        for message in changedMessages + removedMessages {
+            self.messageViewModelCache.invalidate(messageID: message.recordName)
+        }
+        messageList.remove(removedMessages)
+
+        var newMessages: [SKYMessage] = []
+        for message in changedMessages {
+            if messageList.contains(message.recordName) {
+                messageList.update([message])
+            } else {
+                newMessages.append(message)
+            }
+        }
+
+        if !newMessages.isEmpty {
+            messageList.merge(newMessages)
+            self.finishReceivingMessage()
+        } else {
+            self.reloadMessagesKeepingOffset()
+        }
+    }
+
     open func subscribeTypingIndicatorChanges() {
 
         self.unsubscribeTypingIndicatorChanges()
 
-        let handler: ((SKYChatTypingIndicator) -> Void) = {(indicator) in
-            // invalidate the existing timer
-            if let timer = self.typingIndicatorPromptTimer {
-                timer.invalidate()
-                self.typingIndicatorPromptTimer = nil
+        // the typing participants are reported again when the typing event
+        // of a participant expires, so no timer is needed to hide the indicator
+        let handler: (([String]) -> Void) = { [weak self] (participantIDs) in
+            guard let strongSelf = self else {
+                return
             }
 
-            let shouldShowIndicator: Bool = indicator.participantIDs
+            let shouldShowIndicator: Bool = participantIDs
                 .flatMap({ SKYRecordID(canonicalString: $0).recordName })
-                .filter({ $0 != self.senderId })
+                .filter({ $0 != strongSelf.senderId })
                 .count > 0
 
             if shouldShowIndicator {
-                self.displayTypingIndicator()
-
-                // schedule a timer to hide the typing indicator
-                self.typingIndicatorPromptTimer =
-                    Timer.scheduledTimer(timeInterval: self.typingIndicatorShowDuration,
-                                         target: self,
-                                         selector: #selector(self.hideTypingIndicator),
-                                         userInfo: nil,
-                                         repeats: false)
+                strongSelf.displayTypingIndicator()
             } else {
-                self.hideTypingIndicator()
+                strongSelf.hideTypingIndicator()
             }
         }
 
         self.typingIndicatorChangeObserver = self.skygear.chatExtension?
-            .subscribeToTypingIndicator(in: self.conversation!, handler: handler)
+            .subscribeToTypingParticipants(in: self.conversation!, handler: handler)
     }
 
     open func unsubscribeTypingIndicatorChanges() {
@@ -1987,6 +2435,8 @@ extension SKYChatConversationViewController {
                         strongSelf, didFetchParticipants: participants.map { $0.value },
                         isCached: isCached)
 
+                    // sender names may have changed
+                    strongSelf.messageViewModelCache.invalidateAll()
                     strongSelf.collectionView?.reloadData()
                     strongSelf.collectionView?.layoutIfNeeded()
             })
@@ -2027,25 +2477,256 @@ extension SKYChatConversationViewController {
         chatExt?.fetchOutstandingMessageOperations(conversationID: self.conversation!.recordName,
                                                    operationType: SKYMessageOperationType.add,
                                                    completion: { (operations) in
-                                                    for operation in operations {
-                                                        guard operation.status == SKYMessageOperationStatus.failed else {
-                                                            continue
-                                                        }
-
-                                                        let error: Error = {
-                                                            if let err = operation.error {
-                                                                return err
-                                                            }
-                                                            return NSError(domain:"",
-                                                                           code:0,
-                                                                           userInfo: [
-                                                                            NSLocalizedDescriptionKey: "Error occurred sending message."
-                                                                           ]
-                                                            )
-                                                        }()
-                                                        self.setMessageError(operation.message, error: error)
-                                                    }
-                                                    self.finishReceivingMessage()
+                                                    self.applyUnsentMessageOperations(operations)
+        })
+    }
+
+    func applyUnsentMessageOperations(_ operations: [SKYMessageOperation]) {
+        let count = self.messageList.count
+        for operation in operations {
+            guard operation.status == SKYMessageOperationStatus.failed else {
+                continue
+            }
+
+            let error: Error = {
+                if let err = operation.error {
+                    return err
+                }
+                return NSError(domain:"",
+                               code:0,
+                               userInfo: [
+                                NSLocalizedDescriptionKey: "Error occurred sending message."
+                               ]
+                )
+            }()
+            self.setMessageError(operation.message, error: error)
+        }
+
+        if self.messageList.count != count {
+            self.finishReceivingMessage()
+        }
+    }
+
+    /**
+     Merges a fetched page into the message list, returning whether the list has changed.
+     */
+    func applyFetchedMessages(_ msgs: [SKYMessage],
+                              isCached: Bool,
+                              cachedMessages: [SKYMessage]) -> Bool {
+        // Apply only the difference between the cached page and the server page,
+        // so that nothing is relaid out when the server page is unchanged.
+        var hasChanges = true
+        if isCached {
+            self.messageList.merge(msgs)
+        } else {
+            let reconciliation = SKYChatMessagesReconciliation(
+                cachedMessages: cachedMessages,
+                serverMessages: msgs)
+            let messageList = self.messageList
+            for message in reconciliation.removedMessages + reconciliation.updatedMessages {
+                self.messageViewModelCache.invalidate(messageID: message.recordName)
+            }
+            messageList.remove(reconciliation.removedMessages)
+
+            var newMessages = reconciliation.insertedMessages
+            for message in reconciliation.updatedMessages {
+                if messageList.contains(message.recordName) {
+                    messageList.update([message])
+                } else {
+                    newMessages.append(message)
+                }
+            }
+            if !newMessages.isEmpty {
+                messageList.merge(newMessages)
+            }
+            hasChanges = reconciliation.hasChanges
+        }
+        // NOTE(cheungpat): Since we are fetching messages from
+        // the servers, these messages are assumed to be successful.
+        // Removing the failed operations because existence of
+        // a message operation is considered to be the message being
+        // failing.
+        for msg in msgs where self.messageErrorByIDs[msg.recordName] != nil {
+            self.removeMessageError(msg)
+            hasChanges = true
+        }
+
+        return hasChanges
+    }
+
+    /**
+     Reloads the messages without scrolling to the most recent message, which is what
+     finishReceivingMessage() does when the bottom of the list is displayed.
+     */
+    func reloadMessagesKeepingOffset() {
+        self.collectionView.collectionViewLayout.invalidateLayout(
+            with: JSQMessagesCollectionViewFlowLayoutInvalidationContext())
+        self.collectionView.reloadData()
+        self.collectionView.layoutIfNeeded()
+    }
+
+    /**
+     Fetches a page of messages around the specified message and scrolls to it. Older and newer
+     messages are then fetched while scrolling up and down.
+     */
+    open func fetchMessages(around messageID: String) {
+        guard let conversation = self.conversation else {
+            print("Cannot fetch messages with nil conversation")
+            return
+        }
+
+        if self.messageList.count == 0 {
+            self.indicator?.startAnimating()
+        }
+
+        let chatExt = self.skygear.chatExtension
+        self.isFetchingMessage = true
+        self.olderMessagesPrefetcher.reset()
+
+        let cachedResult = NSMutableArray()
+        let limit = Int(self.messagesFetchLimit)
+
+        self.delegate?.startFetchingMessages?(self)
+        chatExt?.fetchMessages(
+            conversationID: conversation.recordName,
+            limit: limit,
+            aroundMessageID: messageID,
+            order: nil,
+            completion: { [weak self] (result, isCached, error) in
+                guard let strongSelf = self else {
+                    return
+                }
+
+                strongSelf.indicator?.stopAnimating()
+                if !isCached {
+                    strongSelf.isFetchingMessage = false
+                }
+
+                guard error == nil, let msgs = result else {
+                    if !isCached {
+                        print("Failed to fetch messages: \(error?.localizedDescription ?? "")")
+                        strongSelf.delegate?.conversationViewController?(
+                            strongSelf, failedFetchingMessagesWithError: error ??
+                                strongSelf.errorCreator.error(
+                                    with: SKYErrorBadResponse,
+                                    message: "Failed to get any messages"))
+                    }
+                    return
+                }
+
+                if isCached {
+                    // nothing is cached around a message that is not cached itself
+                    guard !msgs.isEmpty else {
+                        return
+                    }
+                    cachedResult.addObjects(from: msgs)
+                }
+
+                let hasChanges = strongSelf.applyFetchedMessages(
+                    msgs,
+                    isCached: isCached,
+                    cachedMessages: cachedResult as? [SKYMessage] ?? [])
+
+                strongSelf.delegate?.conversationViewController?(
+                    strongSelf,
+                    didFetchMessages: msgs,
+                    isCached: isCached
+                )
+
+                // messages are in descending order, so the newest is the first one
+                let anchorIndex = msgs.index(where: { $0.recordName == messageID })
+                strongSelf.newerMessagesCursor = msgs.first
+                strongSelf.hasNewerMessageToFetch = (anchorIndex ?? limit) >= limit / 2
+                strongSelf.hasMoreMessageToFetch = true
+
+                if hasChanges {
+                    strongSelf.reloadMessagesKeepingOffset()
+                }
+
+                if let anchor = msgs.first(where: { $0.recordName == messageID }) {
+                    let index = strongSelf.messageList.indexOf(anchor)
+                    if index != NSNotFound {
+                        strongSelf.collectionView.scrollToItem(
+                            at: IndexPath(item: index, section: 0),
+                            at: .top,
+                            animated: false)
+                    }
+                }
+        })
+    }
+
+    /**
+     Fetches the page of messages newer than the specified message, when the conversation is
+     opened in the middle of its history.
+     */
+    open func fetchMessages(after: SKYMessage) {
+        guard let conversation = self.conversation else {
+            print("Cannot fetch messages with nil conversation")
+            return
+        }
+
+        let chatExt = self.skygear.chatExtension
+        self.isFetchingMessage = true
+
+        let cachedResult = NSMutableArray()
+        let limit = Int(self.messagesFetchLimit)
+
+        self.delegate?.startFetchingMessages?(self)
+        chatExt?.fetchMessages(
+            conversationID: conversation.recordName,
+            limit: limit,
+            afterMessageID: after.recordName,
+            order: nil,
+            completion: { [weak self] (result, isCached, error) in
+                guard let strongSelf = self else {
+                    return
+                }
+
+                if !isCached {
+                    strongSelf.isFetchingMessage = false
+                }
+
+                guard error == nil, let msgs = result else {
+                    if !isCached {
+                        print("Failed to fetch messages: \(error?.localizedDescription ?? "")")
+                        strongSelf.delegate?.conversationViewController?(
+                            strongSelf, failedFetchingMessagesWithError: error ??
+                                strongSelf.errorCreator.error(
+                                    with: SKYErrorBadResponse,
+                                    message: "Failed to get any messages"))
+                    }
+                    return
+                }
+
+                if isCached {
+                    cachedResult.addObjects(from: msgs)
+                }
+
+                let hasChanges = strongSelf.applyFetchedMessages(
+                    msgs,
+                    isCached: isCached,
+                    cachedMessages: cachedResult as? [SKYMessage] ?? [])
+
+                strongSelf.delegate?.conversationViewController?(
+                    strongSelf,
+                    didFetchMessages: msgs,
+                    isCached: isCached
+                )
+
+                if hasChanges {
+                    strongSelf.reloadMessagesKeepingOffset()
+                }
+
+                guard !isCached else {
+                    return
+                }
+
+                if let newest = msgs.first {
+                    strongSelf.newerMessagesCursor = newest
+                    chatExt?.markReadMessages(msgs, completion: nil)
+                    chatExt?.markLastReadMessage(newest, in: conversation, completion: nil)
+                }
+                strongSelf.hasNewerMessageToFetch = msgs.count >= limit
         })
     }
 
@@ -2061,9 +2742,16 @@ extension SKYChatConversationViewController {
 
         let chatExt = self.skygear.chatExtension
         self.isFetchingMessage = true
+        if before == nil {
+            self.olderMessagesPrefetcher.reset()
+        }
 
         let cachedResult = NSMutableArray()
 
+        // Measures the time until the first messages are shown, from either cache or server.
+        let firstMessageSpan = before == nil ?
+            SKYChatMetrics.sharedMetrics.beginSpan(name: "conversation.timeToFirstMessage") : nil
+
         self.delegate?.startFetchingMessages?(self)
         chatExt?.fetchMessages(
             conversation: self.conversation!,
@@ -2105,20 +2793,10 @@ extension SKYChatConversationViewController {
                     return
                 }
 
-                if !isCached {
-                    if let cachedMessages = cachedResult as? [SKYMessage] {
-                        strongSelf.messageList.remove(cachedMessages)
-                    }
-                }
-                strongSelf.messageList.merge(msgs)
-                // NOTE(cheungpat): Since we are fetching messages from
-                // the servers, these messages are assumed to be successful.
-                // Removing the failed operations because existence of
-                // a message operation is considered to be the message being
-                // failing.
-                for msg in msgs {
-                    strongSelf.removeMessageError(msg)
-                }
+                let hasChanges = strongSelf.applyFetchedMessages(
+                    msgs,
+                    isCached: isCached,
+                    cachedMessages: cachedResult as? [SKYMessage] ?? [])
 
                 strongSelf.delegate?.conversationViewController?(
                     strongSelf,
@@ -2126,23 +2804,29 @@ extension SKYChatConversationViewController {
                     isCached: isCached
                 )
 
-                strongSelf.finishReceivingMessage()
+                if !msgs.isEmpty || !isCached {
+                    firstMessageSpan?.end()
+                }
 
-                // force collection view layout
-                // to allow new content offset calculated
-                strongSelf.collectionView.layoutIfNeeded()
+                if hasChanges {
+                    strongSelf.finishReceivingMessage()
 
-                let fullFrameHeight =
-                    strongSelf.collectionView.contentSize.height
-                        - strongSelf.collectionView.frame.size.height
-                        + strongSelf.inputToolbarHeightConstraint.constant
+                    // force collection view layout
+                    // to allow new content offset calculated
+                    strongSelf.collectionView.layoutIfNeeded()
 
-                let additionalOffset = strongSelf.topContentAdditionalInset
-                let offsetY = max(
-                    min(fullFrameHeight, strongSelf.collectionView.contentOffset.y),
-                    -additionalOffset)
-                strongSelf.collectionView.contentOffset = CGPoint(x: 0, y: offsetY)
-                strongSelf.collectionView.flashScrollIndicators()
+                    let fullFrameHeight =
+                        strongSelf.collectionView.contentSize.height
+                            - strongSelf.collectionView.frame.size.height
+                            + strongSelf.inputToolbarHeightConstraint.constant
+
+                    let additionalOffset = strongSelf.topContentAdditionalInset
+                    let offsetY = max(
+                        min(fullFrameHeight, strongSelf.collectionView.contentOffset.y),
+                        -additionalOffset)
+                    strongSelf.collectionView.contentOffset = CGPoint(x: 0, y: offsetY)
+                    strongSelf.collectionView.flashScrollIndicators()
+                }
 
                 if !isCached {
                     if msgs.count > 0, let first = msgs.first {
@@ -0,0 +1,214 @@
+//
+//  SKYChatMessagePagePrefetcher.swift
+//  SKYKitChat
+//
+//  Copyright 2016 Oursky Ltd.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+import UIKit
+
+/**
+ A page of older messages fetched ahead of time, waiting to be inserted into the conversation.
+ */
+@objcMembers
+public class SKYChatPrefetchedMessagePage: NSObject {
+    /**
+     Messages of the page in descending order, from cache until the server page is fetched.
+     */
+    public internal(set) var messages: [SKYMessage]
+
+    /**
+     Messages of the page returned from cache, for reconciling them with the server page.
+     */
+    public internal(set) var cachedMessages: [SKYMessage] = []
+
+    public internal(set) var isFromServer: Bool = false
+
+    init(messages: [SKYMessage]) {
+        self.messages = messages
+    }
+}
+
+/**
+ SKYChatMessagePagePrefetcher fetches older pages of a conversation ahead of scrolling, so that
+ fast flings do not reach the top of the list and wait for the network.
+
+ Pages are requested when the top of the list is closer than the distance scrolled in
+ lookaheadDuration at the current velocity. Fetched pages are kept in a small buffer and handed
+ out for insertion when the top is closer than half of that distance. Each page is taken from
+ cache first and replaced by the server page when it arrives.
+ */
+@objcMembers
+open class SKYChatMessagePagePrefetcher: NSObject {
+    public typealias Completion = ([SKYMessage]?, Bool, Error?) -> Void
+    public typealias Fetcher =
+        (_ before: SKYMessage?, _ limit: Int, _ completion: @escaping Completion) -> Void
+
+    public let pageSize: Int
+    let fetcher: Fetcher
+
+    public var maxBufferedPages: Int = 2
+    public var lookaheadDuration: TimeInterval = 1.5
+    public var minimumLookaheadDistance: CGFloat = 400
+
+    /**
+     Called when a buffered page gets messages, so that their view models can be prepared and
+     the page inserted if the top is already reached.
+     */
+    public var pageDidBecomeReady: ((SKYChatPrefetchedMessagePage) -> Void)?
+
+    /**
+     Called when the server page arrives after its cached page has been handed out, with the
+     page updated to the server messages.
+     */
+    public var serverPageDidArriveAfterInsertion: ((SKYChatPrefetchedMessagePage) -> Void)?
+
+    /**
+     Scrolling velocity in points per second, which is negative when scrolling towards the top.
+     */
+    public private(set) var velocity: CGFloat = 0
+    public private(set) var hasMorePages: Bool = true
+    public private(set) var isFetching: Bool = false
+
+    var pages: [SKYChatPrefetchedMessagePage] = []
+    private var lastOffsetY: CGFloat?
+    private var lastTimestamp: TimeInterval = 0
+
+    // Incremented on reset, so that completions of earlier fetches are ignored.
+    private var generation: Int = 0
+
+    public init(pageSize: Int, fetcher: @escaping Fetcher) {
+        self.pageSize = pageSize
+        self.fetcher = fetcher
+    }
+
+    public var bufferedPageCount: Int {
+        return self.pages.filter { !$0.messages.isEmpty }.count
+    }
+
+    public var lookaheadDistance: CGFloat {
+        return max(self.minimumLookaheadDistance, -self.velocity * CGFloat(self.lookaheadDuration))
+    }
+
+    public var insertionDistance: CGFloat {
+        return max(self.minimumLookaheadDistance, self.lookaheadDistance / 2)
+    }
+
+    // MARK: - Scrolling
+
+    public func scrollViewDidScroll(offsetY: CGFloat, timestamp: TimeInterval) {
+        defer {
+            self.lastOffsetY = offsetY
+            self.lastTimestamp = timestamp
+        }
+
+        guard let lastOffsetY = self.lastOffsetY, timestamp > self.lastTimestamp else {
+            return
+        }
+
+        let instantVelocity = (offsetY - lastOffsetY) / CGFloat(timestamp - self.lastTimestamp)
+        // smoothed, since scroll events do not arrive at a steady rate
+        self.velocity = self.velocity * 0.5 + instantVelocity * 0.5
+    }
+
+    /**
+     Shifts the last offset by the distance the content offset is moved without scrolling, such
+     as when a page is inserted above, so that the move is not taken as velocity. This should be
+     called before the content offset is set.
+     */
+    public func contentOffsetDidShift(by deltaY: CGFloat) {
+        if let lastOffsetY = self.lastOffsetY {
+            self.lastOffsetY = lastOffsetY + deltaY
+        }
+    }
+
+    /**
+     Requests the next older page if the top is within the lookahead distance and the buffer is
+     not full. The oldest message shown in the list is the cursor when nothing is buffered.
+     */
+    public func prefetchIfNeeded(distanceToTop: CGFloat, oldestMessage: SKYMessage?) {
+        guard self.hasMorePages, !self.isFetching,
+            self.pages.count < self.maxBufferedPages,
+            distanceToTop < self.lookaheadDistance else {
+            return
+        }
+
+        let cursor = self.pages.last?.messages.last ?? oldestMessage
+        let page = SKYChatPrefetchedMessagePage(messages: [])
+        let generation = self.generation
+        self.pages.append(page)
+        self.isFetching = true
+
+        self.fetcher(cursor, self.pageSize) { [weak self] (result, isCached, error) in
+            guard let strongSelf = self, strongSelf.generation == generation else {
+                return
+            }
+
+            if isCached {
+                page.cachedMessages = result ?? []
+                if page.messages.isEmpty, !page.cachedMessages.isEmpty {
+                    page.messages = page.cachedMessages
+                    strongSelf.pageDidBecomeReady?(page)
+                }
+                return
+            }
+
+            strongSelf.isFetching = false
+            guard error == nil, let messages = result else {
+                // drop the page if nothing is cached, so that it is requested again
+                if page.messages.isEmpty, let index = strongSelf.pages.index(of: page) {
+                    strongSelf.pages.remove(at: index)
+                }
+                return
+            }
+
+            strongSelf.hasMorePages = messages.count >= strongSelf.pageSize
+            let isBuffered = strongSelf.pages.contains(page)
+            page.messages = messages
+            page.isFromServer = true
+
+            if !isBuffered {
+                strongSelf.serverPageDidArriveAfterInsertion?(page)
+            } else if messages.isEmpty, let index = strongSelf.pages.index(of: page) {
+                strongSelf.pages.remove(at: index)
+            } else {
+                strongSelf.pageDidBecomeReady?(page)
+            }
+        }
+    }
+
+    /**
+     Hands out the oldest buffered page that has messages if the top is within the insertion
+     distance.
+     */
+    public func dequeuePage(distanceToTop: CGFloat) -> SKYChatPrefetchedMessagePage? {
+        guard distanceToTop < self.insertionDistance,
+            let page = self.pages.first, !page.messages.isEmpty else {
+            return nil
+        }
+
+        self.pages.removeFirst()
+        return page
+    }
+
+    public func reset() {
+        self.generation += 1
+        self.pages.removeAll()
+        self.isFetching = false
+        self.hasMorePages = true
+        self.velocity = 0
+        self.lastOffsetY = nil
+    }
+}
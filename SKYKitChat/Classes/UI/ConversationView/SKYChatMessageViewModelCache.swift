@@ -0,0 +1,89 @@
+//
+//  SKYChatMessageViewModelCache.swift
+//  SKYKitChat
+//
+//  Copyright 2016 Oursky Ltd.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+import JSQMessagesViewController
+import LruCache
+
+/**
+ SKYChatMessageViewModelCache keeps the JSQMessage built for each message, including its media
+ item, so that it is not rebuilt every time the collection view asks for the message data.
+
+ A cached JSQMessage is reused only for the same revision of the message, which is identified by
+ the message ID, edit date, modification date and delivery status.
+ */
+@objcMembers
+open class SKYChatMessageViewModelCache: NSObject {
+
+    // MARK: - Entry
+
+    class Entry: NSObject {
+        let revision: String
+        let messageData: JSQMessage
+
+        init(revision: String, messageData: JSQMessage) {
+            self.revision = revision
+            self.messageData = messageData
+        }
+    }
+
+    let store: LruCache
+
+    public init(maxCount: Int) {
+        self.store = LruCache(maxSize: maxCount)
+    }
+
+    public convenience override init() {
+        self.init(maxCount: 200)
+    }
+
+    // MARK: - Lookup
+
+    open func revision(of message: SKYMessage) -> String {
+        let editedAt = (message.record["edited_at"] as? Date)?.timeIntervalSince1970 ?? 0
+        let updatedAt = message.record.modificationDate?.timeIntervalSince1970 ?? 0
+        return "\(editedAt)|\(updatedAt)|\(message.conversationStatus.rawValue)|\(message.deleted)"
+    }
+
+    /**
+     Returns the cached message data of the message, calling the builder to build one if the
+     message is not cached or its revision has changed.
+     */
+    open func messageData(for message: SKYMessage,
+                          builder: (SKYMessage) -> JSQMessage) -> JSQMessage {
+        let messageID = message.recordName
+        let revision = self.revision(of: message)
+        if let entry = self.store.get(messageID) as? Entry, entry.revision == revision {
+            return entry.messageData
+        }
+
+        let messageData = builder(message)
+        self.store.put(messageID, value: Entry(revision: revision, messageData: messageData))
+        return messageData
+    }
+
+    // MARK: - Invalidation
+
+    open func invalidate(messageID: String) {
+        self.store.remove(messageID)
+    }
+
+    open func invalidateAll() {
+        self.store.evictAll()
+    }
+}
@@ -0,0 +1,257 @@
+//
+//  SKYChatVoiceMessage.swift
+//  SKYKitChat
+//
+//  Copyright 2016 Oursky Ltd.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+import AVFoundation
+
+let SKYMessageMetadataWaveformAttributeName = "waveform"
+
+@objc public enum SKYChatVoiceMessageFormat: Int {
+    /**
+     Mono AAC in an m4a container, playable on all platforms.
+     */
+    case aac
+
+    /**
+     Mono Opus in a caf container, which is smaller for speech. Only available on iOS 11 or
+     later, falling back to AAC on earlier versions.
+     */
+    case opus
+}
+
+/**
+ SKYChatVoiceMessage provides the recording settings of voice messages and computes the
+ waveform of a recording.
+ */
+@objcMembers
+public class SKYChatVoiceMessage: NSObject {
+
+    // MARK: - Recording Settings
+
+    static func effectiveFormat(_ format: SKYChatVoiceMessageFormat) -> SKYChatVoiceMessageFormat {
+        if format == .opus {
+            if #available(iOS 11.0, *) {
+                return .opus
+            }
+        }
+
+        return .aac
+    }
+
+    /**
+     Recorder settings tuned for speech: mono, a low sample rate and a low bit rate.
+     */
+    public static func recordingSettings(for format: SKYChatVoiceMessageFormat) -> [String: Any] {
+        switch self.effectiveFormat(format) {
+        case .opus:
+            return [
+                AVFormatIDKey: Int(kAudioFormatOpus),
+                AVSampleRateKey: 16000,
+                AVNumberOfChannelsKey: 1,
+                AVEncoderBitRateKey: 24000
+            ]
+        case .aac:
+            return [
+                AVFormatIDKey: Int(kAudioFormatMPEG4AAC),
+                AVSampleRateKey: 22050,
+                AVNumberOfChannelsKey: 1,
+                AVEncoderBitRateKey: 32000,
+                AVEncoderAudioQualityKey: AVAudioQuality.medium.rawValue
+            ]
+        }
+    }
+
+    public static func fileExtension(for format: SKYChatVoiceMessageFormat) -> String {
+        switch self.effectiveFormat(format) {
+        case .opus:
+            return "caf"
+        case .aac:
+            return "m4a"
+        }
+    }
+
+    public static func mimeType(for format: SKYChatVoiceMessageFormat) -> String {
+        switch self.effectiveFormat(format) {
+        case .opus:
+            return "audio/x-caf"
+        case .aac:
+            return "audio/m4a"
+        }
+    }
+
+    static var recordingsDirectoryURL: URL {
+        return URL(fileURLWithPath: NSTemporaryDirectory())
+            .appendingPathComponent("SKYKitChat/Recordings")
+    }
+
+    /**
+     Returns a new file URL for a recording, so that a recording being uploaded is not
+     overwritten by the next one.
+     */
+    public static func newRecordingURL(for format: SKYChatVoiceMessageFormat) -> URL {
+        let directoryURL = self.recordingsDirectoryURL
+        try? FileManager.default.createDirectory(at: directoryURL,
+                                                 withIntermediateDirectories: true,
+                                                 attributes: nil)
+        return directoryURL
+            .appendingPathComponent(UUID().uuidString)
+            .appendingPathExtension(self.fileExtension(for: format))
+    }
+
+    // MARK: - Recording Files
+
+    static func recordingURL(of message: SKYMessage) -> URL? {
+        guard let url = message.attachment?.url, url.isFileURL else {
+            return nil
+        }
+
+        let directoryURL = self.recordingsDirectoryURL.standardizedFileURL
+        guard url.standardizedFileURL.deletingLastPathComponent() == directoryURL else {
+            return nil
+        }
+
+        return url
+    }
+
+    /**
+     Moves the recording of a sent voice message into the asset disk cache, as the data of the
+     uploaded attachment, so that the recording is neither left in the temporary directory
+     nor downloaded again. Does nothing if the message was not recorded by this device.
+     */
+    public static func didSendRecording(of message: SKYMessage, sentMessage: SKYMessage?) {
+        guard let url = self.recordingURL(of: message) else {
+            return
+        }
+
+        if let asset = sentMessage?.attachment, !asset.url.isFileURL {
+            SKYAssetDiskCache.shared().set(fileAt: url, for: asset)
+        }
+        try? FileManager.default.removeItem(at: url)
+    }
+
+    /**
+     Deletes the recording of a voice message that is not going to be sent.
+     */
+    public static func removeRecording(of message: SKYMessage) {
+        guard let url = self.recordingURL(of: message) else {
+            return
+        }
+
+        try? FileManager.default.removeItem(at: url)
+    }
+
+    // MARK: - Waveform
+
+    /**
+     Computes the peak level of each of the specified number of equal slices of the audio
+     file, scaled to 0...255. Returns nil if the file cannot be read.
+
+     The file is read sequentially as 16-bit PCM, so this should be called in background.
+     */
+    public static func waveform(ofFileAt url: URL,
+                                levelCount: Int = 64) -> [UInt8]? {
+        let asset = AVURLAsset(url: url)
+        guard levelCount > 0,
+            let track = asset.tracks(withMediaType: AVMediaType.audio).first,
+            let reader = try? AVAssetReader(asset: asset) else {
+            return nil
+        }
+
+        let sampleRate = 8000.0
+        let output = AVAssetReaderTrackOutput(track: track, outputSettings: [
+            AVFormatIDKey: Int(kAudioFormatLinearPCM),
+            AVSampleRateKey: sampleRate,
+            AVNumberOfChannelsKey: 1,
+            AVLinearPCMBitDepthKey: 16,
+            AVLinearPCMIsFloatKey: false,
+            AVLinearPCMIsBigEndianKey: false,
+            AVLinearPCMIsNonInterleaved: false
+        ])
+        output.alwaysCopiesSampleData = false
+        guard reader.canAdd(output) else {
+            return nil
+        }
+        reader.add(output)
+
+        let totalSamples = max(1, Int(CMTimeGetSeconds(asset.duration) * sampleRate))
+        let samplesPerLevel = max(1, totalSamples / levelCount)
+        var levels = [UInt8]()
+        var peak: Int32 = 0
+        var sampleCount = 0
+
+        reader.startReading()
+        while reader.status == .reading, let sampleBuffer = output.copyNextSampleBuffer() {
+            guard let blockBuffer = CMSampleBufferGetDataBuffer(sampleBuffer) else {
+                continue
+            }
+
+            let length = CMBlockBufferGetDataLength(blockBuffer)
+            var samples = [Int16](repeating: 0, count: length / 2)
+            CMBlockBufferCopyDataBytes(blockBuffer, 0, samples.count * 2, &samples)
+
+            for sample in samples {
+                peak = max(peak, abs(Int32(sample)))
+                sampleCount += 1
+                if sampleCount == samplesPerLevel {
+                    levels.append(UInt8(min(255, peak * 255 / Int32(Int16.max))))
+                    peak = 0
+                    sampleCount = 0
+                }
+            }
+        }
+
+        if sampleCount > 0 {
+            levels.append(UInt8(min(255, peak * 255 / Int32(Int16.max))))
+        }
+
+        guard reader.status == .completed, !levels.isEmpty else {
+            return nil
+        }
+
+        return self.resample(levels: levels, count: levelCount)
+    }
+
+    /**
+     Encodes the waveform for message metadata.
+     */
+    public static func metadataValue(for waveform: [UInt8]) -> String {
+        return Data(waveform).base64EncodedString()
+    }
+
+    /**
+     Returns the waveform stored in the metadata of a voice message, if any.
+     */
+    public static func waveform(for message: SKYMessage) -> [UInt8]? {
+        guard let value = message.metadata?[SKYMessageMetadataWaveformAttributeName] as? String,
+            let data = Data(base64Encoded: value) else {
+            return nil
+        }
+
+        return [UInt8](data)
+    }
+
+    static func resample(levels: [UInt8], count: Int) -> [UInt8] {
+        if levels.count == count {
+            return levels
+        }
+
+        return (0..<count).map { index in
+            levels[min(levels.count - 1, index * levels.count / count)]
+        }
+    }
+}
@@ -0,0 +1,71 @@
+//
+//  SKYChatVoiceWaveformView.swift
+//  SKYKitChat
+//
+//  Copyright 2016 Oursky Ltd.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+import UIKit
+
+/**
+ Draws the waveform of a voice message as bars rising from the bottom of the view, one bar for
+ each level, which is scaled from 0...255 to the height of the view.
+ */
+class SKYChatVoiceWaveformView: UIView {
+
+    var levels: [UInt8] = [] {
+        didSet {
+            self.setNeedsDisplay()
+        }
+    }
+
+    var barColor: UIColor = UIColor.gray {
+        didSet {
+            self.setNeedsDisplay()
+        }
+    }
+
+    override init(frame: CGRect) {
+        super.init(frame: frame)
+        self.isOpaque = false
+        self.backgroundColor = UIColor.clear
+        self.isUserInteractionEnabled = false
+        self.contentMode = .redraw
+    }
+
+    required init?(coder aDecoder: NSCoder) {
+        fatalError("init(coder:) has not been implemented")
+    }
+
+    override func draw(_ rect: CGRect) {
+        guard !self.levels.isEmpty, let context = UIGraphicsGetCurrentContext() else {
+            return
+        }
+
+        let bounds = self.bounds
+        let slotWidth = bounds.width / CGFloat(self.levels.count)
+        let barWidth = max(1, slotWidth * 0.6)
+
+        context.setFillColor(self.barColor.cgColor)
+        for (index, level) in self.levels.enumerated() {
+            // keep silent parts visible as a flat line
+            let height = max(1, bounds.height * CGFloat(level) / 255)
+            context.fill(CGRect(x: bounds.minX + CGFloat(index) * slotWidth,
+                                y: bounds.maxY - height,
+                                width: barWidth,
+                                height: height))
+        }
+    }
+}
@@ -73,7 +73,24 @@ open class SKYChatParticipantListViewController: UIViewController {
     @IBOutlet public var searchBar: UISearchBar!
     @IBOutlet public var tableView: UITableView!
 
+    /*
+      Number of users fetched per page. Further pages are fetched when the user
+      scrolls near the end of the list.
+     */
+    public var pageSize: Int = 50
+
+    /*
+      Delay before a search is performed while the user is typing.
+     */
+    public var searchDebounceInterval: TimeInterval = 0.3
+
     var participants: [SKYRecord] = []
+    var nextOffset: Int = 0
+    var hasMoreParticipants: Bool = true
+    var isFetchingParticipants: Bool = false
+    var hasFailedFetchingParticipants: Bool = false
+    var queryGeneration: Int = 0
+    var searchDebounceTimer: Timer?
 
 }
 
@@ -132,6 +149,13 @@ extension SKYChatParticipantListViewController {
         self.searchBar.becomeFirstResponder()
     }
 
+    open override func viewWillDisappear(_ animated: Bool) {
+        super.viewWillDisappear(animated)
+
+        self.searchDebounceTimer?.invalidate()
+        self.searchDebounceTimer = nil
+    }
+
     func dismiss(animated: Bool) {
         if let nc = self.navigationController, let topVC = nc.topViewController {
             guard self == topVC else {
@@ -204,30 +228,62 @@ extension SKYChatParticipantListViewController: UITableViewDelegate, UITableView
         return CGFloat(62)
     }
 
+    open func tableView(_ tableView: UITableView,
+                        willDisplay cell: UITableViewCell,
+                        forRowAt indexPath: IndexPath) {
+        // start fetching the next page when the last few rows are displayed
+        if indexPath.row >= self.participants.count - max(self.pageSize / 5, 1) {
+            self.performNextPageUserQuery()
+        }
+    }
+
 }
 
 // MARK: - UISearchBarDelegate
 
 extension SKYChatParticipantListViewController: UISearchBarDelegate {
 
-    public func searchBarSearchButtonClicked(_ searchBar: UISearchBar) {
-        if let text = searchBar.text {
-            if text.characters.count > 0 {
-                self.searchTerm = text
-            } else {
-                self.searchTerm = nil
-            }
-        } else {
-            self.searchTerm = nil
-        }
+    public func searchBar(_ searchBar: UISearchBar, textDidChange searchText: String) {
+        self.searchDebounceTimer?.invalidate()
+        self.searchDebounceTimer = Timer.scheduledTimer(timeInterval: self.searchDebounceInterval,
+                                                        target: self,
+                                                        selector: #selector(handleSearchDebounceTimer),
+                                                        userInfo: nil,
+                                                        repeats: false)
+    }
 
-        self.performUserQuery()
+    @objc func handleSearchDebounceTimer() {
+        self.searchDebounceTimer = nil
+        self.performSearch(withText: self.searchBar.text, showProgress: false)
+    }
+
+    public func searchBarSearchButtonClicked(_ searchBar: UISearchBar) {
+        self.searchDebounceTimer?.invalidate()
+        self.searchDebounceTimer = nil
+        self.performSearch(withText: searchBar.text, showProgress: true)
     }
 
     public func searchBarCancelButtonClicked(_ searchBar: UISearchBar) {
+        self.searchDebounceTimer?.invalidate()
+        self.searchDebounceTimer = nil
         self.searchTerm = nil
 
     }
+
+    func performSearch(withText text: String?, showProgress: Bool) {
+        var term: String? = nil
+        if let text = text, text.characters.count > 0 {
+            term = text
+        }
+
+        if term == self.searchTerm && !self.participants.isEmpty {
+            // the result of the same term is already shown
+            return
+        }
+
+        self.searchTerm = term
+        self.performUserQuery(showProgress: showProgress)
+    }
 }
 
 // MARK: - Utility Methods
@@ -276,19 +332,30 @@ extension SKYChatParticipantListViewController {
         return participantInfo
     }
 
-    var queryPredicate: NSPredicate? {
-        var keyword = ""
+    var queryKey: String {
         switch self.queryMethod {
         case .byEmail:
-            keyword = "email"
-            break
+            return "email"
         case .byUsername:
-            keyword = "username"
-            break
+            return "username"
         case .byName:
-            keyword = "name"
-            break
+            return "name"
         }
+    }
+
+    /*
+      Users are sorted by the queried key and then by ID, so that pages
+      fetched by offset do not overlap or skip users.
+     */
+    var querySortDescriptors: [NSSortDescriptor] {
+        return [
+            NSSortDescriptor(key: self.queryKey, ascending: true),
+            NSSortDescriptor(key: "_id", ascending: true)
+        ]
+    }
+
+    var queryPredicate: NSPredicate? {
+        let keyword = self.queryKey
 
         var predicate: NSPredicate
         if let term = self.searchTerm {
@@ -305,37 +372,114 @@ extension SKYChatParticipantListViewController {
     }
 
     open func performUserQuery() {
-        let predicate = self.queryPredicate
+        self.performUserQuery(showProgress: true)
+    }
 
-        guard predicate != nil else {
-            self.participants = []
-            self.tableView.reloadData()
+    /*
+      Discard loaded participants and query the first page of users matching
+      the current search term.
+     */
+    open func performUserQuery(showProgress: Bool) {
+        self.queryGeneration += 1
+        self.participants = []
+        self.nextOffset = 0
+        self.hasMoreParticipants = true
+        self.isFetchingParticipants = false
+        self.hasFailedFetchingParticipants = false
+        self.tableView.reloadData()
+
+        self.performUserQuery(offset: 0, showProgress: showProgress)
+    }
+
+    /*
+      Query the next page of users, if there are more users to be loaded and
+      no query is in progress. After a page fails to load, nothing is queried
+      until retryNextPageUserQuery() is called.
+     */
+    open func performNextPageUserQuery() {
+        guard self.hasMoreParticipants, !self.isFetchingParticipants,
+            !self.hasFailedFetchingParticipants, !self.participants.isEmpty else {
+            return
+        }
+
+        self.performUserQuery(offset: self.nextOffset, showProgress: false)
+    }
+
+    /*
+      Query the page of users that failed to load again.
+     */
+    open func retryNextPageUserQuery() {
+        self.hasFailedFetchingParticipants = false
+        self.performNextPageUserQuery()
+    }
+
+    func performUserQuery(offset: Int, showProgress: Bool) {
+        guard let predicate = self.queryPredicate else {
+            self.hasMoreParticipants = false
             return
         }
 
-        let query = SKYQuery(recordType: "user", predicate: self.queryPredicate)
+        let query = SKYQuery(recordType: "user", predicate: predicate)
+        query.limit = self.pageSize
+        query.offset = offset
+        query.sortDescriptors = self.querySortDescriptors
 
-        SVProgressHUD.show()
-        self.skygear.publicCloudDatabase.perform(query, completionHandler: { (result, error) in
-            SVProgressHUD.dismiss()
+        let generation = self.queryGeneration
+        self.isFetchingParticipants = true
+        if showProgress {
+            SVProgressHUD.show()
+        }
+        self.skygear.publicCloudDatabase.perform(query, completionHandler: { [weak self] (result, error) in
+            if showProgress {
+                SVProgressHUD.dismiss()
+            }
+
+            guard let strongSelf = self, generation == strongSelf.queryGeneration else {
+                // the search term has been changed, discard the stale result
+                return
+            }
+
+            strongSelf.isFetchingParticipants = false
             if let err = error {
-                self.handleQueryError(error: err)
+                strongSelf.hasFailedFetchingParticipants = true
+                strongSelf.handleQueryError(error: err)
                 return
             }
 
             if let r = result as? [SKYRecord] {
-                self.handleQueryResult(result: r)
+                strongSelf.nextOffset = offset + r.count
+                strongSelf.hasMoreParticipants = r.count >= strongSelf.pageSize
+                strongSelf.handleQueryResult(result: r)
             } else {
                 let err = SKYErrorCreator().error(with: SKYErrorBadResponse,
                                                   message: "Query does not response SKYRecord")
-                self.handleQueryError(error: err)
+                strongSelf.hasFailedFetchingParticipants = true
+                strongSelf.handleQueryError(error: err)
             }
         })
     }
 
+    /*
+      Append a page of query result to the list.
+     */
     open func handleQueryResult(result: [SKYRecord]) {
-        self.participants = result
-        self.tableView.reloadData()
+        let existingIDs = Set(self.participants.map { $0.recordID.recordName })
+        let newParticipants = result.filter { !existingIDs.contains($0.recordID.recordName) }
+        guard newParticipants.count > 0 else {
+            return
+        }
+
+        let startIndex = self.participants.count
+        self.participants.append(contentsOf: newParticipants)
+
+        if startIndex == 0 {
+            self.tableView.reloadData()
+        } else {
+            let indexPaths = (startIndex..<self.participants.count).map {
+                IndexPath(row: $0, section: 0)
+            }
+            self.tableView.insertRows(at: indexPaths, with: .none)
+        }
     }
 
     open func handleQueryError(error: Error) {
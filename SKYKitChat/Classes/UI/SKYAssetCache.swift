@@ -63,3 +63,74 @@ public class SKYAssetMemoryCache: SKYAssetCache {
         self.store.purgeAll()
     }
 }
+
+/**
+ SKYAssetDiskCache keeps asset data as files in the caches directory. Data returned from the
+ cache is memory mapped, so large assets such as voice notes do not stay resident in memory.
+ */
+@objcMembers
+public class SKYAssetDiskCache: SKYAssetCache {
+    let directoryURL: URL
+
+    private static var sharedInstance: SKYAssetDiskCache?
+
+    static func shared() -> SKYAssetDiskCache {
+        if self.sharedInstance == nil {
+            let cachesURL = FileManager.default.urls(for: .cachesDirectory, in: .userDomainMask)[0]
+            let directoryURL = cachesURL.appendingPathComponent("SKYKitChat/Assets")
+            self.sharedInstance = SKYAssetDiskCache(directoryURL: directoryURL)
+        }
+
+        return self.sharedInstance!
+    }
+
+    public init(directoryURL: URL) {
+        self.directoryURL = directoryURL
+        try? FileManager.default.createDirectory(at: directoryURL,
+                                                 withIntermediateDirectories: true,
+                                                 attributes: nil)
+    }
+
+    /**
+     Returns the URL of the cached file of the asset. The file may not exist.
+     */
+    public func fileURL(for asset: SKYAsset) -> URL {
+        return self.directoryURL.appendingPathComponent(asset.name)
+    }
+
+    /**
+     Returns the URL of the file holding data of the asset while it is being downloaded.
+     */
+    public func partialFileURL(for asset: SKYAsset) -> URL {
+        return self.directoryURL.appendingPathComponent(asset.name + ".download")
+    }
+
+    /**
+     Moves a fully downloaded file into the cache.
+     */
+    public func set(fileAt url: URL, for asset: SKYAsset) {
+        let destinationURL = self.fileURL(for: asset)
+        try? FileManager.default.removeItem(at: destinationURL)
+        try? FileManager.default.moveItem(at: url, to: destinationURL)
+    }
+
+    public func get(asset: SKYAsset) -> Data? {
+        return try? Data(contentsOf: self.fileURL(for: asset), options: .alwaysMapped)
+    }
+
+    public func set(data: Data, for asset: SKYAsset) {
+        try? data.write(to: self.fileURL(for: asset), options: .atomic)
+    }
+
+    public func purge(asset: SKYAsset) {
+        try? FileManager.default.removeItem(at: self.fileURL(for: asset))
+        try? FileManager.default.removeItem(at: self.partialFileURL(for: asset))
+    }
+
+    public func purgeAll() {
+        try? FileManager.default.removeItem(at: self.directoryURL)
+        try? FileManager.default.createDirectory(at: self.directoryURL,
+                                                 withIntermediateDirectories: true,
+                                                 attributes: nil)
+    }
+}
@@ -0,0 +1,197 @@
+//
+//  SKYChatAvatarImageCache.swift
+//  SKYKitChat
+//
+//  Copyright 2016 Oursky Ltd.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+import ImageIO
+import UIKit
+
+/**
+ SKYChatAvatarImageCache downloads remote avatars, decodes them downsampled to the avatar
+ diameter in background, and keeps the decoded images in memory keyed by user ID.
+
+ Completion handlers are called with the user ID, so that callers can update every view
+ showing the avatar of the user at once.
+ */
+@objcMembers
+public class SKYChatAvatarImageCache: NSObject {
+
+    private class Entry {
+        let source: String
+        let image: UIImage
+
+        init(source: String, image: UIImage) {
+            self.source = source
+            self.image = image
+        }
+    }
+
+    private static var sharedInstance: SKYChatAvatarImageCache?
+
+    static func shared() -> SKYChatAvatarImageCache {
+        if self.sharedInstance == nil {
+            self.sharedInstance = SKYChatAvatarImageCache(scale: UIScreen.main.scale)
+        }
+
+        return self.sharedInstance!
+    }
+
+    let scale: CGFloat
+    let downloadDispatcher = SimpleDownloadDispatcher.default()
+    let decodeQueue = DispatchQueue(label: "io.skygear.chat.avatar-decode", qos: .userInitiated)
+    private let store = NSCache<NSString, Entry>()
+
+    // Completion handlers of loads in progress keyed by user ID, accessed on main thread only.
+    private var pendingCompletions = [String: [(String) -> Void]]()
+
+    public init(scale: CGFloat) {
+        self.scale = scale
+        super.init()
+        self.store.countLimit = 200
+    }
+
+    // MARK: - Avatars
+
+    /**
+     Returns the decoded avatar of the user if it is cached for the specified URL.
+     */
+    public func cachedAvatar(forUserID userID: String, url: URL) -> UIImage? {
+        guard let entry = self.store.object(forKey: userID as NSString),
+            entry.source == url.absoluteString else {
+            return nil
+        }
+
+        return entry.image
+    }
+
+    /**
+     Returns the cached avatar of the user, or returns nil and loads the avatar from the URL.
+     The completion is called on main thread with the user ID once the avatar is cached.
+     Concurrent requests for the same user share a single load.
+
+     Data found in the data cache is used instead of downloading it again.
+     */
+    public func avatar(forUserID userID: String,
+                       url: URL,
+                       diameter: CGFloat,
+                       dataCache: DataCache?,
+                       completion: @escaping (String) -> Void) -> UIImage? {
+        if let image = self.cachedAvatar(forUserID: userID, url: url) {
+            return image
+        }
+
+        self.load(userID: userID, url: url, diameter: diameter, completion: completion) {
+            return dataCache?.getData(forKey: url.absoluteString)
+        }
+        return nil
+    }
+
+    /**
+     Same as avatar(forUserID:url:diameter:dataCache:completion:) for an avatar stored as an
+     asset.
+     */
+    public func avatar(forUserID userID: String,
+                       asset: SKYAsset,
+                       diameter: CGFloat,
+                       assetCache: SKYAssetCache?,
+                       completion: @escaping (String) -> Void) -> UIImage? {
+        if let image = self.cachedAvatar(forUserID: userID, url: asset.url) {
+            return image
+        }
+
+        self.load(userID: userID, url: asset.url, diameter: diameter, completion: completion) {
+            return assetCache?.get(asset: asset)
+        }
+        return nil
+    }
+
+    public func purge(userID: String) {
+        self.store.removeObject(forKey: userID as NSString)
+    }
+
+    public func purgeAll() {
+        self.store.removeAllObjects()
+    }
+
+    // MARK: - Loading
+
+    private func load(userID: String,
+                      url: URL,
+                      diameter: CGFloat,
+                      completion: @escaping (String) -> Void,
+                      cachedData: () -> Data?) {
+        if self.pendingCompletions[userID] != nil {
+            self.pendingCompletions[userID]!.append(completion)
+            return
+        }
+        self.pendingCompletions[userID] = [completion]
+
+        let decodeAndStore = { (data: Data?) in
+            guard let data = data else {
+                self.pendingCompletions.removeValue(forKey: userID)
+                return
+            }
+
+            let maxPixelSize = diameter * self.scale
+            self.decodeQueue.async {
+                let image = SKYChatAvatarImageCache.decode(data: data,
+                                                           maxPixelSize: maxPixelSize,
+                                                           scale: self.scale)
+                DispatchQueue.main.async {
+                    let completions = self.pendingCompletions.removeValue(forKey: userID) ?? []
+                    guard let decoded = image else {
+                        return
+                    }
+
+                    self.store.setObject(Entry(source: url.absoluteString, image: decoded),
+                                         forKey: userID as NSString)
+                    completions.forEach { $0(userID) }
+                }
+            }
+        }
+
+        if let data = cachedData() {
+            decodeAndStore(data)
+            return
+        }
+
+        _ = self.downloadDispatcher.download(url.absoluteString, compltion: decodeAndStore)
+    }
+
+    /**
+     Decodes the image data downsampled so that its longer side fits the specified number of
+     pixels, without decoding the full size bitmap.
+     */
+    static func decode(data: Data, maxPixelSize: CGFloat, scale: CGFloat) -> UIImage? {
+        let sourceOptions = [kCGImageSourceShouldCache: false] as CFDictionary
+        guard let source = CGImageSourceCreateWithData(data as CFData, sourceOptions) else {
+            return nil
+        }
+
+        let thumbnailOptions = [
+            kCGImageSourceCreateThumbnailFromImageAlways: true,
+            kCGImageSourceShouldCacheImmediately: true,
+            kCGImageSourceCreateThumbnailWithTransform: true,
+            kCGImageSourceThumbnailMaxPixelSize: max(1, maxPixelSize)
+        ] as CFDictionary
+        guard let cgImage = CGImageSourceCreateThumbnailAtIndex(source, 0, thumbnailOptions) else {
+            return nil
+        }
+
+        return UIImage(cgImage: cgImage, scale: scale, orientation: .up)
+    }
+}
@@ -0,0 +1,248 @@
+//
+//  SKYChatAvatarRenderer.swift
+//  SKYKitChat
+//
+//  Copyright 2016 Oursky Ltd.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+import UIKit
+
+/**
+ SKYChatAvatarRenderer renders generated avatars and keeps the decoded images in memory, so
+ that an avatar of the same initials, colours, size and scale is rendered only once.
+
+ Circular variants are cached separately, so that an image is cropped only once.
+ */
+@objcMembers
+public class SKYChatAvatarRenderer: NSObject {
+
+    private static var sharedInstance: SKYChatAvatarRenderer?
+
+    static func shared() -> SKYChatAvatarRenderer {
+        if self.sharedInstance == nil {
+            self.sharedInstance = SKYChatAvatarRenderer(scale: UIScreen.main.scale)
+        }
+
+        return self.sharedInstance!
+    }
+
+    let scale: CGFloat
+    let store = NSCache<NSString, UIImage>()
+    let renderQueue = DispatchQueue(label: "io.skygear.chat.avatar-render", qos: .userInitiated)
+
+    public init(scale: CGFloat) {
+        self.scale = scale
+        super.init()
+        self.store.countLimit = 300
+    }
+
+    // MARK: - Initials Avatars
+
+    /**
+     Returns the avatar from cache, or renders it on the calling thread.
+     */
+    public func avatarImage(forInitialsOfName name: String,
+                            gradientColors colors: [UIColor],
+                            textColor: UIColor,
+                            size: CGSize,
+                            circular: Bool) -> UIImage? {
+        let initials = SKYChatAvatarRenderer.initials(of: name)
+        let key = self.cacheKey(initials: initials,
+                                colors: colors,
+                                textColor: textColor,
+                                size: size,
+                                circular: circular)
+        if let image = self.store.object(forKey: key) {
+            return image
+        }
+
+        guard let image = self.render(initials: initials,
+                                      gradientColors: colors,
+                                      textColor: textColor,
+                                      size: size,
+                                      circular: circular) else {
+            return nil
+        }
+
+        self.store.setObject(image, forKey: key)
+        return image
+    }
+
+    /**
+     Returns the avatar if it is cached, otherwise returns nil and renders it in background,
+     calling the completion on main thread when done.
+     */
+    public func cachedAvatarImage(forInitialsOfName name: String,
+                                  gradientColors colors: [UIColor],
+                                  textColor: UIColor,
+                                  size: CGSize,
+                                  circular: Bool,
+                                  completion: @escaping (UIImage?) -> Void) -> UIImage? {
+        let key = self.cacheKey(initials: SKYChatAvatarRenderer.initials(of: name),
+                                colors: colors,
+                                textColor: textColor,
+                                size: size,
+                                circular: circular)
+        if let image = self.store.object(forKey: key) {
+            return image
+        }
+
+        self.renderQueue.async {
+            let image = self.avatarImage(forInitialsOfName: name,
+                                         gradientColors: colors,
+                                         textColor: textColor,
+                                         size: size,
+                                         circular: circular)
+            DispatchQueue.main.async {
+                completion(image)
+            }
+        }
+        return nil
+    }
+
+    // MARK: - Placeholders and Circular Images
+
+    public func placeholderImage(size: CGSize, circular: Bool) -> UIImage? {
+        let key = "placeholder|\(size.width)x\(size.height)@\(self.scale)|\(circular)" as NSString
+        if let image = self.store.object(forKey: key) {
+            return image
+        }
+
+        let color = UIImage.getAvatarPlaceholderImageColor()
+        let image = self.draw(size: size, circular: circular) { _ in
+            color.setFill()
+            UIRectFill(CGRect(origin: CGPoint.zero, size: size))
+        }
+
+        if let image = image {
+            self.store.setObject(image, forKey: key)
+        }
+        return image
+    }
+
+    /**
+     Returns the circular variant of an image, cropping it only the first time it is requested
+     with the specified key, such as the URL the image is downloaded from.
+     */
+    public func circularImage(from image: UIImage, key: String) -> UIImage? {
+        let cacheKey = "circle|\(key)|\(image.size.width)x\(image.size.height)" as NSString
+        if let circular = self.store.object(forKey: cacheKey) {
+            return circular
+        }
+
+        guard let circular = self.draw(size: image.size, circular: true, actions: { _ in
+            image.draw(in: CGRect(origin: CGPoint.zero, size: image.size))
+        }) else {
+            return nil
+        }
+
+        self.store.setObject(circular, forKey: cacheKey)
+        return circular
+    }
+
+    public func purgeAll() {
+        self.store.removeAllObjects()
+    }
+
+    // MARK: - Rendering
+
+    static func initials(of name: String) -> String {
+        // maximum render 2 initials
+        return name.initials.prefix(2).joined()
+    }
+
+    func cacheKey(initials: String,
+                  colors: [UIColor],
+                  textColor: UIColor,
+                  size: CGSize,
+                  circular: Bool) -> NSString {
+        let colorsKey = colors.map { self.colorKey($0) }.joined(separator: ",")
+        return ("initials|\(initials)|\(colorsKey)|\(self.colorKey(textColor))|" +
+            "\(size.width)x\(size.height)@\(self.scale)|\(circular)") as NSString
+    }
+
+    func colorKey(_ color: UIColor) -> String {
+        var red: CGFloat = 0, green: CGFloat = 0, blue: CGFloat = 0, alpha: CGFloat = 0
+        if color.getRed(&red, green: &green, blue: &blue, alpha: &alpha) {
+            return String(format: "%.3f %.3f %.3f %.3f", red, green, blue, alpha)
+        }
+
+        return color.description
+    }
+
+    func render(initials: String,
+                gradientColors colors: [UIColor],
+                textColor: UIColor,
+                size: CGSize,
+                circular: Bool) -> UIImage? {
+        let aString = NSAttributedString(string: initials, attributes: [
+            NSAttributedStringKey.foregroundColor: textColor,
+            NSAttributedStringKey.font: UIFont.boldSystemFont(ofSize: 34)
+        ])
+
+        return self.draw(size: size, circular: circular) { ctx in
+            // drawn with Core Graphics rather than CAGradientLayer, so it is safe off main thread
+            let cgColors = colors.map { $0.cgColor } as CFArray
+            if let gradient = CGGradient(colorsSpace: CGColorSpaceCreateDeviceRGB(),
+                                         colors: cgColors,
+                                         locations: nil) {
+                ctx.drawLinearGradient(gradient,
+                                       start: CGPoint.zero,
+                                       end: CGPoint(x: size.width, y: size.height),
+                                       options: [])
+            }
+
+            let fontRenderSize = aString.boundingRect(with: size,
+                                                      options: [.usesLineFragmentOrigin,
+                                                                .usesFontLeading],
+                                                      context: nil).size
+            aString.draw(at: CGPoint(x: (size.width - fontRenderSize.width) / 2,
+                                     y: (size.height - fontRenderSize.height) / 2))
+        }
+    }
+
+    func draw(size: CGSize,
+              circular: Bool,
+              actions: @escaping (CGContext) -> Void) -> UIImage? {
+        let rect = CGRect(origin: CGPoint.zero, size: size)
+        let drawActions = { (ctx: CGContext) in
+            if circular {
+                ctx.addEllipse(in: rect)
+                ctx.clip()
+            }
+            actions(ctx)
+        }
+
+        if #available(iOS 10.0, *) {
+            let format = UIGraphicsImageRendererFormat()
+            format.scale = self.scale
+            format.opaque = !circular
+            return UIGraphicsImageRenderer(size: size, format: format).image { rendererContext in
+                drawActions(rendererContext.cgContext)
+            }
+        }
+
+        UIGraphicsBeginImageContextWithOptions(size, !circular, self.scale)
+        defer {
+            UIGraphicsEndImageContext()
+        }
+
+        guard let ctx = UIGraphicsGetCurrentContext() else {
+            return nil
+        }
+        drawActions(ctx)
+        return UIGraphicsGetImageFromCurrentImageContext()
+    }
+}
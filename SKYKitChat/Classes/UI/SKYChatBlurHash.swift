@@ -0,0 +1,261 @@
+//
+//  SKYChatBlurHash.swift
+//  SKYKitChat
+//
+//  Copyright 2016 Oursky Ltd.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+import UIKit
+
+private let base83Characters: [Character] =
+    Array("0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz#$%*+,-.:;=?@[]^_{|}~")
+
+private let base83Values: [Character: Int] = {
+    var values = [Character: Int]()
+    for (index, character) in base83Characters.enumerated() {
+        values[character] = index
+    }
+    return values
+}()
+
+// Images are sampled at this size when encoding, which is enough for the few components kept.
+private let encodeSampleSize = 32
+
+/**
+ SKYChatBlurHash encodes an image into a compact BlurHash string of a few dozen characters,
+ and decodes the string into a blurred placeholder image.
+
+ See https://blurha.sh for the format.
+ */
+@objcMembers
+public class SKYChatBlurHash: NSObject {
+
+    // MARK: - Encoding
+
+    public static func encode(image: UIImage,
+                              componentsX: Int = 4,
+                              componentsY: Int = 3) -> String? {
+        guard (1...9).contains(componentsX), (1...9).contains(componentsY),
+            let cgImage = image.cgImage else {
+            return nil
+        }
+
+        let width = encodeSampleSize
+        let height = encodeSampleSize
+        let bytesPerRow = width * 4
+        var pixels = [UInt8](repeating: 0, count: bytesPerRow * height)
+        let drawn: Bool = pixels.withUnsafeMutableBytes { buffer in
+            guard let context = CGContext(data: buffer.baseAddress,
+                                          width: width,
+                                          height: height,
+                                          bitsPerComponent: 8,
+                                          bytesPerRow: bytesPerRow,
+                                          space: CGColorSpaceCreateDeviceRGB(),
+                                          bitmapInfo: CGImageAlphaInfo.noneSkipLast.rawValue) else {
+                return false
+            }
+            context.interpolationQuality = .medium
+            context.draw(cgImage, in: CGRect(x: 0, y: 0, width: width, height: height))
+            return true
+        }
+        guard drawn else {
+            return nil
+        }
+
+        var factors = [(Float, Float, Float)]()
+        for j in 0..<componentsY {
+            for i in 0..<componentsX {
+                let normalisation: Float = (i == 0 && j == 0) ? 1 : 2
+                var r: Float = 0, g: Float = 0, b: Float = 0
+                for y in 0..<height {
+                    let basisY = cos(Float.pi * Float(j) * Float(y) / Float(height))
+                    for x in 0..<width {
+                        let basis = normalisation * basisY
+                            * cos(Float.pi * Float(i) * Float(x) / Float(width))
+                        let offset = y * bytesPerRow + x * 4
+                        r += basis * sRGBToLinear(pixels[offset])
+                        g += basis * sRGBToLinear(pixels[offset + 1])
+                        b += basis * sRGBToLinear(pixels[offset + 2])
+                    }
+                }
+                let scale = 1 / Float(width * height)
+                factors.append((r * scale, g * scale, b * scale))
+            }
+        }
+
+        let dc = factors[0]
+        let ac = factors.dropFirst()
+
+        var hash = encode83((componentsX - 1) + (componentsY - 1) * 9, length: 1)
+
+        var maximumValue: Float = 1
+        if ac.isEmpty {
+            hash += encode83(0, length: 1)
+        } else {
+            let actualMaximumValue = ac.map { max(abs($0.0), abs($0.1), abs($0.2)) }.max()!
+            let quantisedMaximumValue =
+                Int(max(0, min(82, floor(actualMaximumValue * 166 - 0.5))))
+            maximumValue = Float(quantisedMaximumValue + 1) / 166
+            hash += encode83(quantisedMaximumValue, length: 1)
+        }
+
+        let dcValue = (linearToSRGB(dc.0) << 16) + (linearToSRGB(dc.1) << 8) + linearToSRGB(dc.2)
+        hash += encode83(dcValue, length: 4)
+
+        for factor in ac {
+            let quantise = { (value: Float) -> Int in
+                return Int(max(0, min(18, floor(signPow(value / maximumValue, 0.5) * 9 + 9.5))))
+            }
+            let acValue =
+                quantise(factor.0) * 19 * 19 + quantise(factor.1) * 19 + quantise(factor.2)
+            hash += encode83(acValue, length: 2)
+        }
+
+        return hash
+    }
+
+    // MARK: - Decoding
+
+    /**
+     Decodes a BlurHash into an image of the specified size in pixels. A small size such as
+     32 × 32 is enough, since the image is blurred and can be scaled up by the image view.
+     */
+    public static func decode(_ hash: String, size: CGSize) -> UIImage? {
+        let characters = Array(hash)
+        guard characters.count >= 6,
+            let sizeFlag = decode83(characters[0..<1]),
+            let quantisedMaximumValue = decode83(characters[1..<2]) else {
+            return nil
+        }
+
+        let componentsY = sizeFlag / 9 + 1
+        let componentsX = sizeFlag % 9 + 1
+        guard characters.count == 4 + 2 * componentsX * componentsY else {
+            return nil
+        }
+
+        let maximumValue = Float(quantisedMaximumValue + 1) / 166
+        var colors = [(Float, Float, Float)]()
+        for index in 0..<(componentsX * componentsY) {
+            if index == 0 {
+                guard let value = decode83(characters[2..<6]) else {
+                    return nil
+                }
+                colors.append((sRGBToLinear(UInt8((value >> 16) & 255)),
+                               sRGBToLinear(UInt8((value >> 8) & 255)),
+                               sRGBToLinear(UInt8(value & 255))))
+            } else {
+                guard let value = decode83(characters[(4 + index * 2)..<(6 + index * 2)]) else {
+                    return nil
+                }
+                let unquantise = { (quantised: Int) -> Float in
+                    return signPow((Float(quantised) - 9) / 9, 2) * maximumValue
+                }
+                colors.append((unquantise(value / (19 * 19)),
+                               unquantise((value / 19) % 19),
+                               unquantise(value % 19)))
+            }
+        }
+
+        let width = max(1, Int(size.width))
+        let height = max(1, Int(size.height))
+        let bytesPerRow = width * 4
+        var pixels = [UInt8](repeating: 255, count: bytesPerRow * height)
+        for y in 0..<height {
+            for x in 0..<width {
+                var r: Float = 0, g: Float = 0, b: Float = 0
+                for j in 0..<componentsY {
+                    let basisY = cos(Float.pi * Float(y) * Float(j) / Float(height))
+                    for i in 0..<componentsX {
+                        let basis = cos(Float.pi * Float(x) * Float(i) / Float(width)) * basisY
+                        let color = colors[i + j * componentsX]
+                        r += color.0 * basis
+                        g += color.1 * basis
+                        b += color.2 * basis
+                    }
+                }
+                let offset = y * bytesPerRow + x * 4
+                pixels[offset] = UInt8(linearToSRGB(r))
+                pixels[offset + 1] = UInt8(linearToSRGB(g))
+                pixels[offset + 2] = UInt8(linearToSRGB(b))
+            }
+        }
+
+        let data = Data(pixels) as CFData
+        guard let provider = CGDataProvider(data: data),
+            let cgImage = CGImage(width: width,
+                                  height: height,
+                                  bitsPerComponent: 8,
+                                  bitsPerPixel: 32,
+                                  bytesPerRow: bytesPerRow,
+                                  space: CGColorSpaceCreateDeviceRGB(),
+                                  bitmapInfo: CGBitmapInfo(
+                                      rawValue: CGImageAlphaInfo.noneSkipLast.rawValue),
+                                  provider: provider,
+                                  decode: nil,
+                                  shouldInterpolate: true,
+                                  intent: .defaultIntent) else {
+            return nil
+        }
+
+        return UIImage(cgImage: cgImage)
+    }
+
+    // MARK: - Helpers
+
+    private static func encode83(_ value: Int, length: Int) -> String {
+        var result = ""
+        var divisor = 1
+        for _ in 1..<max(1, length) {
+            divisor *= 83
+        }
+        for _ in 0..<length {
+            result.append(base83Characters[(value / divisor) % 83])
+            divisor /= 83
+        }
+        return result
+    }
+
+    private static func decode83(_ characters: ArraySlice<Character>) -> Int? {
+        var value = 0
+        for character in characters {
+            guard let digit = base83Values[character] else {
+                return nil
+            }
+            value = value * 83 + digit
+        }
+        return value
+    }
+
+    private static func sRGBToLinear(_ value: UInt8) -> Float {
+        let v = Float(value) / 255
+        if v <= 0.04045 {
+            return v / 12.92
+        }
+        return pow((v + 0.055) / 1.055, 2.4)
+    }
+
+    private static func linearToSRGB(_ value: Float) -> Int {
+        let v = max(0, min(1, value))
+        if v <= 0.0031308 {
+            return Int(v * 12.92 * 255 + 0.5)
+        }
+        return Int((1.055 * pow(v, 1 / 2.4) - 0.055) * 255 + 0.5)
+    }
+
+    private static func signPow(_ value: Float, _ exponent: Float) -> Float {
+        return copysign(pow(abs(value), exponent), value)
+    }
+}
@@ -0,0 +1,144 @@
+//
+//  SKYChatThumbnailCache.swift
+//  SKYKitChat
+//
+//  Copyright 2016 Oursky Ltd.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+import UIKit
+
+let SKYMessageMetadataBlurHashAttributeName = "blurhash"
+
+// BlurHash placeholders are blurred anyway, so they are decoded at a small size and scaled up.
+private let blurHashDecodeSize = CGSize(width: 32, height: 32)
+
+/**
+ SKYChatThumbnailCache decodes image message thumbnails on a background queue and keeps the
+ decoded results in memory, keyed by message ID.
+
+ A thumbnail is read from the base64 `thumbnail` metadata of the message, or from the
+ `blurhash` metadata when the message carries a BlurHash placeholder instead.
+ */
+@objcMembers
+public class SKYChatThumbnailCache: NSObject {
+
+    private static var sharedInstance: SKYChatThumbnailCache?
+
+    static func shared() -> SKYChatThumbnailCache {
+        if self.sharedInstance == nil {
+            self.sharedInstance = SKYChatThumbnailCache()
+        }
+
+        return self.sharedInstance!
+    }
+
+    let store = NSCache<NSString, UIImage>()
+    let decodeQueue = DispatchQueue(label: "io.skygear.chat.thumbnail-decode",
+                                    qos: .userInitiated)
+
+    // Completion handlers of decodes in progress, accessed on main thread only.
+    private var pendingCompletions = [String: [(UIImage?) -> Void]]()
+
+    public init(countLimit: Int) {
+        super.init()
+        self.store.countLimit = countLimit
+    }
+
+    public convenience override init() {
+        self.init(countLimit: 200)
+    }
+
+    // MARK: - Thumbnails
+
+    public func cachedThumbnail(forMessageID messageID: String) -> UIImage? {
+        return self.store.object(forKey: messageID as NSString)
+    }
+
+    /**
+     Decodes and pre-renders the thumbnail of the message at the specified size in points.
+
+     The completion is called on main thread, with nil if the message has no thumbnail.
+     Concurrent requests for the same message share a single decode.
+     */
+    public func thumbnail(for message: SKYMessage,
+                          size: CGSize,
+                          completion: @escaping (UIImage?) -> Void) {
+        let messageID = message.recordName
+        if let image = self.cachedThumbnail(forMessageID: messageID) {
+            completion(image)
+            return
+        }
+
+        if self.pendingCompletions[messageID] != nil {
+            self.pendingCompletions[messageID]!.append(completion)
+            return
+        }
+        self.pendingCompletions[messageID] = [completion]
+
+        let metadata = message.metadata ?? [String: Any]()
+        self.decodeQueue.async {
+            let image = SKYChatThumbnailCache.decodeThumbnail(metadata: metadata, size: size)
+            DispatchQueue.main.async {
+                if let image = image {
+                    self.store.setObject(image, forKey: messageID as NSString)
+                }
+
+                let completions = self.pendingCompletions.removeValue(forKey: messageID) ?? []
+                completions.forEach { $0(image) }
+            }
+        }
+    }
+
+    public func purge(messageID: String) {
+        self.store.removeObject(forKey: messageID as NSString)
+    }
+
+    public func purgeAll() {
+        self.store.removeAllObjects()
+    }
+
+    // MARK: - Decoding
+
+    static func decodeThumbnail(metadata: [String: Any], size: CGSize) -> UIImage? {
+        if let thumbnailString = metadata["thumbnail"] as? String,
+            let data = Data(base64Encoded: thumbnailString, options: .ignoreUnknownCharacters),
+            let image = UIImage(data: data) {
+            return self.preRender(image: image, size: size)
+        }
+
+        if let blurHash = metadata[SKYMessageMetadataBlurHashAttributeName] as? String,
+            let image = SKYChatBlurHash.decode(blurHash, size: blurHashDecodeSize) {
+            return self.preRender(image: image, size: size)
+        }
+
+        return nil
+    }
+
+    /**
+     Draws the image into a bitmap of the specified size, so that it is decoded and scaled
+     before it reaches the image view rather than on first draw on main thread.
+     */
+    static func preRender(image: UIImage, size: CGSize) -> UIImage? {
+        guard size.width > 0, size.height > 0 else {
+            return image
+        }
+
+        UIGraphicsBeginImageContextWithOptions(size, false, 0)
+        image.draw(in: CGRect(origin: CGPoint.zero, size: size))
+        let rendered = UIGraphicsGetImageFromCurrentImageContext()
+        UIGraphicsEndImageContext()
+        return rendered
+    }
+}
@@ -32,6 +32,10 @@ let SKYMessageImageThumbnailFormatAttributeName = "SKYMessageImageThumbnailForma
 let SKYMessageImageThumbnailFormatPNG = "PNG"
 let SKYMessageImageThumbnailFormatJPEG = "JPEG"
 
+// Stores a BlurHash placeholder of a few dozen bytes in the `blurhash` metadata instead of a
+// base64 encoded thumbnail. Only applies to the thumbnail format.
+let SKYMessageImageThumbnailFormatBlurHash = "BlurHash"
+
 private let SKYMessageMetadataThumbnailAttributeName = "thumbnail"
 private let SKYMessageMetadataWidthAttributeName = "width"
 private let SKYMessageMetadataHeightAttributeName = "height"
@@ -95,8 +99,11 @@ extension SKYMessage {
         let thumbnailSize = scaleSize(from: image.size, toMax: self.getThumbnailSize(options: options))
         let thumbnailImage = scale(image: image, toSize: thumbnailSize)
 
-        if let ti = thumbnailImage as UIImage? {
-            let format = self.getThumbnailFormat(options: options)
+        let format = self.getThumbnailFormat(options: options)
+        if format == SKYMessageImageThumbnailFormatBlurHash {
+            metadata[SKYMessageMetadataBlurHashAttributeName] =
+                SKYChatBlurHash.encode(image: thumbnailImage ?? image)
+        } else if let ti = thumbnailImage as UIImage? {
             metadata[SKYMessageMetadataThumbnailAttributeName] = SKYMessage.convert(image: ti, format: format, quality: 0.4)?.base64EncodedString()
         }
 
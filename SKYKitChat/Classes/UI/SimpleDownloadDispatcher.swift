@@ -111,7 +111,7 @@ class SimpleDownloadDispatchItem {
 class SimpleDownloadDispatchItemCallback: Equatable {
     static func ==(lhs: SimpleDownloadDispatchItemCallback,
                    rhs: SimpleDownloadDispatchItemCallback) -> Bool {
-        return lhs.id == lhs.id
+        return lhs.id == rhs.id
     }
 
     private let id: Int
@@ -40,18 +40,8 @@ public extension UIImage {
     }
 
     class func avatarPlaceholderImage() -> UIImage? {
-        let color = UIImage.getAvatarPlaceholderImageColor()
-        let size = UIImage.getAvatarDefaultSize()
-
-        UIGraphicsBeginImageContext(size)
-        defer {
-            UIGraphicsEndImageContext()
-        }
-
-        color.setFill()
-        UIRectFill(CGRect(origin: CGPoint(x: 0, y: 0), size: size))
-
-        return UIGraphicsGetImageFromCurrentImageContext()
+        return SKYChatAvatarRenderer.shared().placeholderImage(size: self.getAvatarDefaultSize(),
+                                                               circular: false)
     }
 
     class func avatarImage(forInitialsOfName name: String) -> UIImage? {
@@ -97,24 +87,11 @@ public extension UIImage {
                            gradientColors colors: [UIColor],
                            textColor: UIColor,
                            size: CGSize) -> UIImage? {
-        let nameInitials = name.initials
-        var joinedInitials = ""
-
-        // maximum render 2 initials
-        for idx in 0..<min(2, nameInitials.count) {
-            joinedInitials.append(nameInitials[idx])
-        }
-
-        // convert to NSString in order to get the correct NSRange
-        let str = joinedInitials as NSString
-        let fullRange = NSRange(location: 0, length: str.length)
-
-        let aString = NSMutableAttributedString(string: joinedInitials)
-        aString.setAttributes([
-            NSAttributedStringKey.foregroundColor: textColor,
-            NSAttributedStringKey.font: UIFont.boldSystemFont(ofSize: 34)
-            ], range: fullRange)
-        return UIImage.avatarImage(forAttributedString: aString, gradientColors: colors, size: size)
+        return SKYChatAvatarRenderer.shared().avatarImage(forInitialsOfName: name,
+                                                          gradientColors: colors,
+                                                          textColor: textColor,
+                                                          size: size,
+                                                          circular: false)
     }
 
     class func avatarImage(forAttributedString aString: NSAttributedString,
@@ -2,10 +2,10 @@
 if [ "$1" == "fix" ]
 then
     echo "Fixing Clang Format..."
-    find ./SKYKitChat ./Example/Tests -name "*.[hm]" -exec clang-format -i -style=file "{}" \;
+    find ./SKYKitChat ./Example/Tests ./Example/UITests ./Example/PerformanceTests -name "*.[hm]" -exec clang-format -i -style=file "{}" \;
 else
     echo "Checking Clang Format..."
-    find ./SKYKitChat ./Example/Tests -name "*.[hm]" -exec clang-format -style=file -output-replacements-xml "{}" \; | grep "<replacement " >/dev/null
+    find ./SKYKitChat ./Example/Tests ./Example/UITests ./Example/PerformanceTests -name "*.[hm]" -exec clang-format -style=file -output-replacements-xml "{}" \; | grep "<replacement " >/dev/null
     if [ $? -ne 1 ]
     then
         echo "Commit did not match clang-format"